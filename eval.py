@@ -4,7 +4,9 @@ import pandas as pd
 from matplotlib import pyplot as plt
 import numpy as np
 import seaborn as sns
-import sys
+import sys, os
+
+from ntt_trace import read_trace_csv, read_columnar, read_queue_changes, read_delay_histograms, histogram_quantiles
 
 import matplotlib.pyplot as plt
 import matplotlib as mpl
@@ -33,16 +35,22 @@ val = sys.argv[1]
 # })
 
 if not TEST:
-    frame = pd.read_csv("results/small_test_no_disturbance_with_message_ids{}.csv".format(val))
+    basename = "results/small_test_no_disturbance_with_message_ids{}".format(val)
 else:
     if not BIG:
-        frame = pd.read_csv("results/small_test_one_disturbance_with_message_ids{}.csv".format(val))
+        basename = "results/small_test_one_disturbance_with_message_ids{}".format(val)
     else:
-        frame = pd.read_csv("results/large_test_disturbance_with_message_ids{}.csv".format(val))
-
-# Get the time stamp, packet size and delay (from my format, Alex uses a different format)
-frame = frame[frame.columns[[1,7,-8]]]
-frame.columns = ["t", "size", "delay"]
+        basename = "results/large_test_disturbance_with_message_ids{}".format(val)
+
+if os.path.exists(basename + ".ntc"):
+    # Columnar trace (--traceformat=columnar), only read the needed columns
+    frame = read_columnar(basename + ".ntc", ["timestamp", "size", "delay"])
+    frame.columns = ["t", "size", "delay"]
+    frame["t"] = frame["t"] / 1e9
+    frame["delay"] = frame["delay"] / 1e9
+else:
+    frame = read_trace_csv(basename + ".csv", ["timestamp", "size", "delay"])
+    frame.columns = ["t", "size", "delay"]
 print(frame.head())
 
 frame = (
@@ -66,11 +74,19 @@ sbs.fig.tight_layout()
 plt.savefig("results/delay"+".pdf")
 
 
-frame['delay'].quantile([0.5, 0.99])
+if os.path.exists(basename + "_delay.ntd"):
+    # Delay histograms (--delayhistogram=true), within 1% of the exact quantiles
+    print(histogram_quantiles(read_delay_histograms(basename + "_delay.ntd"), [0.5, 0.99]) / 1e9)
+else:
+    frame['delay'].quantile([0.5, 0.99])
 
 throughput = frame.loc[frame['t'] > 20, 'size'].sum() / 40 / (1024*1024)  # in MBps
 
-queueframe = pd.read_csv("results/queue.csv", names=["source", "time", "size"])
+if os.path.exists("results/queue.ntq"):
+    # Queue changes (--queuechanges=true)
+    queueframe = read_queue_changes("results/queue.ntq")
+else:
+    queueframe = read_trace_csv("results/queue.csv")
 
 bottleneck_source = "/NodeList/0/DeviceList/0/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue"
 bottleneck_queue = queueframe[queueframe["source"] == bottleneck_source]
@@ -131,14 +147,14 @@ for value in values:
     scs.fig.tight_layout()
     plt.savefig(save_name) 
 
-dropframe = pd.read_csv("results/drops.csv", names=["source", "time", "packetsize"])
+dropframe = read_trace_csv("results/drops.csv")
 
 print("Drop fraction:", len(dropframe) / (len(dropframe) + len(frame)))
 
 if BIG:
     ## Plot delay distribution for each receiver
-    new_frame = pd.read_csv("results/large_test_disturbance_with_message_ids{}.csv".format(val))
-    new_frame = new_frame[new_frame.columns[[1,7, 23, -8]]]
+    new_frame = read_trace_csv("results/large_test_disturbance_with_message_ids{}.csv".format(val),
+                               ["timestamp", "size", "destination", "delay"])
     new_frame.columns = ["t", "size", "dest ip", "delay"]
     print(new_frame.head())
 
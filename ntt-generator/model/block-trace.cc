@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "block-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("BlockTrace");
+
+// Fast compression is enough, the records are very repetitive.
+static const int ZSTD_LEVEL = 1;
+
+bool IsZstdAvailable(void)
+{
+#ifdef HAVE_ZSTD
+  return true;
+#else
+  return false;
+#endif
+}
+
+BlockTraceOutput::BlockTraceOutput(std::string filename,
+                                   Ptr<const TraceFormat> format,
+                                   uint32_t blockSize)
+    : m_format(format),
+      m_recordSize(format->GetRecordSize()),
+      m_blockRecords(std::max<uint32_t>(1, blockSize / m_recordSize)),
+      m_codec(IsZstdAvailable() ? TRACE_BLOCK_ZSTD : TRACE_BLOCK_RAW),
+      m_records(0),
+      m_firstTimestamp(0),
+      m_lastTimestamp(0),
+      m_blocks(0)
+{
+  NS_LOG_FUNCTION(this << filename << blockSize);
+  m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open trace file " << filename);
+  if (m_codec == TRACE_BLOCK_RAW)
+  {
+    NS_LOG_WARN("Built without zstd, " << filename << " is not compressed");
+  }
+
+  TraceFileHeader header;
+  MakeTraceFileHeader(*m_format, header);
+  std::memcpy(header.magic, "NTTB", 4);
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  m_block.reserve(m_blockRecords * m_recordSize);
+}
+
+BlockTraceOutput::~BlockTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void BlockTraceOutput::Write(const void *record)
+{
+  NS_ASSERT_MSG(m_file.is_open(), "Write to a closed trace output");
+  const uint8_t *data = static_cast<const uint8_t *>(record);
+  uint64_t timestamp = m_format->GetTimestamp(data);
+  if (m_records == 0)
+  {
+    m_firstTimestamp = timestamp;
+    m_lastTimestamp = timestamp;
+  }
+  m_firstTimestamp = std::min(m_firstTimestamp, timestamp);
+  m_lastTimestamp = std::max(m_lastTimestamp, timestamp);
+  TraceFlow flow;
+  if (m_format->GetFlow(data, flow))
+  {
+    m_flows.insert(flow);
+  }
+  m_block.insert(m_block.end(), data, data + m_recordSize);
+  if (++m_records == m_blockRecords)
+  {
+    FlushBlock();
+  }
+}
+
+void BlockTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (!m_file.is_open())
+  {
+    return;
+  }
+  if (m_records > 0)
+  {
+    FlushBlock();
+  }
+  TraceBlockFooter footer;
+  footer.indexOffset = m_file.tellp();
+  footer.blocks = m_blocks;
+  std::memcpy(footer.magic, "NTTI", 4);
+  m_file.write(reinterpret_cast<const char *>(m_index.data()), m_index.size());
+  m_file.write(reinterpret_cast<const char *>(&footer), sizeof(footer));
+  m_file.close();
+}
+
+void BlockTraceOutput::FlushBlock(void)
+{
+  TraceBlockEntry entry;
+  entry.offset = m_file.tellp();
+  entry.rawSize = m_block.size();
+  entry.records = m_records;
+  entry.flows = m_flows.size();
+  entry.firstTimestamp = m_firstTimestamp;
+  entry.lastTimestamp = m_lastTimestamp;
+  entry.codec = m_codec;
+
+  const uint8_t *stored = m_block.data();
+  entry.storedSize = m_block.size();
+#ifdef HAVE_ZSTD
+  if (m_codec == TRACE_BLOCK_ZSTD)
+  {
+    m_compressed.resize(ZSTD_compressBound(m_block.size()));
+    size_t size = ZSTD_compress(m_compressed.data(), m_compressed.size(),
+                                m_block.data(), m_block.size(), ZSTD_LEVEL);
+    NS_ABORT_MSG_IF(ZSTD_isError(size), "zstd: " << ZSTD_getErrorName(size));
+    stored = m_compressed.data();
+    entry.storedSize = size;
+  }
+#endif
+  m_file.write(reinterpret_cast<const char *>(stored), entry.storedSize);
+
+  const uint8_t *e = reinterpret_cast<const uint8_t *>(&entry);
+  m_index.insert(m_index.end(), e, e + sizeof(entry));
+  for (const TraceFlow &flow : m_flows)
+  {
+    const uint8_t *f = reinterpret_cast<const uint8_t *>(&flow);
+    m_index.insert(m_index.end(), f, f + sizeof(flow));
+  }
+  ++m_blocks;
+
+  m_block.clear();
+  m_flows.clear();
+  m_records = 0;
+}
+
+BlockTraceReader::BlockTraceReader(std::string filename)
+    : m_filename(filename)
+{
+  m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open " << filename);
+
+  TraceFileHeader header;
+  m_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  header.format[sizeof(header.format) - 1] = '\0';
+  NS_ABORT_MSG_UNLESS(m_file && std::memcmp(header.magic, "NTTB", 4) == 0 &&
+                          header.version == TRACE_FILE_VERSION,
+                      filename << " is not a block trace file of this version");
+  m_format = CreateTraceFormat(header.format);
+  NS_ABORT_MSG_UNLESS(m_format && m_format->GetRecordSize() == header.recordSize,
+                      "Unknown record format " << header.format);
+
+  TraceBlockFooter footer;
+  m_file.seekg(-static_cast<std::streamoff>(sizeof(footer)), std::ios::end);
+  m_file.read(reinterpret_cast<char *>(&footer), sizeof(footer));
+  NS_ABORT_MSG_UNLESS(m_file && std::memcmp(footer.magic, "NTTI", 4) == 0,
+                      filename << " has no index, it was not closed");
+
+  m_file.seekg(footer.indexOffset);
+  m_blocks.resize(footer.blocks);
+  for (Block &block : m_blocks)
+  {
+    m_file.read(reinterpret_cast<char *>(&block.entry), sizeof(block.entry));
+    block.flows.resize(block.entry.flows);
+    m_file.read(reinterpret_cast<char *>(block.flows.data()),
+                block.flows.size() * sizeof(TraceFlow));
+  }
+  NS_ABORT_MSG_UNLESS(m_file, "Truncated index in " << filename);
+}
+
+Ptr<TraceFormat> BlockTraceReader::GetFormat(void) const
+{
+  return m_format;
+}
+
+uint32_t BlockTraceReader::GetNBlocks(void) const
+{
+  return m_blocks.size();
+}
+
+const BlockTraceReader::Block &BlockTraceReader::GetBlock(uint32_t i) const
+{
+  return m_blocks.at(i);
+}
+
+std::vector<uint32_t> BlockTraceReader::FindBlocks(uint64_t start, uint64_t end) const
+{
+  std::vector<uint32_t> found;
+  for (uint32_t i = 0; i < m_blocks.size(); ++i)
+  {
+    const TraceBlockEntry &entry = m_blocks[i].entry;
+    if (entry.firstTimestamp <= end && entry.lastTimestamp >= start)
+    {
+      found.push_back(i);
+    }
+  }
+  return found;
+}
+
+std::vector<uint32_t> BlockTraceReader::FindBlocks(const TraceFlow &flow) const
+{
+  std::vector<uint32_t> found;
+  for (uint32_t i = 0; i < m_blocks.size(); ++i)
+  {
+    const std::vector<TraceFlow> &flows = m_blocks[i].flows;
+    if (std::binary_search(flows.begin(), flows.end(), flow))
+    {
+      found.push_back(i);
+    }
+  }
+  return found;
+}
+
+void BlockTraceReader::ReadBlock(uint32_t i, std::vector<uint8_t> &records)
+{
+  const TraceBlockEntry &entry = m_blocks.at(i).entry;
+  std::vector<uint8_t> stored(entry.storedSize);
+  m_file.clear();
+  m_file.seekg(entry.offset);
+  m_file.read(reinterpret_cast<char *>(stored.data()), stored.size());
+  NS_ABORT_MSG_UNLESS(m_file, "Truncated block " << i << " in " << m_filename);
+
+  if (entry.codec == TRACE_BLOCK_RAW)
+  {
+    records.swap(stored);
+    return;
+  }
+  NS_ABORT_MSG_UNLESS(entry.codec == TRACE_BLOCK_ZSTD,
+                      "Unknown codec " << (uint16_t)entry.codec);
+#ifdef HAVE_ZSTD
+  records.resize(entry.rawSize);
+  size_t size = ZSTD_decompress(records.data(), records.size(),
+                                stored.data(), stored.size());
+  NS_ABORT_MSG_IF(ZSTD_isError(size), "zstd: " << ZSTD_getErrorName(size));
+  NS_ABORT_MSG_UNLESS(size == entry.rawSize, "Corrupt block " << i);
+#else
+  NS_FATAL_ERROR(m_filename << " is compressed, but zstd is not available");
+#endif
+}
+
+} // namespace ns3
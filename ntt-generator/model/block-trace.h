@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Block-compressed trace files with an index of the time range and flows
+// of every block.
+//
+// Layout: TraceFileHeader with magic "NTTB", the compressed blocks, the
+// index (one TraceBlockEntry followed by its TraceFlows per block) and a
+// TraceBlockFooter at the very end of the file.
+
+#ifndef BLOCK_TRACE_H
+#define BLOCK_TRACE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/// How the records of a block are stored.
+enum TraceBlockCodec
+{
+  TRACE_BLOCK_RAW = 0, //!< Not compressed
+  TRACE_BLOCK_ZSTD = 1 //!< Compressed with zstd
+};
+
+#pragma pack(push, 1)
+/**
+ * \brief Index entry of one block.
+ */
+struct TraceBlockEntry
+{
+  uint64_t offset;         //!< File offset of the block
+  uint32_t storedSize;     //!< Size of the block in the file
+  uint32_t rawSize;        //!< Size of the records in the block
+  uint32_t records;        //!< Number of records
+  uint32_t flows;          //!< Number of TraceFlows following the entry
+  uint64_t firstTimestamp; //!< Smallest record time, in nanoseconds
+  uint64_t lastTimestamp;  //!< Largest record time, in nanoseconds
+  uint8_t codec;           //!< TraceBlockCodec of the block
+};
+
+/**
+ * \brief Last bytes of a block trace file.
+ */
+struct TraceBlockFooter
+{
+  uint64_t indexOffset; //!< File offset of the first TraceBlockEntry
+  uint32_t blocks;      //!< Number of blocks
+  char magic[4];        //!< "NTTI"
+};
+#pragma pack(pop)
+
+/**
+ * \return true if zstd compression was available at build time
+ */
+bool IsZstdAvailable(void);
+
+/**
+ * \brief Trace output writing independently compressed blocks of records.
+ *
+ * Records are collected until a block is full, then the block is
+ * compressed and written, and its time range and flows are added to the
+ * index written by Close(). Any block can be decompressed on its own.
+ */
+class BlockTraceOutput : public TraceOutput
+{
+public:
+  /**
+   * \param filename the file to create
+   * \param format the format of the records written to this output
+   * \param blockSize uncompressed size of a block in bytes
+   */
+  BlockTraceOutput(std::string filename, Ptr<const TraceFormat> format,
+                   uint32_t blockSize = 1 << 20);
+  virtual ~BlockTraceOutput();
+
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+private:
+  /// Compress and write the current block.
+  void FlushBlock(void);
+
+  Ptr<const TraceFormat> m_format;   //!< Format of the records
+  uint32_t m_recordSize;             //!< Cached record size
+  uint32_t m_blockRecords;           //!< Records per block
+  TraceBlockCodec m_codec;           //!< Codec for new blocks
+  std::ofstream m_file;              //!< The output file
+  std::vector<uint8_t> m_block;      //!< Records of the current block
+  std::vector<uint8_t> m_compressed; //!< Compression buffer
+  uint32_t m_records;                //!< Records in the current block
+  uint64_t m_firstTimestamp;         //!< Time range of the current block
+  uint64_t m_lastTimestamp;          //!< Time range of the current block
+  std::set<TraceFlow> m_flows;       //!< Flows of the current block
+  std::vector<uint8_t> m_index;      //!< Serialized index of written blocks
+  uint32_t m_blocks;                 //!< Number of written blocks
+};
+
+/**
+ * \brief Reader for files written by BlockTraceOutput.
+ */
+class BlockTraceReader
+{
+public:
+  /// Index of one block.
+  struct Block
+  {
+    TraceBlockEntry entry;        //!< The index entry
+    std::vector<TraceFlow> flows; //!< Sorted flows of the block
+  };
+
+  /**
+   * \brief Open a file and read its index. Aborts if it is not a complete
+   *        block trace file.
+   * \param filename the file to read
+   */
+  BlockTraceReader(std::string filename);
+
+  /**
+   * \return the format of the records
+   */
+  Ptr<TraceFormat> GetFormat(void) const;
+  /**
+   * \return the number of blocks
+   */
+  uint32_t GetNBlocks(void) const;
+  /**
+   * \param i the block index
+   * \return the index of block i
+   */
+  const Block &GetBlock(uint32_t i) const;
+
+  /**
+   * \brief Find the blocks that may hold records in a time range.
+   * \param start first time, in nanoseconds
+   * \param end last time, in nanoseconds
+   * \return the block indices in file order
+   */
+  std::vector<uint32_t> FindBlocks(uint64_t start, uint64_t end) const;
+  /**
+   * \brief Find the blocks that hold records of a flow.
+   * \param flow the flow
+   * \return the block indices in file order
+   */
+  std::vector<uint32_t> FindBlocks(const TraceFlow &flow) const;
+
+  /**
+   * \brief Read and decompress one block.
+   * \param i the block index
+   * \param records filled with the records of the block
+   */
+  void ReadBlock(uint32_t i, std::vector<uint8_t> &records);
+
+private:
+  std::string m_filename;      //!< Name of the file
+  std::ifstream m_file;        //!< The file
+  Ptr<TraceFormat> m_format;   //!< Format of the records
+  std::vector<Block> m_blocks; //!< The index
+};
+
+} // namespace ns3
+
+#endif /* BLOCK_TRACE_H */
@@ -27,6 +27,7 @@
 // Added message tag and counter for MCT data for prediction using the NTT
 
 #include "fstream"
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/address.h"
 #include "ns3/inet-socket-address.h"
@@ -43,6 +44,10 @@
 #include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include "ns3/double.h"
@@ -77,6 +82,34 @@ namespace ns3
                           MakeStringAccessor(&CdfApplication::SetDistribution,
                                              &CdfApplication::GetDistribution),
                           MakeStringChecker())
+            .AddAttribute("CompiledCdfFile",
+                          "Message size distribution file compiled by ntt-cdf-compile, "
+                          "mapped instead of parsed. Replaces CdfFile if set.",
+                          StringValue(""),
+                          MakeStringAccessor(&CdfApplication::SetCompiledDistribution,
+                                             &CdfApplication::GetCompiledDistribution),
+                          MakeStringChecker())
+            .AddAttribute("BatchSize",
+                          "Draw this many message sizes and gaps at once, 0 to draw "
+                          "them one by one. The drawn values are the same either way.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&CdfApplication::m_batchSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("MaxBacklog",
+                          "Messages that wait for send buffer space, including the one "
+                          "being written; newer messages are dropped while it is full. "
+                          "0 for no limit.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&CdfApplication::m_maxBacklog),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("ChunkSize",
+                          "Hand messages to the socket in pieces of at most this many "
+                          "bytes as buffer space frees up, 0 to hand them over whole. "
+                          "On stream sockets, messages larger than the whole send buffer "
+                          "are always written in pieces of its size, as they never fit.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&CdfApplication::m_chunkSize),
+                          MakeUintegerChecker<uint32_t>())
             .AddAttribute("Remote", "The address of the destination",
                           AddressValue(),
                           MakeAddressAccessor(&CdfApplication::m_peer),
@@ -92,7 +125,18 @@ namespace ns3
                             "ns3::Packet::TracedCallback")
             .AddTraceSource("TxWithAddresses", "A new packet is created and is sent",
                             MakeTraceSourceAccessor(&CdfApplication::m_txTraceWithAddresses),
-                            "ns3::Packet::TwoAddressTracedCallback");
+                            "ns3::Packet::TwoAddressTracedCallback")
+            .AddTraceSource("TxMessage", "A new message is tagged and handed to the socket",
+                            MakeTraceSourceAccessor(&CdfApplication::m_txMessageTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("TxMessageWithAddresses",
+                            "A new message is handed to the socket, with the source "
+                            "and peer address",
+                            MakeTraceSourceAccessor(&CdfApplication::m_txMessageTraceWithAddresses),
+                            "ns3::Packet::TwoAddressTracedCallback")
+            .AddTraceSource("TxDrop", "A message is dropped because the backlog is full",
+                            MakeTraceSourceAccessor(&CdfApplication::m_txDropTrace),
+                            "ns3::Packet::TracedCallback");
     return tid;
   }
 
@@ -101,9 +145,19 @@ namespace ns3
         m_connected(false),
         m_lastStartTime(Seconds(0)),
         m_average_size(0),
-        m_sizeDist(CreateObject<EmpiricalRandomVariable>()),
+        m_sizeDist(CreateObject<UniformRandomVariable>()),
         m_timeDist(CreateObject<ExponentialRandomVariable>()),
-        m_counter(0)
+        m_counter(0),
+        m_batchSize(0),
+        m_nextSize(0),
+        m_nextGap(0),
+        m_sentBytes(0),
+        m_maxBacklog(0),
+        m_chunkSize(0),
+        m_sending(false),
+        m_deferred(0),
+        m_dropped(0),
+        m_failed(0)
   {
     NS_LOG_FUNCTION(this);
   }
@@ -126,15 +180,43 @@ namespace ns3
     NS_LOG_FUNCTION(this << stream);
     m_sizeDist->SetStream(stream);
     m_timeDist->SetStream(stream + 1);
+    // Drop the variates of the old streams.
+    m_sizeBatch.clear();
+    m_gapBatch.clear();
     return 2;
   }
 
+  uint64_t
+  CdfApplication::GetDeferred(void) const
+  {
+    return m_deferred;
+  }
+
+  uint64_t
+  CdfApplication::GetDropped(void) const
+  {
+    return m_dropped;
+  }
+
+  uint64_t
+  CdfApplication::GetFailed(void) const
+  {
+    return m_failed;
+  }
+
+  uint32_t
+  CdfApplication::GetBacklog(void) const
+  {
+    return m_backlog.size();
+  }
+
   void CdfApplication::DoDispose(void)
   {
     NS_LOG_FUNCTION(this);
 
     CancelEvents();
     m_socket = 0;
+    m_backlog.clear();
     // chain up
     Application::DoDispose();
   }
@@ -170,6 +252,7 @@ namespace ns3
       m_socket->SetConnectCallback(
           MakeCallback(&CdfApplication::ConnectionSucceeded, this),
           MakeCallback(&CdfApplication::ConnectionFailed, this));
+      m_socket->SetSendCallback(MakeCallback(&CdfApplication::SendAvailable, this));
     }
 
     // Insure no pending event
@@ -188,6 +271,7 @@ namespace ns3
     CancelEvents();
     if (m_socket != 0)
     {
+      m_socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
       m_socket->Close();
     }
     else
@@ -208,7 +292,7 @@ namespace ns3
     NS_LOG_FUNCTION(this);
 
     // Draw waiting time.
-    auto nextTime = Seconds(m_timeDist->GetValue());
+    auto nextTime = NextGap();
     NS_LOG_DEBUG("Wait Time: " << nextTime.GetMilliSeconds() << "ms.");
     m_sendEvent = Simulator::Schedule(nextTime,
                                       &CdfApplication::SendPacket, this);
@@ -219,7 +303,7 @@ namespace ns3
     NS_LOG_FUNCTION(this);
 
     // Draw packet size.
-    auto size = m_sizeDist->GetInteger();
+    auto size = NextSize();
     NS_LOG_DEBUG("Choosen Size: " << size << " Bytes.");
 
     NS_ASSERT(m_sendEvent.IsExpired());
@@ -229,31 +313,164 @@ namespace ns3
     MessageTag m_tag;
     m_tag.SetSimpleValue(m_counter++);
     packet->AddPacketTag(m_tag);
-    m_socket->Send(packet);
-    Address localAddress;
-    m_socket->GetSockName(localAddress);
-    if (InetSocketAddress::IsMatchingType(m_peer))
+
+    // Socket::Send fails if the buffer is full, so messages wait in a
+    // bounded backlog until the send callback reports free space.
+    if (m_maxBacklog > 0 && m_backlog.size() >= m_maxBacklog)
     {
-      NS_LOG_INFO("At time " << Simulator::Now().GetSeconds()
-                             << "s on-off application sent "
-                             << packet->GetSize() << " bytes to "
-                             << InetSocketAddress::ConvertFrom(m_peer).GetIpv4()
-                             << " port " << InetSocketAddress::ConvertFrom(m_peer).GetPort());
-      m_txTraceWithAddresses(packet, localAddress, InetSocketAddress::ConvertFrom(m_peer));
+      NS_LOG_DEBUG("Backlog full, dropping message of " << size << " Bytes.");
+      ++m_dropped;
+      m_txDropTrace(packet);
     }
-    else if (Inet6SocketAddress::IsMatchingType(m_peer))
+    else
     {
-      NS_LOG_INFO("At time " << Simulator::Now().GetSeconds()
-                             << "s on-off application sent "
-                             << packet->GetSize() << " bytes to "
-                             << Inet6SocketAddress::ConvertFrom(m_peer).GetIpv6()
-                             << " port " << Inet6SocketAddress::ConvertFrom(m_peer).GetPort());
-      m_txTraceWithAddresses(packet, localAddress, Inet6SocketAddress::ConvertFrom(m_peer));
+      m_txMessageTrace(packet);
+      m_txMessageTraceWithAddresses(packet, GetSourceAddress(), m_peer);
+      m_backlog.push_back(packet);
+      SendBacklog();
+      if (!m_backlog.empty())
+      {
+        ++m_deferred;
+      }
     }
     m_lastStartTime = Simulator::Now();
     ScheduleNextTx();
   }
 
+  void CdfApplication::SendBacklog()
+  {
+    NS_LOG_FUNCTION(this);
+    // UDP sockets report free space from within Send.
+    if (m_sending)
+    {
+      return;
+    }
+    m_sending = true;
+    while (!m_backlog.empty())
+    {
+      Ptr<Packet> message = m_backlog.front();
+      uint32_t piece = message->GetSize() - m_sentBytes;
+      if (m_chunkSize > 0)
+      {
+        piece = std::min(piece, m_chunkSize);
+      }
+      uint32_t capacity = GetTxCapacity();
+      if (capacity > 0)
+      {
+        piece = std::min(piece, capacity);
+      }
+      uint32_t available = m_socket->GetTxAvailable();
+      if (capacity > 0 && piece > available)
+      {
+        // Whole messages wait for enough space, chunks fill what is free.
+        if (m_chunkSize == 0 || available == 0)
+        {
+          break;
+        }
+        piece = available;
+      }
+      Ptr<Packet> packet = message;
+      if (piece < message->GetSize())
+      {
+        // Fragments keep the tags of the message.
+        packet = message->CreateFragment(m_sentBytes, piece);
+      }
+      if (m_socket->Send(packet) < 0)
+      {
+        NS_LOG_WARN("Send failed with " << piece << " of " << available << " Bytes free.");
+        if (capacity > 0)
+        {
+          break;
+        }
+        // Datagram sockets have no buffer to wait for, like before the
+        // backlog the message is lost.
+        ++m_failed;
+        m_backlog.pop_front();
+        m_sentBytes = 0;
+        continue;
+      }
+      m_sentBytes += piece;
+      if (m_sentBytes < message->GetSize())
+      {
+        continue;
+      }
+      m_backlog.pop_front();
+      m_sentBytes = 0;
+
+      // Traced once per message, when its last byte is handed over.
+      Address localAddress;
+      m_socket->GetSockName(localAddress);
+      if (InetSocketAddress::IsMatchingType(m_peer))
+      {
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds()
+                               << "s on-off application sent "
+                               << message->GetSize() << " bytes to "
+                               << InetSocketAddress::ConvertFrom(m_peer).GetIpv4()
+                               << " port " << InetSocketAddress::ConvertFrom(m_peer).GetPort());
+        m_txTraceWithAddresses(message, localAddress, InetSocketAddress::ConvertFrom(m_peer));
+      }
+      else if (Inet6SocketAddress::IsMatchingType(m_peer))
+      {
+        NS_LOG_INFO("At time " << Simulator::Now().GetSeconds()
+                               << "s on-off application sent "
+                               << message->GetSize() << " bytes to "
+                               << Inet6SocketAddress::ConvertFrom(m_peer).GetIpv6()
+                               << " port " << Inet6SocketAddress::ConvertFrom(m_peer).GetPort());
+        m_txTraceWithAddresses(message, localAddress, Inet6SocketAddress::ConvertFrom(m_peer));
+      }
+    }
+    m_sending = false;
+  }
+
+  uint32_t CdfApplication::NextSize()
+  {
+    NS_ASSERT_MSG(m_sizeTable, "No CdfFile set");
+    if (m_batchSize == 0)
+    {
+      return static_cast<uint32_t>(m_sizeTable->Sample(m_sizeDist->GetValue()));
+    }
+    if (m_nextSize >= m_sizeBatch.size())
+    {
+      // The size stream is only used here, so drawing ahead does not
+      // change which sizes are drawn. Draw the variates first, then map
+      // them to sizes in a loop without calls into the random streams.
+      m_sizeBatch.resize(m_batchSize);
+      std::vector<double> variates(m_batchSize);
+      for (uint32_t i = 0; i < m_batchSize; ++i)
+      {
+        variates[i] = m_sizeDist->GetValue();
+      }
+      const CdfTable &table = *m_sizeTable;
+      for (uint32_t i = 0; i < m_batchSize; ++i)
+      {
+        m_sizeBatch[i] = static_cast<uint32_t>(table.Sample(variates[i]));
+      }
+      m_nextSize = 0;
+    }
+    return m_sizeBatch[m_nextSize++];
+  }
+
+  Time CdfApplication::NextGap()
+  {
+    if (m_batchSize == 0)
+    {
+      return Seconds(m_timeDist->GetValue());
+    }
+    if (m_nextGap >= m_gapBatch.size())
+    {
+      // Gaps of mean 1, scaled by the mean when used, so a new rate
+      // applies to all later gaps: mean * -log(u) is exactly the value
+      // m_timeDist->GetValue() draws.
+      m_gapBatch.resize(m_batchSize);
+      for (uint32_t i = 0; i < m_batchSize; ++i)
+      {
+        m_gapBatch[i] = m_timeDist->GetValue(1.0, 0);
+      }
+      m_nextGap = 0;
+    }
+    return Seconds(m_timeDist->GetMean() * m_gapBatch[m_nextGap++]);
+  }
+
   void CdfApplication::ConnectionSucceeded(Ptr<Socket> socket)
   {
     NS_LOG_FUNCTION(this << socket);
@@ -265,6 +482,53 @@ namespace ns3
     NS_LOG_FUNCTION(this << socket);
   }
 
+  uint32_t CdfApplication::GetTxCapacity() const
+  {
+    // Read at every send, the buffer size may change after the start.
+    UintegerValue size;
+    if (m_socket->GetSocketType() == Socket::NS3_SOCK_STREAM &&
+        m_socket->GetAttributeFailSafe("SndBufSize", size))
+    {
+      return size.Get();
+    }
+    return 0;
+  }
+
+  Address CdfApplication::GetSourceAddress() const
+  {
+    Address localAddress;
+    m_socket->GetSockName(localAddress);
+    if (!InetSocketAddress::IsMatchingType(localAddress) ||
+        !InetSocketAddress::IsMatchingType(m_peer))
+    {
+      return localAddress;
+    }
+    // Datagram sockets stay bound to any address, their packets get the
+    // source address of the route to the peer.
+    InetSocketAddress local = InetSocketAddress::ConvertFrom(localAddress);
+    Ptr<Ipv4> ipv4 = GetNode()->GetObject<Ipv4>();
+    if (local.GetIpv4() != Ipv4Address::GetAny() || !ipv4 || !ipv4->GetRoutingProtocol())
+    {
+      return local;
+    }
+    Ipv4Header header;
+    header.SetDestination(InetSocketAddress::ConvertFrom(m_peer).GetIpv4());
+    Socket::SocketErrno error;
+    Ptr<Ipv4Route> route =
+        ipv4->GetRoutingProtocol()->RouteOutput(Ptr<Packet>(), header, 0, error);
+    if (route)
+    {
+      local.SetIpv4(route->GetSource());
+    }
+    return local;
+  }
+
+  void CdfApplication::SendAvailable(Ptr<Socket> socket, uint32_t available)
+  {
+    NS_LOG_FUNCTION(this << socket << available);
+    SendBacklog();
+  }
+
   /*
 void CdfApplication::LoadDistribution()
 {
@@ -314,33 +578,47 @@ void CdfApplication::LoadDistribution()
   {
     NS_LOG_FUNCTION(this << filename);
     m_filename = filename;
+    // Parsed once per file and shared by all apps.
+    return UseDistribution(CdfTable::Load(m_filename));
+  }
+  std::string CdfApplication::GetDistribution() const { return m_filename; }
 
-    // Reset existing dist, if any.
-    m_sizeDist = CreateObject<EmpiricalRandomVariable>();
-
-    std::ifstream distFile(m_filename);
+  bool CdfApplication::SetCompiledDistribution(std::string filename)
+  {
+    NS_LOG_FUNCTION(this << filename);
+    m_compiledFilename = filename;
+    // Unset by default, which must not replace a CdfFile.
+    if (filename.empty())
+    {
+      return true;
+    }
+    // Mapped once per file and shared by all apps and processes.
+    return UseDistribution(CdfTable::Map(m_compiledFilename));
+  }
+  std::string CdfApplication::GetCompiledDistribution() const { return m_compiledFilename; }
 
-    if (!(distFile >> m_average_size))
+  bool CdfApplication::UseDistribution(Ptr<const CdfTable> table)
+  {
+    NS_LOG_FUNCTION(this << table);
+    // Reset existing dist, if any. A new stream per file keeps the
+    // automatic stream numbers of the earlier per-app distributions.
+    m_sizeDist = CreateObject<UniformRandomVariable>();
+    m_sizeBatch.clear();
+
+    m_sizeTable = table;
+    if (!m_sizeTable)
     {
-      NS_LOG_ERROR("Could not parse file: " << m_filename);
+      NS_LOG_ERROR("Could not load distribution.");
       return false;
     }
+    m_average_size = m_sizeTable->GetAverageSize();
     // Using the average rate, update the time dist.
     UpdateRateDistribution();
 
     NS_LOG_DEBUG("Average size: " << m_average_size << " Bytes.");
     NS_LOG_DEBUG("Average interarrival time: " << m_timeDist->GetMean() << "s.");
-
-    NS_LOG_DEBUG("Loading CDF from file...");
-    double value, probability;
-    while (distFile >> value >> probability)
-    {
-      NS_LOG_DEBUG(value << ", " << probability);
-      m_sizeDist->CDF(value, probability);
-    }
     return true;
   }
-  std::string CdfApplication::GetDistribution() const { return m_filename; }
 
   void CdfApplication::SetRate(DataRate rate)
   {
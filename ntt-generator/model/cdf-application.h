@@ -34,9 +34,14 @@
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
+#include "ns3/packet.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/cdf-table.h"
+
+#include <deque>
+#include <vector>
 
 namespace ns3
 {
@@ -118,6 +123,23 @@ namespace ns3
   */
     int64_t AssignStreams(int64_t stream);
 
+    /**
+  * \return the number of messages that had to wait for send buffer space
+  */
+    uint64_t GetDeferred(void) const;
+    /**
+  * \return the number of messages dropped because the backlog was full
+  */
+    uint64_t GetDropped(void) const;
+    /**
+  * \return the number of messages a datagram socket failed to send
+  */
+    uint64_t GetFailed(void) const;
+    /**
+  * \return the number of messages not yet fully handed to the socket
+  */
+    uint32_t GetBacklog(void) const;
+
   protected:
     virtual void DoDispose(void);
 
@@ -148,14 +170,43 @@ namespace ns3
     
     // cdf files!
     std::string m_filename;
+    std::string m_compiledFilename; // mapped instead of m_filename if set
     double m_average_size; // in bytes!
-    Ptr<EmpiricalRandomVariable> m_sizeDist;
+    Ptr<const CdfTable> m_sizeTable;        // shared by all apps of the file
+    Ptr<UniformRandomVariable> m_sizeDist;  // variates for m_sizeTable
     Ptr<ExponentialRandomVariable> m_timeDist;
     uint32_t m_counter;   // track number of fragments sent
 
+    // Pre-drawn variates, see the BatchSize attribute.
+    uint32_t m_batchSize;              // variates drawn at once, 0 to disable
+    std::vector<uint32_t> m_sizeBatch; // next message sizes
+    std::vector<double> m_gapBatch;    // next gaps of mean 1
+    uint32_t m_nextSize;               // index of the next size
+    uint32_t m_nextGap;                // index of the next gap
+
+    // Messages waiting for send buffer space, see the MaxBacklog attribute.
+    std::deque<Ptr<Packet>> m_backlog; // front is being written
+    uint32_t m_sentBytes;              // bytes of the front already sent
+    uint32_t m_maxBacklog;             // messages in the backlog, 0 for no limit
+    uint32_t m_chunkSize;              // bytes per Send, 0 for whole messages
+    bool m_sending;                    // in SendBacklog, against reentry
+    uint64_t m_deferred;               // messages that had to wait
+    uint64_t m_dropped;                // messages dropped, backlog full
+    uint64_t m_failed;                 // messages the socket refused
+
     /// Traced Callback: transmitted packets.
     TracedCallback<Ptr<const Packet>> m_txTrace;
 
+    /// Traced Callback: messages handed to the socket, with their MessageTag.
+    TracedCallback<Ptr<const Packet>> m_txMessageTrace;
+
+    /// Traced Callback: messages handed to the socket, with the source and peer address.
+    TracedCallback<Ptr<const Packet>, const Address &, const Address &>
+        m_txMessageTraceWithAddresses;
+
+    /// Traced Callback: messages dropped because the backlog was full.
+    TracedCallback<Ptr<const Packet>> m_txDropTrace;
+
     /// Callbacks for tracing the packet Tx events, includes source and destination addresses
     TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_txTraceWithAddresses;
 
@@ -174,16 +225,57 @@ namespace ns3
    * \param socket the not connected socket
    */
     void ConnectionFailed(Ptr<Socket> socket);
+    /**
+   * \brief Handle free space in the send buffer
+   * \param socket the socket
+   * \param available the free bytes
+   */
+    void SendAvailable(Ptr<Socket> socket, uint32_t available);
+    /**
+   * \brief Hand the backlog to the socket as far as its buffer allows
+   */
+    void SendBacklog();
+    /**
+   * \brief Get the size of the whole send buffer of a stream socket
+   * \return the size in bytes, 0 for other sockets
+   */
+    uint32_t GetTxCapacity() const;
+    /**
+   * \brief Get the address of the socket, with the source address of its
+   *        packets if it is bound to any address
+   * \return the address
+   */
+    Address GetSourceAddress() const;
 
     // Accessors for Distribution Attributes
     bool SetDistribution(std::string filename);
     std::string GetDistribution() const;
+    bool SetCompiledDistribution(std::string filename);
+    std::string GetCompiledDistribution() const;
+
+    /**
+   * \brief Draw sizes from a table, helper of both setters above.
+   * \param table the parsed or mapped table, null if loading failed
+   * \return false if the table is null
+   */
+    bool UseDistribution(Ptr<const CdfTable> table);
 
     void SetRate(DataRate rate);
     DataRate GetRate() const;
 
     // Helper to set the rate dist, needs to be called by both setters above.
     void UpdateRateDistribution();
+
+    /**
+   * \brief Draw the next message size, from the batch if enabled.
+   * \return the size in bytes
+   */
+    uint32_t NextSize();
+    /**
+   * \brief Draw the next gap between messages, from the batch if enabled.
+   * \return the gap
+   */
+    Time NextGap();
   };
 
 } // namespace ns3
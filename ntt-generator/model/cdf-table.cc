@@ -0,0 +1,407 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "cdf-table.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("CdfTable");
+
+/// A cached table and the modification time of its file.
+struct CdfCacheEntry
+{
+  int64_t seconds;           //!< Modification time, seconds
+  int64_t nanoSeconds;       //!< Modification time, nanoseconds
+  Ptr<const CdfTable> table; //!< The parsed table
+};
+
+// The process-wide cache, by canonical path.
+static std::map<std::string, CdfCacheEntry> &GetCache(void)
+{
+  static std::map<std::string, CdfCacheEntry> cache;
+  return cache;
+}
+
+// Resolve the canonical path and modification time of a file.
+static bool Resolve(const std::string &filename, std::string &path, struct stat &info)
+{
+  char *resolved = realpath(filename.c_str(), 0);
+  if (!resolved || stat(resolved, &info) != 0)
+  {
+    free(resolved);
+    return false;
+  }
+  path = resolved;
+  free(resolved);
+  return true;
+}
+
+// The cached table of a file, if it did not change since and was loaded
+// the same way.
+static Ptr<const CdfTable> FindCached(const std::string &path, const struct stat &info,
+                                      bool mapped)
+{
+  std::map<std::string, CdfCacheEntry> &cache = GetCache();
+  std::map<std::string, CdfCacheEntry>::iterator it = cache.find(path);
+  if (it != cache.end() && it->second.seconds == info.st_mtim.tv_sec &&
+      it->second.nanoSeconds == info.st_mtim.tv_nsec &&
+      it->second.table->IsMapped() == mapped)
+  {
+    return it->second.table;
+  }
+  return 0;
+}
+
+static void AddCached(const std::string &path, const struct stat &info,
+                      Ptr<const CdfTable> table)
+{
+  CdfCacheEntry &entry = GetCache()[path];
+  entry.seconds = info.st_mtim.tv_sec;
+  entry.nanoSeconds = info.st_mtim.tv_nsec;
+  entry.table = table;
+}
+
+// Byte offsets of the arrays in a compiled file of `points` points; the
+// sizes follow the header.
+static uint64_t CdfsOffset(uint32_t points)
+{
+  return sizeof(CompiledCdfHeader) + points * sizeof(double);
+}
+
+static uint64_t GuideOffset(uint32_t points)
+{
+  return CdfsOffset(points) + points * sizeof(double);
+}
+
+static uint64_t CompiledSize(uint32_t points)
+{
+  return GuideOffset(points) + points * sizeof(uint32_t);
+}
+
+std::string CdfTable::GetCompiledName(std::string filename)
+{
+  std::string::size_type slash = filename.rfind('/');
+  std::string::size_type dot = filename.rfind('.');
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+  {
+    filename = filename.substr(0, dot);
+  }
+  return filename + ".cdfb";
+}
+
+Ptr<const CdfTable> CdfTable::Load(std::string filename)
+{
+  NS_LOG_FUNCTION(filename);
+  std::string path;
+  struct stat info;
+  if (!Resolve(filename, path, info))
+  {
+    NS_LOG_ERROR("Could not open file: " << filename);
+    return 0;
+  }
+  Ptr<const CdfTable> cached = FindCached(path, info, false);
+  if (cached)
+  {
+    return cached;
+  }
+
+  std::ifstream distFile(path.c_str());
+  double averageSize;
+  if (!(distFile >> averageSize))
+  {
+    NS_LOG_ERROR("Could not parse file: " << filename);
+    return 0;
+  }
+  NS_LOG_DEBUG("Loading CDF from " << path);
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  double value, probability;
+  while (distFile >> value >> probability)
+  {
+    NS_LOG_DEBUG(value << ", " << probability);
+    values.push_back(value);
+    cdfs.push_back(probability);
+  }
+  if (values.empty())
+  {
+    NS_LOG_ERROR("No CDF points in file: " << filename);
+    return 0;
+  }
+  for (uint32_t i = 1; i < values.size(); ++i)
+  {
+    if (values[i] < values[i - 1] || cdfs[i] < cdfs[i - 1])
+    {
+      NS_LOG_ERROR("CDF points are not increasing in file: " << filename);
+      return 0;
+    }
+  }
+  Ptr<const CdfTable> table = Create<CdfTable>(averageSize, values, cdfs);
+  AddCached(path, info, table);
+  return table;
+}
+
+Ptr<const CdfTable> CdfTable::Map(std::string filename)
+{
+  NS_LOG_FUNCTION(filename);
+  std::string path;
+  struct stat info;
+  if (!Resolve(filename, path, info))
+  {
+    NS_LOG_ERROR("Could not open file: " << filename);
+    return 0;
+  }
+  Ptr<const CdfTable> cached = FindCached(path, info, true);
+  if (cached)
+  {
+    return cached;
+  }
+
+  uint64_t size = info.st_size;
+  if (size < sizeof(CompiledCdfHeader))
+  {
+    NS_LOG_ERROR("Not a compiled CDF file: " << filename);
+    return 0;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    NS_LOG_ERROR("Could not open file: " << filename);
+    return 0;
+  }
+  void *map = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    NS_LOG_ERROR("Could not map file: " << filename);
+    return 0;
+  }
+  CompiledCdfHeader header;
+  std::memcpy(&header, map, sizeof(header));
+  if (std::memcmp(header.magic, "NTTD", 4) != 0 || header.version != COMPILED_CDF_VERSION ||
+      header.points == 0 || CompiledSize(header.points) != size)
+  {
+    munmap(map, size);
+    NS_LOG_ERROR("Not a compiled CDF file of this version: " << filename);
+    return 0;
+  }
+  // The points were checked when the file was compiled; only check that
+  // Sample() stays within the arrays.
+  const uint32_t *guide =
+      reinterpret_cast<const uint32_t *>(static_cast<const uint8_t *>(map) +
+                                         GuideOffset(header.points));
+  for (uint32_t k = 0; k < header.points; ++k)
+  {
+    if (guide[k] >= header.points)
+    {
+      munmap(map, size);
+      NS_LOG_ERROR("Invalid guide table in file: " << filename);
+      return 0;
+    }
+  }
+  NS_LOG_DEBUG("Mapped CDF from " << path);
+  Ptr<const CdfTable> table = Ptr<CdfTable>(new CdfTable(map, size), false);
+  AddCached(path, info, table);
+  return table;
+}
+
+void CdfTable::ClearCache(void)
+{
+  GetCache().clear();
+}
+
+uint32_t CdfTable::GetCacheSize(void)
+{
+  return GetCache().size();
+}
+
+CdfTable::CdfTable(double averageSize, std::vector<double> values, std::vector<double> cdfs)
+    : m_averageSize(averageSize),
+      m_mean(0),
+      m_points(values.size()),
+      m_valueStorage(values),
+      m_cdfStorage(cdfs),
+      m_map(0),
+      m_mapSize(0)
+{
+  NS_ABORT_MSG_IF(m_valueStorage.empty() || m_valueStorage.size() != m_cdfStorage.size(),
+                  "A CDF needs at least one point");
+  for (uint32_t i = 1; i < m_points; ++i)
+  {
+    NS_ABORT_MSG_IF(m_valueStorage[i] < m_valueStorage[i - 1] ||
+                        m_cdfStorage[i] < m_cdfStorage[i - 1],
+                    "CDF points are not increasing at " << m_valueStorage[i]);
+  }
+  m_guideStorage.resize(m_points);
+  for (uint32_t k = 0; k < m_points; ++k)
+  {
+    double start = static_cast<double>(k) / m_points;
+    uint32_t point =
+        std::upper_bound(m_cdfStorage.begin(), m_cdfStorage.end(), start) - m_cdfStorage.begin();
+    m_guideStorage[k] = std::min<uint32_t>(point, m_points - 1);
+  }
+  m_values = m_valueStorage.data();
+  m_cdfs = m_cdfStorage.data();
+  m_guide = m_guideStorage.data();
+
+  // Sample() returns the first size up to the first probability, the last
+  // size from the last one on, and interpolates linearly in between; the
+  // variates stay below 1.
+  double below = std::min(m_cdfs[0], 1.0);
+  m_mean = m_values[0] * below;
+  for (uint32_t i = 1; i < m_points && below < 1; ++i)
+  {
+    if (m_cdfs[i] == m_cdfs[i - 1])
+    {
+      continue;
+    }
+    double above = std::min(m_cdfs[i], 1.0);
+    m_mean += (m_values[i - 1] + Interpolate(i, above)) / 2 * (above - below);
+    below = above;
+  }
+  m_mean += m_values[m_points - 1] * (1 - below);
+}
+
+CdfTable::CdfTable(void *map, uint64_t mapSize)
+    : m_map(map),
+      m_mapSize(mapSize)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(map);
+  const CompiledCdfHeader *header = reinterpret_cast<const CompiledCdfHeader *>(bytes);
+  m_averageSize = header->averageSize;
+  m_mean = header->mean;
+  m_points = header->points;
+  m_values = reinterpret_cast<const double *>(bytes + sizeof(CompiledCdfHeader));
+  m_cdfs = reinterpret_cast<const double *>(bytes + CdfsOffset(m_points));
+  m_guide = reinterpret_cast<const uint32_t *>(bytes + GuideOffset(m_points));
+}
+
+CdfTable::~CdfTable()
+{
+  if (m_map)
+  {
+    munmap(m_map, m_mapSize);
+  }
+}
+
+bool CdfTable::Save(std::string filename) const
+{
+  NS_LOG_FUNCTION(this << filename);
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Could not create file: " << filename);
+    return false;
+  }
+  CompiledCdfHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "NTTD", 4);
+  header.version = COMPILED_CDF_VERSION;
+  header.points = m_points;
+  header.averageSize = m_averageSize;
+  header.mean = m_mean;
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(m_values), m_points * sizeof(double));
+  file.write(reinterpret_cast<const char *>(m_cdfs), m_points * sizeof(double));
+  file.write(reinterpret_cast<const char *>(m_guide), m_points * sizeof(uint32_t));
+  file.close();
+  return static_cast<bool>(file);
+}
+
+double CdfTable::GetAverageSize(void) const
+{
+  return m_averageSize;
+}
+
+double CdfTable::GetMean(void) const
+{
+  return m_mean;
+}
+
+uint32_t CdfTable::GetNPoints(void) const
+{
+  return m_points;
+}
+
+double CdfTable::Interpolate(uint32_t point, double u) const
+{
+  // The same expression as EmpiricalRandomVariable, so that the sizes are
+  // equal to the last bit.
+  double c1 = m_cdfs[point - 1];
+  double c2 = m_cdfs[point];
+  double v1 = m_values[point - 1];
+  double v2 = m_values[point];
+  return v1 + ((v2 - v1) / (c2 - c1)) * (u - c1);
+}
+
+bool CdfTable::IsMapped(void) const
+{
+  return m_map != 0;
+}
+
+double CdfTable::Sample(double u) const
+{
+  if (u <= m_cdfs[0])
+  {
+    return m_values[0];
+  }
+  if (u >= m_cdfs[m_points - 1])
+  {
+    return m_values[m_points - 1];
+  }
+  uint32_t slice = std::min<uint32_t>(u * m_points, m_points - 1);
+  uint32_t point = m_guide[slice];
+  // Rounding of the slice index can start one point too far.
+  while (point > 0 && m_cdfs[point - 1] > u)
+  {
+    --point;
+  }
+  while (m_cdfs[point] <= u)
+  {
+    ++point;
+  }
+  return Interpolate(point, u);
+}
+
+double CdfTable::SampleSearch(double u) const
+{
+  if (u <= m_cdfs[0])
+  {
+    return m_values[0];
+  }
+  if (u >= m_cdfs[m_points - 1])
+  {
+    return m_values[m_points - 1];
+  }
+  const double *point = std::upper_bound(m_cdfs, m_cdfs + m_points, u);
+  return Interpolate(point - m_cdfs, u);
+}
+
+} // namespace ns3
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compiled CDF files, see CdfTable::Save and CdfTable::Map.
+//
+// Layout: a CompiledCdfHeader followed by three arrays of `points`
+// entries: the sizes (double), the cumulative probabilities (double) and
+// the guide table (uint32). All fields are in host byte order; the arrays
+// are aligned to their entries, so a mapped file is used in place.
+
+#ifndef CDF_TABLE_H
+#define CDF_TABLE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3
+{
+
+/// Version of the compiled CDF files.
+const uint32_t COMPILED_CDF_VERSION = 2;
+
+#pragma pack(push, 1)
+/**
+ * \brief Header of a compiled CDF file.
+ */
+struct CompiledCdfHeader
+{
+  char magic[4];      //!< "NTTD"
+  uint32_t version;   //!< COMPILED_CDF_VERSION
+  uint32_t points;    //!< Number of CDF points
+  uint32_t reserved;  //!< Zero, aligns the following fields
+  double averageSize; //!< Average message size given in the text file
+  double mean;        //!< Mean of the sizes drawn from the table
+};
+#pragma pack(pop)
+
+/**
+ * \brief An immutable message size distribution read from a CDF file,
+ *        shared by all applications using the file.
+ *
+ * A CDF file starts with the average message size in bytes, followed by
+ * "<size> <cumulative probability>" pairs with both columns increasing.
+ * Load() parses every file once per process: tables are cached by the
+ * canonical path of the file and reloaded only if its modification time
+ * changes. Each application draws from the shared table with its own
+ * random variable, see Sample().
+ *
+ * Sample() takes constant expected time on tables of any size: a guide
+ * table with one entry per point holds, for each of as many equal slices
+ * of [0, 1), the first point whose probability exceeds the start of the
+ * slice, so only the few points within the slice of a variate are
+ * compared. Unlike an alias table, this keeps the mapping of variates to
+ * sizes of the inverse CDF, so the drawn sizes, interpolated between the
+ * point found and the one before, are the same as with a binary search.
+ *
+ * Save() writes the table with its guide table in a binary form that
+ * Map() maps read-only instead of parsing it, so a simulation does no
+ * text parsing at startup and all processes using a compiled file share
+ * its pages.
+ */
+class CdfTable : public SimpleRefCount<CdfTable>
+{
+public:
+  /**
+   * \brief Get the table of a file, parsing it on first use.
+   * \param filename the CDF file
+   * \return the table, or a null pointer if the file cannot be parsed
+   */
+  static Ptr<const CdfTable> Load(std::string filename);
+
+  /**
+   * \brief Get the table of a compiled file, mapping it on first use.
+   *        Tables are cached like those of Load().
+   * \param filename the compiled file written by Save()
+   * \return the table, or a null pointer if the file is not a compiled
+   *         CDF file of this version
+   */
+  static Ptr<const CdfTable> Map(std::string filename);
+
+  /**
+   * \param filename a CDF file
+   * \return the name of the file compiled from it, with its extension
+   *         replaced by .cdfb
+   */
+  static std::string GetCompiledName(std::string filename);
+
+  /**
+   * \brief Drop all cached tables; tables in use stay valid.
+   */
+  static void ClearCache(void);
+
+  /**
+   * \return the number of cached tables
+   */
+  static uint32_t GetCacheSize(void);
+
+  /**
+   * \param averageSize the average message size in bytes
+   * \param values the sizes of the CDF points, increasing
+   * \param cdfs the cumulative probabilities of the points, increasing
+   */
+  CdfTable(double averageSize, std::vector<double> values, std::vector<double> cdfs);
+  ~CdfTable();
+
+  /**
+   * \brief Write the table as a compiled file for Map().
+   * \param filename the file to create
+   * \return false if the file cannot be written
+   */
+  bool Save(std::string filename) const;
+
+  /**
+   * \return the average message size in bytes given in the file
+   */
+  double GetAverageSize(void) const;
+  /**
+   * \return the mean of the sizes drawn by Sample()
+   */
+  double GetMean(void) const;
+  /**
+   * \return the number of CDF points
+   */
+  uint32_t GetNPoints(void) const;
+
+  /**
+   * \brief Map a uniform variate to a size, exactly like the
+   *        EmpiricalRandomVariable of ns-3.34: the first or last size
+   *        outside the range of the table, else the size interpolated
+   *        linearly between the two points whose probabilities enclose u.
+   * \param u a uniform variate in [0, 1)
+   * \return the size
+   */
+  double Sample(double u) const;
+
+  /**
+   * \brief Sample() with a binary search over all points instead of the
+   *        guide table, as reference.
+   * \param u a uniform variate in [0, 1)
+   * \return the size
+   */
+  double SampleSearch(double u) const;
+
+  /**
+   * \return true if the table is a mapped compiled file
+   */
+  bool IsMapped(void) const;
+
+private:
+  /**
+   * \brief Use a mapped compiled file, see Map(). Takes the mapping.
+   * \param map the mapping of the whole file, with a valid header
+   * \param mapSize the size of the mapping
+   */
+  CdfTable(void *map, uint64_t mapSize);
+  CdfTable(const CdfTable &);
+  CdfTable &operator=(const CdfTable &);
+
+  /**
+   * \param point a point whose probability exceeds u, not the first one
+   * \param u a uniform variate at least the probability of the point before
+   * \return the size between the point and the one before at u
+   */
+  double Interpolate(uint32_t point, double u) const;
+
+  double m_averageSize;                 //!< Average message size in bytes
+  double m_mean;                        //!< Mean of the drawn sizes
+  uint32_t m_points;                    //!< Number of CDF points
+  const double *m_values;               //!< Sizes of the CDF points
+  const double *m_cdfs;                 //!< Cumulative probabilities of the points
+  const uint32_t *m_guide;              //!< First point above each slice of [0, 1)
+  std::vector<double> m_valueStorage;   //!< Sizes of a parsed table
+  std::vector<double> m_cdfStorage;     //!< Probabilities of a parsed table
+  std::vector<uint32_t> m_guideStorage; //!< Guide table of a parsed table
+  void *m_map;                          //!< Mapping of a compiled file, or 0
+  uint64_t m_mapSize;                   //!< Size of the mapping
+};
+
+} // namespace ns3
+
+#endif /* CDF_TABLE_H */
@@ -0,0 +1,238 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "columnar-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ColumnarTrace");
+
+// Columns with more distinct values in a chunk are stored plain.
+static const uint32_t MAX_DICTIONARY_SIZE = 1 << 16;
+
+// Append the lowest `width` bytes of value in little endian order.
+static void AppendLittleEndian(std::vector<uint8_t> &out, uint64_t value,
+                               uint32_t width)
+{
+  for (uint32_t i = 0; i < width; ++i)
+  {
+    out.push_back(value >> (8 * i));
+  }
+}
+
+// Smallest of 1, 2, 4 and 8 bytes that holds value.
+static uint32_t GetWidth(uint64_t value)
+{
+  if (value <= 0xff)
+  {
+    return 1;
+  }
+  if (value <= 0xffff)
+  {
+    return 2;
+  }
+  if (value <= 0xffffffff)
+  {
+    return 4;
+  }
+  return 8;
+}
+
+ColumnarTraceOutput::ColumnarTraceOutput(std::string filename,
+                                         Ptr<const TraceFormat> format,
+                                         uint32_t chunkRows)
+    : m_format(format),
+      m_columns(format->GetColumns()),
+      m_recordSize(format->GetRecordSize()),
+      m_chunkRows(chunkRows),
+      m_rows(0)
+{
+  NS_LOG_FUNCTION(this << filename << chunkRows);
+  NS_ABORT_MSG_IF(chunkRows == 0, "Empty chunks");
+  m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open trace file " << filename);
+
+  TraceFileHeader header;
+  MakeTraceFileHeader(*m_format, header);
+  std::memcpy(header.magic, "NTTC", 4);
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  std::vector<uint8_t> schema;
+  AppendLittleEndian(schema, m_columns.size(), 2);
+  for (const TraceColumn &column : m_columns)
+  {
+    schema.push_back(column.name.size());
+    schema.insert(schema.end(), column.name.begin(), column.name.end());
+    schema.push_back(column.size);
+    schema.push_back(column.isSigned);
+  }
+  m_file.write(reinterpret_cast<const char *>(schema.data()), schema.size());
+  m_buffer.reserve(m_chunkRows * m_recordSize);
+}
+
+ColumnarTraceOutput::~ColumnarTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void ColumnarTraceOutput::Write(const void *record)
+{
+  NS_ASSERT_MSG(m_file.is_open(), "Write to a closed trace output");
+  const uint8_t *data = static_cast<const uint8_t *>(record);
+  m_buffer.insert(m_buffer.end(), data, data + m_recordSize);
+  if (++m_rows == m_chunkRows)
+  {
+    FlushChunk();
+  }
+}
+
+void ColumnarTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (!m_file.is_open())
+  {
+    return;
+  }
+  if (m_rows > 0)
+  {
+    FlushChunk();
+  }
+  m_file.close();
+}
+
+void ColumnarTraceOutput::FlushChunk(void)
+{
+  std::vector<uint8_t> directory;
+  AppendLittleEndian(directory, m_rows, 4);
+  m_encoded.clear();
+  for (const TraceColumn &column : m_columns)
+  {
+    size_t start = m_encoded.size();
+    TraceColumn::Encoding encoding = EncodeColumn(column, m_encoded);
+    directory.push_back(encoding);
+    AppendLittleEndian(directory, m_encoded.size() - start, 4);
+  }
+  m_file.write(reinterpret_cast<const char *>(directory.data()), directory.size());
+  m_file.write(reinterpret_cast<const char *>(m_encoded.data()), m_encoded.size());
+  m_buffer.clear();
+  m_rows = 0;
+}
+
+TraceColumn::Encoding ColumnarTraceOutput::EncodeColumn(const TraceColumn &column,
+                                                        std::vector<uint8_t> &out)
+{
+  m_values.resize(m_rows);
+  for (uint32_t row = 0; row < m_rows; ++row)
+  {
+    m_values[row] = GetValue(column, row);
+  }
+
+  if (column.encoding == TraceColumn::DELTA)
+  {
+    uint64_t first = m_values[0];
+    uint64_t largest = 0;
+    // Zigzag-encode the differences in place, from the back.
+    for (uint32_t row = m_rows - 1; row > 0; --row)
+    {
+      int64_t delta = m_values[row] - m_values[row - 1];
+      m_values[row] = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+      largest = std::max(largest, m_values[row]);
+    }
+    m_values[0] = 0;
+    uint32_t width = GetWidth(largest);
+    AppendLittleEndian(out, first, 8);
+    out.push_back(width);
+    for (uint64_t value : m_values)
+    {
+      AppendLittleEndian(out, value, width);
+    }
+    return TraceColumn::DELTA;
+  }
+
+  if (column.encoding == TraceColumn::DICTIONARY)
+  {
+    std::unordered_map<uint64_t, uint32_t> indices;
+    std::vector<uint64_t> dictionary;
+    for (uint64_t value : m_values)
+    {
+      if (indices.emplace(value, dictionary.size()).second)
+      {
+        dictionary.push_back(value);
+        if (dictionary.size() > MAX_DICTIONARY_SIZE)
+        {
+          break;
+        }
+      }
+    }
+    if (dictionary.size() <= MAX_DICTIONARY_SIZE)
+    {
+      uint32_t width = GetWidth(dictionary.size() - 1);
+      AppendLittleEndian(out, dictionary.size(), 4);
+      for (uint64_t value : dictionary)
+      {
+        AppendLittleEndian(out, value, column.size);
+      }
+      out.push_back(width);
+      for (uint64_t value : m_values)
+      {
+        AppendLittleEndian(out, indices[value], width);
+      }
+      return TraceColumn::DICTIONARY;
+    }
+  }
+
+  for (uint64_t value : m_values)
+  {
+    AppendLittleEndian(out, value, column.size);
+  }
+  return TraceColumn::PLAIN;
+}
+
+uint64_t ColumnarTraceOutput::GetValue(const TraceColumn &column, uint32_t row) const
+{
+  const uint8_t *field = &m_buffer[row * m_recordSize + column.offset];
+  switch (column.size)
+  {
+  case 1:
+    return column.isSigned ? int64_t(int8_t(*field)) : *field;
+  case 2: {
+    uint16_t value;
+    std::memcpy(&value, field, sizeof(value));
+    return column.isSigned ? int64_t(int16_t(value)) : value;
+  }
+  case 4: {
+    uint32_t value;
+    std::memcpy(&value, field, sizeof(value));
+    return column.isSigned ? int64_t(int32_t(value)) : value;
+  }
+  default: {
+    uint64_t value;
+    std::memcpy(&value, field, sizeof(value));
+    return value;
+  }
+  }
+}
+
+} // namespace ns3
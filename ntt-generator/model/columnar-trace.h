@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Columnar trace files, read by ntt_trace.py.
+//
+// Layout, all integers little endian:
+//   TraceFileHeader with magic "NTTC"
+//   uint16 number of columns, then per column: uint8 name length, name,
+//     uint8 size in bytes, uint8 signed
+//   chunks until the end of the file, each:
+//     uint32 rows
+//     per column: uint8 encoding, uint32 length of the encoded column
+//     the encoded columns, one after another
+//
+// Encoded columns:
+//   PLAIN       rows values
+//   DELTA       int64 first value, uint8 width, rows zigzag-encoded
+//               differences to the previous value (the first one is 0)
+//   DICTIONARY  uint32 distinct values, the values, uint8 width, rows
+//               indices into the values
+
+#ifndef COLUMNAR_TRACE_H
+#define COLUMNAR_TRACE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Trace output storing records column by column in chunks.
+ *
+ * Most fields of the packet records take only a handful of values or
+ * change by small steps, so every column of a chunk is dictionary or
+ * delta encoded as given by TraceFormat::GetColumns. Readers can skip the
+ * columns they do not need.
+ */
+class ColumnarTraceOutput : public TraceOutput
+{
+public:
+  /**
+   * \param filename the file to create
+   * \param format the format of the records written to this output
+   * \param chunkRows number of rows per chunk
+   */
+  ColumnarTraceOutput(std::string filename, Ptr<const TraceFormat> format,
+                      uint32_t chunkRows = 65536);
+  virtual ~ColumnarTraceOutput();
+
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+private:
+  /// Encode and write the buffered rows.
+  void FlushChunk(void);
+  /**
+   * \brief Encode one column of the buffered rows.
+   * \param column the column
+   * \param out the encoded column is appended here
+   * \return the encoding used
+   */
+  TraceColumn::Encoding EncodeColumn(const TraceColumn &column,
+                                     std::vector<uint8_t> &out);
+  /**
+   * \param column the column
+   * \param row the row in the buffer
+   * \return the value of the column, sign-extended for signed columns
+   */
+  uint64_t GetValue(const TraceColumn &column, uint32_t row) const;
+
+  Ptr<const TraceFormat> m_format;     //!< Format of the records
+  std::vector<TraceColumn> m_columns;  //!< Columns of the format
+  uint32_t m_recordSize;               //!< Cached record size
+  uint32_t m_chunkRows;                //!< Rows per chunk
+  uint32_t m_rows;                     //!< Buffered rows
+  std::vector<uint8_t> m_buffer;       //!< Buffered records
+  std::vector<uint8_t> m_encoded;      //!< Encoded columns of a chunk
+  std::vector<uint64_t> m_values;      //!< Scratch space for a column
+  std::ofstream m_file;                //!< The output file
+};
+
+} // namespace ns3
+
+#endif /* COLUMNAR_TRACE_H */
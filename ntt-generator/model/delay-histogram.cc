@@ -0,0 +1,325 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/experiment-tags.h"
+#include "ns3/trace-output.h"
+
+#include "delay-histogram.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("DelayHistogram");
+
+const uint8_t DelayHistogram::SUB_BUCKET_BITS;
+
+static const uint64_t SUB_BUCKETS = 1 << DelayHistogram::SUB_BUCKET_BITS;
+
+static void AppendVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(value);
+}
+
+static bool ReadVarint(const uint8_t *data, size_t size, size_t &offset, uint64_t &value)
+{
+  value = 0;
+  for (uint32_t shift = 0; offset < size && shift < 64; shift += 7)
+  {
+    uint8_t byte = data[offset++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+DelayHistogram::DelayHistogram()
+    : m_count(0),
+      m_min(0),
+      m_max(0),
+      m_sum(0)
+{
+}
+
+uint32_t DelayHistogram::GetBucket(uint64_t value)
+{
+  if (value < 2 * SUB_BUCKETS)
+  {
+    return value;
+  }
+  uint32_t msb = 63 - __builtin_clzll(value);
+  uint32_t shift = msb - SUB_BUCKET_BITS;
+  return shift * SUB_BUCKETS + (value >> shift);
+}
+
+uint64_t DelayHistogram::GetBucketStart(uint32_t bucket)
+{
+  if (bucket < 2 * SUB_BUCKETS)
+  {
+    return bucket;
+  }
+  uint32_t shift = bucket / SUB_BUCKETS - 1;
+  return (bucket - shift * SUB_BUCKETS) << shift;
+}
+
+uint64_t DelayHistogram::GetBucketWidth(uint32_t bucket)
+{
+  if (bucket < 2 * SUB_BUCKETS)
+  {
+    return 1;
+  }
+  return static_cast<uint64_t>(1) << (bucket / SUB_BUCKETS - 1);
+}
+
+void DelayHistogram::Record(uint64_t value)
+{
+  uint32_t bucket = GetBucket(value);
+  if (bucket >= m_buckets.size())
+  {
+    m_buckets.resize(bucket + 1);
+  }
+  ++m_buckets[bucket];
+  m_min = m_count == 0 ? value : std::min(m_min, value);
+  m_max = std::max(m_max, value);
+  m_sum += value;
+  ++m_count;
+}
+
+void DelayHistogram::Merge(const DelayHistogram &other)
+{
+  if (other.m_count == 0)
+  {
+    return;
+  }
+  if (other.m_buckets.size() > m_buckets.size())
+  {
+    m_buckets.resize(other.m_buckets.size());
+  }
+  for (size_t i = 0; i < other.m_buckets.size(); ++i)
+  {
+    m_buckets[i] += other.m_buckets[i];
+  }
+  m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+  m_max = std::max(m_max, other.m_max);
+  m_sum += other.m_sum;
+  m_count += other.m_count;
+}
+
+uint64_t DelayHistogram::GetCount(void) const
+{
+  return m_count;
+}
+
+uint64_t DelayHistogram::GetMin(void) const
+{
+  return m_min;
+}
+
+uint64_t DelayHistogram::GetMax(void) const
+{
+  return m_max;
+}
+
+double DelayHistogram::GetMean(void) const
+{
+  return m_count == 0 ? 0 : static_cast<double>(m_sum) / m_count;
+}
+
+uint64_t DelayHistogram::GetQuantile(double q) const
+{
+  if (m_count == 0)
+  {
+    return 0;
+  }
+  // The value of rank ceil(q * count), counting from 1.
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(std::min(std::max(q, 0.0), 1.0) * m_count));
+  uint64_t seen = 0;
+  for (uint32_t bucket = 0; bucket < m_buckets.size(); ++bucket)
+  {
+    seen += m_buckets[bucket];
+    if (seen >= rank)
+    {
+      uint64_t middle = GetBucketStart(bucket) + GetBucketWidth(bucket) / 2;
+      return std::min(std::max(middle, m_min), m_max);
+    }
+  }
+  return m_max;
+}
+
+void DelayHistogram::Serialize(std::vector<uint8_t> &out) const
+{
+  AppendVarint(out, m_count);
+  AppendVarint(out, m_min);
+  AppendVarint(out, m_max);
+  AppendVarint(out, m_sum);
+  uint64_t used = std::count_if(m_buckets.begin(), m_buckets.end(),
+                                [](uint64_t count) { return count > 0; });
+  AppendVarint(out, used);
+  uint32_t previous = 0;
+  for (uint32_t bucket = 0; bucket < m_buckets.size(); ++bucket)
+  {
+    if (m_buckets[bucket] > 0)
+    {
+      AppendVarint(out, bucket - previous);
+      AppendVarint(out, m_buckets[bucket]);
+      previous = bucket;
+    }
+  }
+}
+
+bool DelayHistogram::Deserialize(const uint8_t *data, size_t size, size_t &offset)
+{
+  uint64_t used;
+  if (!ReadVarint(data, size, offset, m_count) || !ReadVarint(data, size, offset, m_min) ||
+      !ReadVarint(data, size, offset, m_max) || !ReadVarint(data, size, offset, m_sum) ||
+      !ReadVarint(data, size, offset, used))
+  {
+    return false;
+  }
+  m_buckets.clear();
+  uint64_t bucket = 0;
+  for (uint64_t i = 0; i < used; ++i)
+  {
+    uint64_t delta;
+    uint64_t count;
+    if (!ReadVarint(data, size, offset, delta) || !ReadVarint(data, size, offset, count))
+    {
+      return false;
+    }
+    bucket += delta;
+    if (bucket > GetBucket(UINT64_MAX))
+    {
+      return false;
+    }
+    m_buckets.resize(bucket + 1);
+    m_buckets[bucket] = count;
+  }
+  return true;
+}
+
+void DelayHistogramSet::Record(uint32_t receiver, Ptr<const Packet> p)
+{
+  TimestampTag timestampTag;
+  IdTag idTag;
+  if (!p->PeekPacketTag(timestampTag) || !p->PeekPacketTag(idTag))
+  {
+    return;
+  }
+  Time delay = Simulator::Now() - timestampTag.GetTime();
+  Record(Key(idTag.GetWorkload(), idTag.GetApplication(), receiver),
+         std::max<int64_t>(0, delay.GetNanoSeconds()));
+}
+
+void DelayHistogramSet::Record(const Key &key, uint64_t delay)
+{
+  m_histograms[key].Record(delay);
+}
+
+void DelayHistogramSet::Merge(const Key &key, const DelayHistogram &histogram)
+{
+  m_histograms[key].Merge(histogram);
+}
+
+void DelayHistogramSet::Merge(const DelayHistogramSet &other)
+{
+  for (const auto &histogram : other.m_histograms)
+  {
+    Merge(histogram.first, histogram.second);
+  }
+}
+
+const std::map<DelayHistogramSet::Key, DelayHistogram> &
+DelayHistogramSet::GetHistograms(void) const
+{
+  return m_histograms;
+}
+
+void DelayHistogramSet::Write(std::string filename) const
+{
+  NS_LOG_FUNCTION(this << filename);
+  TraceFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "NTTH", 4);
+  header.version = DELAY_HISTOGRAM_VERSION;
+  header.recordSize = 0;
+  std::strncpy(header.format, "delay-histogram", sizeof(header.format) - 1);
+
+  std::vector<uint8_t> data;
+  data.push_back(DelayHistogram::SUB_BUCKET_BITS);
+  for (const auto &histogram : m_histograms)
+  {
+    AppendVarint(data, std::get<0>(histogram.first));
+    AppendVarint(data, std::get<1>(histogram.first));
+    AppendVarint(data, std::get<2>(histogram.first));
+    histogram.second.Serialize(data);
+  }
+
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS(file.is_open(), "Unable to open histogram file " << filename);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(data.data()), data.size());
+  NS_ABORT_MSG_UNLESS(file, "Unable to write histogram file " << filename);
+}
+
+void DelayHistogramSet::Read(std::string filename)
+{
+  NS_LOG_FUNCTION(this << filename);
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_UNLESS(file.is_open(), "Unable to open " << filename);
+  TraceFileHeader header;
+  uint8_t bits = 0;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  file.read(reinterpret_cast<char *>(&bits), 1);
+  NS_ABORT_MSG_UNLESS(file && std::memcmp(header.magic, "NTTH", 4) == 0 &&
+                          header.version == DELAY_HISTOGRAM_VERSION &&
+                          bits == DelayHistogram::SUB_BUCKET_BITS,
+                      filename << " is not a delay histogram file of this version");
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+
+  size_t offset = 0;
+  while (offset < data.size())
+  {
+    uint64_t workload;
+    uint64_t application;
+    uint64_t receiver;
+    DelayHistogram histogram;
+    NS_ABORT_MSG_UNLESS(ReadVarint(data.data(), data.size(), offset, workload) &&
+                            ReadVarint(data.data(), data.size(), offset, application) &&
+                            ReadVarint(data.data(), data.size(), offset, receiver) &&
+                            histogram.Deserialize(data.data(), data.size(), offset),
+                        "Truncated histogram in " << filename);
+    Merge(Key(workload, application, receiver), histogram);
+  }
+}
+
+} // namespace ns3
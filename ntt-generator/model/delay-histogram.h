@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Mergeable log-bucketed delay histograms, read by ntt_trace.py and merged
+// with ntt-delay-histogram.
+//
+// Layout: TraceFileHeader with magic "NTTH", format "delay-histogram" and
+// record size 0, one byte with the sub-bucket bits, then one entry per
+// histogram until the end of the file. All other integers are LEB128
+// varints:
+//
+//   workload application receiver count min max sum n
+//   n times: bucket index (difference to the previous one) and count
+
+#ifndef DELAY_HISTOGRAM_H
+#define DELAY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3
+{
+
+/// Version of the histogram files, changed independently of the records
+/// of TRACE_FILE_VERSION. Starts at 2, the version of the existing files.
+const uint16_t DELAY_HISTOGRAM_VERSION = 2;
+
+/**
+ * \brief Histogram of non-negative integer values, e.g. delays in
+ *        nanoseconds, with a bounded relative error.
+ *
+ * Like an HDR histogram, the values below 2 * 2^SUB_BUCKET_BITS have a
+ * bucket each and every further power of two is split into
+ * 2^SUB_BUCKET_BITS buckets, so a bucket is never wider than 1/128 of its
+ * values. Histograms are merged by adding the bucket counts.
+ */
+class DelayHistogram
+{
+public:
+  /// log2 of the number of buckets per power of two.
+  static const uint8_t SUB_BUCKET_BITS = 7;
+
+  DelayHistogram();
+
+  /**
+   * \param value the value to count
+   */
+  void Record(uint64_t value);
+  /**
+   * \param other the histogram to add to this one
+   */
+  void Merge(const DelayHistogram &other);
+
+  /**
+   * \return the number of values
+   */
+  uint64_t GetCount(void) const;
+  /**
+   * \return the smallest value, 0 if empty
+   */
+  uint64_t GetMin(void) const;
+  /**
+   * \return the largest value, 0 if empty
+   */
+  uint64_t GetMax(void) const;
+  /**
+   * \return the mean of the values, 0 if empty
+   */
+  double GetMean(void) const;
+  /**
+   * \param q the quantile, between 0 and 1
+   * \return the middle of the bucket holding the quantile, within the
+   *         smallest and largest value; 0 if empty
+   */
+  uint64_t GetQuantile(double q) const;
+
+  /**
+   * \brief Append the histogram in the file encoding, from count on.
+   * \param out the buffer
+   */
+  void Serialize(std::vector<uint8_t> &out) const;
+  /**
+   * \brief Read a histogram written by Serialize.
+   * \param data the encoded histogram
+   * \param size the bytes available
+   * \param offset the offset of the histogram, set to the offset after it
+   * \return false if the data is truncated
+   */
+  bool Deserialize(const uint8_t *data, size_t size, size_t &offset);
+
+  /**
+   * \param value a value
+   * \return the index of the bucket counting the value
+   */
+  static uint32_t GetBucket(uint64_t value);
+  /**
+   * \param bucket a bucket index
+   * \return the smallest value counted by the bucket
+   */
+  static uint64_t GetBucketStart(uint32_t bucket);
+  /**
+   * \param bucket a bucket index
+   * \return the number of values counted by the bucket
+   */
+  static uint64_t GetBucketWidth(uint32_t bucket);
+
+private:
+  std::vector<uint64_t> m_buckets; //!< Counts by bucket index, up to the last used
+  uint64_t m_count;                //!< Number of values
+  uint64_t m_min;                  //!< Smallest value
+  uint64_t m_max;                  //!< Largest value
+  uint64_t m_sum;                  //!< Sum of the values
+};
+
+/**
+ * \brief Delay histograms by workload, application and receiver.
+ */
+class DelayHistogramSet : public SimpleRefCount<DelayHistogramSet>
+{
+public:
+  /// Workload id, application id and receiver node id.
+  typedef std::tuple<uint32_t, uint32_t, uint32_t> Key;
+
+  /**
+   * \brief Count the one-way delay of a packet arriving at a receiver,
+   *        e.g. traced at MacRx. Packets without TimestampTag or IdTag
+   *        are ignored.
+   * \param receiver the receiver node id
+   * \param p the packet
+   */
+  void Record(uint32_t receiver, Ptr<const Packet> p);
+  /**
+   * \param key the histogram
+   * \param delay the delay in nanoseconds
+   */
+  void Record(const Key &key, uint64_t delay);
+
+  /**
+   * \param key the histogram
+   * \param histogram the histogram to add to it
+   */
+  void Merge(const Key &key, const DelayHistogram &histogram);
+  /**
+   * \param other the histograms to add to these ones
+   */
+  void Merge(const DelayHistogramSet &other);
+
+  /**
+   * \return the histograms
+   */
+  const std::map<Key, DelayHistogram> &GetHistograms(void) const;
+
+  /**
+   * \brief Write the histograms to a file, aborts on failure.
+   * \param filename the file to create
+   */
+  void Write(std::string filename) const;
+  /**
+   * \brief Add the histograms of a file written by Write, aborts if the
+   *        file is not a histogram file of this version.
+   * \param filename the file to read
+   */
+  void Read(std::string filename);
+
+private:
+  std::map<Key, DelayHistogram> m_histograms; //!< Histograms by key
+};
+
+} // namespace ns3
+
+#endif /* DELAY_HISTOGRAM_H */
@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+
+#include "drop-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("DropTrace");
+
+static void WriteDropPacketRecord(Ptr<TraceOutput> output, uint16_t port, Ptr<const Packet> p)
+{
+  DropPacketRecord record;
+  if (MakePacketRecord(p, record.packet))
+  {
+    record.port = port;
+    output->Write(&record);
+  }
+}
+
+uint16_t ConnectDropPacketTrace(Ptr<TraceOutput> output, std::ostream &ports,
+                                Ptr<TraceSampler> sampler)
+{
+  NS_LOG_FUNCTION(output);
+  ports << "port,node,device\n";
+  uint16_t port = 0;
+  for (NodeList::Iterator node = NodeList::Begin(); node != NodeList::End(); ++node)
+  {
+    for (uint32_t i = 0; i < (*node)->GetNDevices(); ++i)
+    {
+      NS_ABORT_MSG_IF(port == UINT16_MAX, "Too many ports for drop records");
+      bool connected = (*node)->GetDevice(i)->TraceConnectWithoutContext(
+          "MacTxDrop",
+          MakeSampledCallback(sampler, MakeBoundCallback(&WriteDropPacketRecord, output, port)));
+      if (connected)
+      {
+        ports << port << ',' << (*node)->GetId() << ',' << i << '\n';
+        ++port;
+      }
+    }
+  }
+  return port;
+}
+
+} // namespace ns3
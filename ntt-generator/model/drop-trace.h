@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DROP_TRACE_H
+#define DROP_TRACE_H
+
+#include <stdint.h>
+#include <ostream>
+
+#include "ns3/ptr.h"
+#include "ns3/trace-output.h"
+#include "ns3/trace-sampler.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Log the application packets dropped by any net device, with the
+ *        fields of the delivered packets.
+ *
+ * Connects a sink to the MacTxDrop trace of every device that has one.
+ * These devices are numbered as ports in node and device order, and each
+ * sink is bound to its port id once, so a drop only costs the record of
+ * MakePacketRecord. Drops of packets without the sender tags are not
+ * logged, like in the packet logs.
+ *
+ * \param output the output for DropPacketRecords
+ * \param ports receives the port table as csv: port, node and device
+ * \param sampler the sampler, or a null pointer to log every drop
+ * \return the number of ports
+ */
+uint16_t ConnectDropPacketTrace(Ptr<TraceOutput> output, std::ostream &ports,
+                                Ptr<TraceSampler> sampler = 0);
+
+} // namespace ns3
+
+#endif /* DROP_TRACE_H */
@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+
+#include "flow-window.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("FlowWindowTrace");
+
+// Bits of the linear counting bitmap.
+static const uint32_t BITMAP_BITS = 256;
+
+// Bit of a message id in the linear counting bitmap. Ids are mostly
+// consecutive, so they are mixed well (splitmix64 finalizer).
+static uint32_t MessageBit(uint32_t message)
+{
+  uint64_t h = message;
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h % BITMAP_BITS;
+}
+
+static bool FlowLess(const TraceFlow &a, const TraceFlow &b)
+{
+  if (a.source != b.source)
+  {
+    return a.source < b.source;
+  }
+  if (a.destination != b.destination)
+  {
+    return a.destination < b.destination;
+  }
+  if (a.sourcePort != b.sourcePort)
+  {
+    return a.sourcePort < b.sourcePort;
+  }
+  if (a.destinationPort != b.destinationPort)
+  {
+    return a.destinationPort < b.destinationPort;
+  }
+  return a.protocol < b.protocol;
+}
+
+FlowWindowTraceOutput::FlowWindowTraceOutput(Ptr<TraceOutput> output, Time window, Time step)
+    : m_output(output),
+      m_step(step.IsZero() ? window.GetNanoSeconds() : step.GetNanoSeconds()),
+      m_steps(1),
+      m_current(0),
+      m_next(0),
+      m_closed(false)
+{
+  NS_LOG_FUNCTION(this << output << window << step);
+  NS_ABORT_MSG_UNLESS(window.IsStrictlyPositive(), "The flow window must be positive");
+  NS_ABORT_MSG_IF(step.IsStrictlyNegative(), "The flow window step must not be negative");
+  NS_ABORT_MSG_UNLESS(window.GetNanoSeconds() % m_step == 0,
+                      "The flow window step must divide the window");
+  m_steps = window.GetNanoSeconds() / m_step;
+}
+
+FlowWindowTraceOutput::~FlowWindowTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void FlowWindowTraceOutput::Write(const void *data)
+{
+  NS_ASSERT_MSG(!m_closed, "Write to a closed trace output");
+  PacketRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  uint64_t step = record.timestamp / m_step;
+  if (step > m_current)
+  {
+    Advance(step);
+    m_current = step;
+  }
+
+  TraceFlow key;
+  key.source = record.source;
+  key.destination = record.destination;
+  key.sourcePort = record.sourcePort;
+  key.destinationPort = record.destinationPort;
+  key.protocol = record.protocol;
+  Flow &flow = m_flows[key];
+  if (flow.steps.empty())
+  {
+    flow.steps.resize(m_steps);
+    std::memset(flow.steps.data(), 0, m_steps * sizeof(Window));
+  }
+  Window &window = flow.steps[step % m_steps];
+  if (window.packets == 0 || window.step != step)
+  {
+    std::memset(&window, 0, sizeof(window));
+    window.step = step;
+    window.maxDelay = record.delay;
+  }
+  window.bytes += record.size;
+  window.delaySum += record.delay;
+  window.maxDelay = std::max(window.maxDelay, record.delay);
+  ++window.packets;
+  AddMessage(window, record.message);
+  flow.last = step;
+
+  if (!m_expire.IsRunning())
+  {
+    m_expire = Simulator::Schedule(NanoSeconds((step + 1) * m_step - record.timestamp),
+                                   &FlowWindowTraceOutput::Expire, this);
+  }
+}
+
+void FlowWindowTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (m_closed)
+  {
+    return;
+  }
+  m_closed = true;
+  m_expire.Cancel();
+  // The windows that have not ended yet are written as they are.
+  for (uint64_t start = m_next; start <= m_current && !m_flows.empty(); ++start)
+  {
+    WriteWindow(start);
+  }
+  m_flows.clear();
+  m_output->Close();
+}
+
+void FlowWindowTraceOutput::AddMessage(Window &window, uint32_t message)
+{
+  if (window.exact <= EXACT_MESSAGES)
+  {
+    for (uint32_t i = 0; i < window.exact; ++i)
+    {
+      if (window.messages[i] == message)
+      {
+        return;
+      }
+    }
+    if (window.exact < EXACT_MESSAGES)
+    {
+      window.messages[window.exact++] = message;
+      return;
+    }
+    // Too many for the list, move the ids to the bitmap.
+    for (uint32_t i = 0; i < EXACT_MESSAGES; ++i)
+    {
+      uint32_t bit = MessageBit(window.messages[i]);
+      window.bitmap[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+    }
+    ++window.exact;
+  }
+  uint32_t bit = MessageBit(message);
+  window.bitmap[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+}
+
+uint32_t FlowWindowTraceOutput::CountMessages(const Window &window)
+{
+  if (window.exact <= EXACT_MESSAGES)
+  {
+    return window.exact;
+  }
+  uint32_t set = 0;
+  for (uint64_t word : window.bitmap)
+  {
+    set += __builtin_popcountll(word);
+  }
+  // A full bitmap is saturated, report the estimate for one bit left.
+  double empty = std::max<uint32_t>(1, BITMAP_BITS - set);
+  double estimate = -static_cast<double>(BITMAP_BITS) * std::log(empty / BITMAP_BITS);
+  return std::max<uint32_t>(EXACT_MESSAGES + 1, std::lround(estimate));
+}
+
+void FlowWindowTraceOutput::Merge(Window &window, const Window &other)
+{
+  window.maxDelay = window.packets == 0 ? other.maxDelay : std::max(window.maxDelay, other.maxDelay);
+  window.bytes += other.bytes;
+  window.delaySum += other.delaySum;
+  window.packets += other.packets;
+  if (other.exact <= EXACT_MESSAGES)
+  {
+    for (uint32_t i = 0; i < other.exact; ++i)
+    {
+      AddMessage(window, other.messages[i]);
+    }
+    return;
+  }
+  if (window.exact <= EXACT_MESSAGES)
+  {
+    for (uint32_t i = 0; i < window.exact; ++i)
+    {
+      uint32_t bit = MessageBit(window.messages[i]);
+      window.bitmap[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+    }
+    window.exact = EXACT_MESSAGES + 1;
+  }
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    window.bitmap[i] |= other.bitmap[i];
+  }
+}
+
+void FlowWindowTraceOutput::Advance(uint64_t step)
+{
+  // Windows starting after the last step with packets are empty.
+  uint64_t start = m_next;
+  for (; start + m_steps <= step && start <= m_current; ++start)
+  {
+    WriteWindow(start);
+  }
+  m_next = std::max(start, step + 1 >= m_steps ? step + 1 - m_steps : 0);
+  for (auto it = m_flows.begin(); it != m_flows.end();)
+  {
+    if (it->second.last < m_next)
+    {
+      it = m_flows.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void FlowWindowTraceOutput::WriteWindow(uint64_t start)
+{
+  std::vector<std::pair<TraceFlow, Window>> flows;
+  for (const auto &flow : m_flows)
+  {
+    Window window;
+    std::memset(&window, 0, sizeof(window));
+    for (const Window &step : flow.second.steps)
+    {
+      if (step.packets > 0 && step.step >= start && step.step < start + m_steps)
+      {
+        Merge(window, step);
+      }
+    }
+    if (window.packets > 0)
+    {
+      flows.emplace_back(flow.first, window);
+    }
+  }
+  std::sort(flows.begin(), flows.end(),
+            [](const std::pair<TraceFlow, Window> &a, const std::pair<TraceFlow, Window> &b) {
+              return FlowLess(a.first, b.first);
+            });
+  for (const auto &flow : flows)
+  {
+    const Window &window = flow.second;
+    FlowWindowRecord record;
+    record.timestamp = start * m_step;
+    record.bytes = window.bytes;
+    record.meanDelay = window.delaySum / window.packets;
+    record.maxDelay = window.maxDelay;
+    record.packets = window.packets;
+    record.messages = CountMessages(window);
+    record.source = flow.first.source;
+    record.destination = flow.first.destination;
+    record.sourcePort = flow.first.sourcePort;
+    record.destinationPort = flow.first.destinationPort;
+    record.protocol = flow.first.protocol;
+    m_output->Write(&record);
+  }
+}
+
+void FlowWindowTraceOutput::Expire(void)
+{
+  Advance(Simulator::Now().GetNanoSeconds() / m_step);
+  if (!m_flows.empty())
+  {
+    m_expire = Simulator::Schedule(NanoSeconds(m_step), &FlowWindowTraceOutput::Expire, this);
+  }
+}
+
+} // namespace ns3
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_WINDOW_H
+#define FLOW_WINDOW_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Trace output aggregating PacketRecords per flow over sliding
+ *        windows and writing one FlowWindowRecord per flow and window.
+ *
+ * A window of length `window` starts at every multiple of `step`, so
+ * consecutive windows overlap unless the step equals the window, which
+ * gives aligned tumbling windows. Every flow keeps the aggregates of the
+ * window / step steps of the current window, each of a fixed size, and a
+ * window is the sum of its steps. Only the flows of the current window
+ * are kept, so the memory does not grow with the number of packets.
+ *
+ * A window is written, sorted by flow, once it has ended, at the latest
+ * by an event at its end in simulation time, so the records of a flow
+ * that has gone quiet do not wait for later packets. The windows that
+ * have not ended are written on Close(). A flow without packets in a
+ * window gets no record for it.
+ *
+ * Distinct message ids are counted exactly up to EXACT_MESSAGES per flow
+ * and window, beyond that they are estimated by linear counting.
+ */
+class FlowWindowTraceOutput : public TraceOutput
+{
+public:
+  /// Message ids per flow and window that are counted exactly.
+  static const uint32_t EXACT_MESSAGES = 8;
+
+  /**
+   * \param output output of the FlowWindowRecords, closed by Close()
+   * \param window the window length
+   * \param step the time between the starts of two windows, a divisor
+   *        of the window; zero for the window length
+   */
+  FlowWindowTraceOutput(Ptr<TraceOutput> output, Time window, Time step = Time(0));
+  virtual ~FlowWindowTraceOutput();
+
+  /**
+   * \brief Count a packet.
+   * \param record a PacketRecord, records must be in time order
+   */
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+private:
+  /// Hash of a TraceFlow.
+  struct FlowHash
+  {
+    size_t operator()(const TraceFlow &flow) const
+    {
+      uint64_t h = (static_cast<uint64_t>(flow.source) << 32) ^ flow.destination;
+      h = h * 0x9e3779b97f4a7c15ULL ^
+          ((static_cast<uint64_t>(flow.sourcePort) << 24) ^
+           (static_cast<uint64_t>(flow.destinationPort) << 8) ^ flow.protocol);
+      return h * 0x9e3779b97f4a7c15ULL >> 16;
+    }
+  };
+
+  /// Equality of TraceFlows.
+  struct FlowEqual
+  {
+    bool operator()(const TraceFlow &a, const TraceFlow &b) const
+    {
+      return a.source == b.source && a.destination == b.destination &&
+             a.sourcePort == b.sourcePort && a.destinationPort == b.destinationPort &&
+             a.protocol == b.protocol;
+    }
+  };
+
+  /// Aggregates of one flow in one step or window.
+  struct Window
+  {
+    uint64_t step;                     //!< Step of the aggregates
+    uint64_t bytes;                    //!< Bytes of the packets
+    int64_t delaySum;                  //!< Sum of the delays
+    int64_t maxDelay;                  //!< Largest delay
+    uint32_t packets;                  //!< Number of packets
+    uint32_t exact;                    //!< Message ids in messages, or above EXACT_MESSAGES
+    uint32_t messages[EXACT_MESSAGES]; //!< Distinct message ids
+    uint64_t bitmap[4];                //!< Linear counting bitmap
+  };
+
+  /// The steps of one flow, by step modulo the steps per window.
+  struct Flow
+  {
+    uint64_t last;             //!< Last step with packets
+    std::vector<Window> steps; //!< Aggregates of the recent steps
+  };
+
+  /**
+   * \param window the aggregates
+   * \param message a message id of the window
+   */
+  static void AddMessage(Window &window, uint32_t message);
+  /**
+   * \param window the aggregates, extended by those of other
+   * \param other the aggregates of another step
+   */
+  static void Merge(Window &window, const Window &other);
+  /**
+   * \param window the aggregates
+   * \return the number of distinct message ids of the window
+   */
+  static uint32_t CountMessages(const Window &window);
+  /**
+   * \brief Write the windows ending at or before a step and forget the
+   *        flows without packets in later windows.
+   * \param step the current step
+   */
+  void Advance(uint64_t step);
+  /// Write the windows of all flows starting at a step.
+  void WriteWindow(uint64_t start);
+  /// Advance to the current simulation time, see Advance().
+  void Expire(void);
+
+  Ptr<TraceOutput> m_output; //!< Output of the records
+  uint64_t m_step;           //!< Step in nanoseconds
+  uint64_t m_steps;          //!< Steps per window
+  uint64_t m_current;        //!< Last step with packets
+  uint64_t m_next;           //!< First window not written yet
+  bool m_closed;             //!< Close() was called
+  EventId m_expire;          //!< Pending Expire() event
+  /// Flows of the current windows.
+  std::unordered_map<TraceFlow, Flow, FlowHash, FlowEqual> m_flows;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_WINDOW_H */
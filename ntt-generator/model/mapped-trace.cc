@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "mapped-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("MappedTrace");
+
+static MappedTraceState *GetState(uint8_t *map)
+{
+  return reinterpret_cast<MappedTraceState *>(map + sizeof(TraceFileHeader));
+}
+
+MappedTraceOutput::MappedTraceOutput(std::string filename, Ptr<const TraceFormat> format,
+                                     uint64_t growSize)
+    : m_recordSize(format->GetRecordSize()),
+      m_map(0),
+      m_mapSize(0),
+      m_state(0),
+      m_used(0)
+{
+  NS_LOG_FUNCTION(this << filename << growSize);
+  // Whole pages, and room for at least one record.
+  uint64_t page = sysconf(_SC_PAGESIZE);
+  m_growSize = std::max<uint64_t>(growSize, m_recordSize);
+  m_growSize = (m_growSize + page - 1) / page * page;
+
+  m_fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  NS_ABORT_MSG_IF(m_fd < 0, "Unable to open trace file " << filename);
+  m_mapSize = MAPPED_TRACE_HEADER_SIZE;
+  Grow();
+
+  TraceFileHeader header;
+  MakeTraceFileHeader(*format, header);
+  std::memcpy(header.magic, "NTTM", 4);
+  std::memcpy(m_map, &header, sizeof(header));
+}
+
+MappedTraceOutput::~MappedTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void MappedTraceOutput::Write(const void *record)
+{
+  NS_ASSERT_MSG(m_fd >= 0, "Write to a closed trace output");
+  if (MAPPED_TRACE_HEADER_SIZE + m_used + m_recordSize > m_mapSize)
+  {
+    Grow();
+  }
+  std::memcpy(m_map + MAPPED_TRACE_HEADER_SIZE + m_used, record, m_recordSize);
+  m_used += m_recordSize;
+  // The record must be in the mapping before it is counted.
+  __atomic_store_n(&m_state->committed, m_used, __ATOMIC_RELEASE);
+}
+
+void MappedTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (m_fd < 0)
+  {
+    return;
+  }
+  m_state->closed = 1;
+  munmap(m_map, m_mapSize);
+  m_map = 0;
+  m_state = 0;
+  NS_ABORT_MSG_IF(ftruncate(m_fd, MAPPED_TRACE_HEADER_SIZE + m_used) != 0,
+                  "Unable to truncate trace file");
+  close(m_fd);
+  m_fd = -1;
+}
+
+void MappedTraceOutput::Grow(void)
+{
+  uint64_t size = m_mapSize + m_growSize;
+  NS_ABORT_MSG_IF(ftruncate(m_fd, size) != 0, "Unable to extend trace file");
+  if (m_map)
+  {
+    // Start writing back the full pages, the new mapping shares them.
+    msync(m_map, m_mapSize, MS_ASYNC);
+    munmap(m_map, m_mapSize);
+  }
+  void *map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  NS_ABORT_MSG_IF(map == MAP_FAILED, "Unable to map trace file");
+  m_map = static_cast<uint8_t *>(map);
+  m_mapSize = size;
+  m_state = GetState(m_map);
+}
+
+MappedTraceReader::MappedTraceReader(std::string filename)
+    : m_map(0),
+      m_mapSize(0)
+{
+  NS_LOG_FUNCTION(this << filename);
+  int fd = open(filename.c_str(), O_RDONLY);
+  NS_ABORT_MSG_IF(fd < 0, "Unable to open " << filename);
+  struct stat info;
+  NS_ABORT_MSG_IF(fstat(fd, &info) != 0, "Unable to stat " << filename);
+  NS_ABORT_MSG_IF(static_cast<uint64_t>(info.st_size) < MAPPED_TRACE_HEADER_SIZE,
+                  filename << " is not a mapped trace file.");
+  m_mapSize = info.st_size;
+  void *map = mmap(0, m_mapSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  NS_ABORT_MSG_IF(map == MAP_FAILED, "Unable to map " << filename);
+  m_map = static_cast<uint8_t *>(map);
+
+  TraceFileHeader header;
+  std::memcpy(&header, m_map, sizeof(header));
+  header.format[sizeof(header.format) - 1] = '\0';
+  NS_ABORT_MSG_UNLESS(std::memcmp(header.magic, "NTTM", 4) == 0 &&
+                          header.version == TRACE_FILE_VERSION,
+                      filename << " is not a mapped trace file of this version.");
+  m_format = CreateTraceFormat(header.format);
+  NS_ABORT_MSG_UNLESS(m_format, "Unknown record format " << header.format);
+  m_recordSize = header.recordSize;
+  NS_ABORT_MSG_UNLESS(m_format->GetRecordSize() == m_recordSize,
+                      "Record size of " << filename << " does not match format "
+                                        << header.format);
+
+  MappedTraceState state;
+  std::memcpy(&state, m_map + sizeof(header), sizeof(state));
+  m_closed = state.closed;
+  // Only whole records that are in the file count, e.g. if it was cut
+  // after the run.
+  uint64_t present = std::min<uint64_t>(state.committed, m_mapSize - MAPPED_TRACE_HEADER_SIZE);
+  m_records = present / m_recordSize;
+}
+
+MappedTraceReader::~MappedTraceReader()
+{
+  NS_LOG_FUNCTION(this);
+  if (m_map)
+  {
+    munmap(m_map, m_mapSize);
+  }
+}
+
+Ptr<TraceFormat> MappedTraceReader::GetFormat(void) const
+{
+  return m_format;
+}
+
+bool MappedTraceReader::IsClosed(void) const
+{
+  return m_closed;
+}
+
+uint64_t MappedTraceReader::GetNRecords(void) const
+{
+  return m_records;
+}
+
+const uint8_t *MappedTraceReader::GetRecord(uint64_t i) const
+{
+  NS_ASSERT(i < m_records);
+  return m_map + MAPPED_TRACE_HEADER_SIZE + i * m_recordSize;
+}
+
+} // namespace ns3
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Memory-mapped trace files that stay readable if the simulation is killed.
+//
+// Layout: a header page of MAPPED_TRACE_HEADER_SIZE bytes with a
+// TraceFileHeader (magic "NTTM") followed by a MappedTraceState, then the
+// raw records. The file grows in preallocated steps, so it may end with
+// unused space; only the records up to the committed size are valid.
+
+#ifndef MAPPED_TRACE_H
+#define MAPPED_TRACE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/// Size of the header page, the records start at this offset.
+const uint32_t MAPPED_TRACE_HEADER_SIZE = 4096;
+
+#pragma pack(push, 1)
+/**
+ * \brief State following the TraceFileHeader of a mapped trace file.
+ */
+struct MappedTraceState
+{
+  uint64_t committed; //!< Bytes of complete records after the header page
+  uint8_t closed;     //!< 1 once the output was closed
+};
+#pragma pack(pop)
+
+/**
+ * \brief Trace output copying the records into a memory-mapped file.
+ *
+ * Write() only copies the record and then advances the committed size in
+ * the header page, so there are no system calls on the hot path and the
+ * kernel writes the pages back on its own. If the process is killed, the
+ * file holds every record committed before, see MappedTraceReader. The
+ * mapping is extended by growSize bytes whenever it is full; Close()
+ * truncates the file to the committed records.
+ */
+class MappedTraceOutput : public TraceOutput
+{
+public:
+  /**
+   * \param filename the file to create
+   * \param format the format of the records written to this output
+   * \param growSize bytes the file is extended by when it is full
+   */
+  MappedTraceOutput(std::string filename, Ptr<const TraceFormat> format,
+                    uint64_t growSize = 64 << 20);
+  virtual ~MappedTraceOutput();
+
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+private:
+  /// Extend the file and the mapping by m_growSize bytes.
+  void Grow(void);
+
+  uint32_t m_recordSize;     //!< Cached record size
+  uint64_t m_growSize;       //!< Bytes to extend the file by
+  int m_fd;                  //!< The file, -1 once closed
+  uint8_t *m_map;            //!< Mapping of the whole file
+  uint64_t m_mapSize;        //!< Size of the file and the mapping
+  MappedTraceState *m_state; //!< State in the header page
+  uint64_t m_used;           //!< Bytes of records written
+};
+
+/**
+ * \brief Reader for files written by MappedTraceOutput, also of runs that
+ *        were killed before closing the output.
+ */
+class MappedTraceReader
+{
+public:
+  /**
+   * \brief Map a file. Aborts if it is not a mapped trace file.
+   * \param filename the file to read
+   */
+  MappedTraceReader(std::string filename);
+  ~MappedTraceReader();
+
+  /**
+   * \return the format of the records
+   */
+  Ptr<TraceFormat> GetFormat(void) const;
+  /**
+   * \return true if the output was closed, false if the run ended early
+   */
+  bool IsClosed(void) const;
+  /**
+   * \return the number of committed records present in the file
+   */
+  uint64_t GetNRecords(void) const;
+  /**
+   * \param i the record index, below GetNRecords()
+   * \return the record
+   */
+  const uint8_t *GetRecord(uint64_t i) const;
+
+private:
+  Ptr<TraceFormat> m_format; //!< Format of the records
+  uint32_t m_recordSize;     //!< Size of one record
+  bool m_closed;             //!< Whether the output was closed
+  uint64_t m_records;        //!< Committed records in the file
+  uint8_t *m_map;            //!< Mapping of the whole file
+  uint64_t m_mapSize;        //!< Size of the mapping
+};
+
+} // namespace ns3
+
+#endif /* MAPPED_TRACE_H */
@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/experiment-tags.h"
+
+#include "message-tracker.h"
+#include "packet-header-view.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("MessageTracker");
+
+// ns-3 TCP starts every connection at sequence number 0, so the first data
+// byte after the SYN has sequence number 1.
+static const uint32_t FIRST_DATA_SEQUENCE = 1;
+
+static uint64_t TagKey(const IdTag &tag)
+{
+  return (static_cast<uint64_t>(tag.GetWorkload()) << 32) | tag.GetApplication();
+}
+
+static uint64_t AddressKey(Ipv4Address source, Ipv4Address destination)
+{
+  return (static_cast<uint64_t>(source.Get()) << 32) | destination.Get();
+}
+
+static uint32_t PortKey(uint16_t sourcePort, uint16_t destinationPort)
+{
+  return (static_cast<uint32_t>(sourcePort) << 16) | destinationPort;
+}
+
+MessageTracker::MessageTracker(Ptr<TraceOutput> output)
+    : m_output(output),
+      m_completed(0),
+      m_incomplete(0)
+{
+  NS_LOG_FUNCTION(this << output);
+}
+
+void MessageTracker::Started(Ptr<const Packet> p, const Address &local, const Address &peer)
+{
+  IdTag idTag;
+  MessageTag messageTag;
+  if (!p->PeekPacketTag(idTag) || !p->PeekPacketTag(messageTag))
+  {
+    NS_LOG_WARN("Message without IdTag or MessageTag");
+    return;
+  }
+  if (!InetSocketAddress::IsMatchingType(local) || !InetSocketAddress::IsMatchingType(peer))
+  {
+    NS_LOG_WARN("Message of a socket that is not IPv4");
+    return;
+  }
+  if (p->GetSize() == 0)
+  {
+    return;
+  }
+  InetSocketAddress source = InetSocketAddress::ConvertFrom(local);
+  InetSocketAddress destination = InetSocketAddress::ConvertFrom(peer);
+  Flow &flow = m_flows[FlowKey(TagKey(idTag), AddressKey(source.GetIpv4(), destination.GetIpv4()),
+                               PortKey(source.GetPort(), destination.GetPort()))];
+  Entry &entry = flow.messages[messageTag.GetSimpleValue()];
+  entry.start = Simulator::Now().GetNanoSeconds();
+  entry.size = p->GetSize();
+  flow.started += entry.size;
+  entry.end = flow.started;
+  entry.received = 0;
+  entry.packets = 0;
+}
+
+void MessageTracker::Received(Ptr<const Packet> p)
+{
+  IdTag idTag;
+  MessageTag messageTag;
+  if (!p->PeekPacketTag(idTag) || !p->PeekPacketTag(messageTag))
+  {
+    return;
+  }
+  PacketHeaderView header(p);
+  uint32_t bytes = header.GetDataSize();
+  if (bytes == 0)
+  {
+    return;
+  }
+  // Fragments after the first of a datagram have no ports.
+  uint64_t datagram = (static_cast<uint64_t>(header.GetSource().Get()) << 16) |
+                      header.GetIdentification();
+  FlowKey key;
+  if (header.IsTcp() || header.IsUdp())
+  {
+    key = FlowKey(TagKey(idTag), AddressKey(header.GetSource(), header.GetDestination()),
+                  PortKey(header.GetSourcePort(), header.GetDestinationPort()));
+  }
+  else
+  {
+    auto fragment = m_datagrams.find(datagram);
+    if (fragment == m_datagrams.end())
+    {
+      return;
+    }
+    key = fragment->second;
+  }
+  auto flow = m_flows.find(key);
+  if (flow == m_flows.end())
+  {
+    // Started before the tracker was connected.
+    return;
+  }
+  if (header.IsTcp())
+  {
+    DeliverSegment(key, flow->second, header.GetSequenceNumber(), bytes);
+    return;
+  }
+
+  // A datagram holds (a piece of) the message of its tags only.
+  auto it = flow->second.messages.find(messageTag.GetSimpleValue());
+  if (it == flow->second.messages.end())
+  {
+    m_datagrams.erase(datagram);
+    return;
+  }
+  Entry &entry = it->second;
+  entry.received += std::min(bytes, entry.size - entry.received);
+  ++entry.packets;
+  if (entry.received == entry.size)
+  {
+    Complete(key, it->first, entry);
+    flow->second.messages.erase(it);
+    m_datagrams.erase(datagram);
+  }
+  else if (header.IsUdp())
+  {
+    // The rest of the datagram may follow in fragments.
+    m_datagrams[datagram] = key;
+  }
+}
+
+void MessageTracker::DeliverSegment(const FlowKey &key, Flow &flow, uint32_t sequence,
+                                    uint32_t bytes)
+{
+  // Unwrap the 32 bit sequence number next to the delivered range.
+  uint32_t relative = sequence - FIRST_DATA_SEQUENCE;
+  int64_t ahead = static_cast<int32_t>(relative - static_cast<uint32_t>(flow.delivered));
+  if (ahead < 0 && static_cast<uint64_t>(-ahead) > flow.delivered)
+  {
+    return;
+  }
+  uint64_t begin = std::max(flow.delivered + ahead, flow.delivered);
+  uint64_t end = flow.delivered + ahead + bytes;
+  if (end <= begin)
+  {
+    // A retransmission of delivered bytes.
+    return;
+  }
+
+  // Merge the range with the ones received out of order.
+  std::map<uint64_t, uint64_t> &pending = flow.pending;
+  uint64_t mergedBegin = begin;
+  uint64_t mergedEnd = end;
+  auto next = pending.upper_bound(begin);
+  if (next != pending.begin())
+  {
+    auto previous = std::prev(next);
+    if (previous->second >= end)
+    {
+      // Received already.
+      return;
+    }
+    if (previous->second >= begin)
+    {
+      mergedBegin = previous->first;
+      pending.erase(previous);
+    }
+  }
+  while (next != pending.end() && next->first <= mergedEnd)
+  {
+    mergedEnd = std::max(mergedEnd, next->second);
+    next = pending.erase(next);
+  }
+  pending[mergedBegin] = mergedEnd;
+  while (!pending.empty() && pending.begin()->first <= flow.delivered)
+  {
+    flow.delivered = std::max(flow.delivered, pending.begin()->second);
+    pending.erase(pending.begin());
+  }
+
+  // Count the packet for every message it holds bytes of.
+  for (auto it = flow.messages.begin(); it != flow.messages.end(); ++it)
+  {
+    Entry &entry = it->second;
+    if (entry.end - entry.size >= end)
+    {
+      break;
+    }
+    if (entry.end > begin)
+    {
+      ++entry.packets;
+    }
+  }
+  // Complete the messages the contiguous range now covers.
+  while (!flow.messages.empty() && flow.messages.begin()->second.end <= flow.delivered)
+  {
+    Complete(key, flow.messages.begin()->first, flow.messages.begin()->second);
+    flow.messages.erase(flow.messages.begin());
+  }
+}
+
+void MessageTracker::Complete(const FlowKey &flow, uint32_t message, const Entry &entry)
+{
+  MessageRecord record;
+  record.timestamp = Simulator::Now().GetNanoSeconds();
+  record.start = entry.start;
+  record.workload = std::get<0>(flow) >> 32;
+  record.application = std::get<0>(flow) & 0xffffffff;
+  record.message = message;
+  record.size = entry.size;
+  record.packets = entry.packets;
+  m_output->Write(&record);
+  ++m_completed;
+}
+
+void MessageTracker::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  for (auto &flow : m_flows)
+  {
+    m_incomplete += flow.second.messages.size();
+  }
+  m_flows.clear();
+  m_datagrams.clear();
+}
+
+uint64_t MessageTracker::GetCompleted(void) const
+{
+  return m_completed;
+}
+
+uint64_t MessageTracker::GetIncomplete(void) const
+{
+  return m_incomplete;
+}
+
+} // namespace ns3
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MESSAGE_TRACKER_H
+#define MESSAGE_TRACKER_H
+
+#include <stdint.h>
+#include <map>
+#include <tuple>
+
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/packet.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Tracks the bytes of every message delivered to the receivers and
+ *        writes one MessageRecord when a message is complete.
+ *
+ * Messages are identified by the IdTag (workload and application) and the
+ * MessageTag the CdfApplication adds, within the connection of the
+ * application: the drivers give the same IdTag to the applications of
+ * several senders and to the ones of a sender to different receivers, and
+ * each of them counts its messages and sequence numbers on its own. A
+ * connection is keyed by the source and destination addresses and ports,
+ * as seen in the headers of its packets.
+ *
+ * A TCP segment carries the tags of the first message it contains, so the
+ * bytes of a TCP connection are placed by sequence number instead: the
+ * messages of an application follow each other in the byte stream in the
+ * order they were started. Every flow keeps the contiguous range of the stream
+ * delivered so far and a short list of the ranges received out of order,
+ * and a message is complete once the contiguous range reaches its last
+ * byte. Retransmitted bytes are thus counted once and cannot complete
+ * other messages. Datagrams count only for the message of their tags; IP
+ * fragments without the UDP header are matched to the connection of the
+ * first fragment of their datagram.
+ *
+ * Only the state of messages in flight is kept, so the memory does not
+ * grow with the length of the simulation or the size of the messages.
+ */
+class MessageTracker : public SimpleRefCount<MessageTracker>
+{
+public:
+  /**
+   * \param output output of the MessageRecords
+   */
+  MessageTracker(Ptr<TraceOutput> output);
+
+  /**
+   * \brief Start a message, traced at the CdfApplication
+   *        TxMessageWithAddresses source.
+   * \param p the message, with IdTag and MessageTag
+   * \param local the address of the socket of the application, with the
+   *        source address of its packets
+   * \param peer the address the application sends to
+   */
+  void Started(Ptr<const Packet> p, const Address &local, const Address &peer);
+  /**
+   * \brief Count a packet arriving at a receiver, e.g. traced at MacRx.
+   * \param p the packet, starting with an Ethernet header
+   */
+  void Received(Ptr<const Packet> p);
+
+  /**
+   * \brief Count the messages that were not completed and forget them.
+   *        The output is not closed.
+   */
+  void Close(void);
+
+  /**
+   * \return the number of completed messages written
+   */
+  uint64_t GetCompleted(void) const;
+  /**
+   * \return the number of started messages that were not completed,
+   *         counted by Close()
+   */
+  uint64_t GetIncomplete(void) const;
+
+private:
+  /// A message in flight.
+  struct Entry
+  {
+    uint64_t start;    //!< Time the message was started
+    uint64_t end;      //!< Stream offset after the message
+    uint32_t size;     //!< Message size
+    uint32_t received; //!< Bytes of datagrams received so far
+    uint32_t packets;  //!< Packets with data of the message
+  };
+
+  /// A connection: the IdTag of the application, its addresses and its ports.
+  typedef std::tuple<uint64_t, uint64_t, uint32_t> FlowKey;
+
+  /// The messages of one connection.
+  struct Flow
+  {
+    uint64_t started;                     //!< Stream offset after the last message
+    uint64_t delivered;                   //!< Contiguous stream bytes received
+    std::map<uint64_t, uint64_t> pending; //!< Ranges received out of order, by start
+    std::map<uint32_t, Entry> messages;   //!< Messages in flight, by id
+  };
+
+  /**
+   * \brief Place a TCP segment in the stream of its flow.
+   * \param key the key of the flow
+   * \param flow the flow
+   * \param sequence the sequence number of the first byte
+   * \param bytes the data bytes
+   */
+  void DeliverSegment(const FlowKey &key, Flow &flow, uint32_t sequence, uint32_t bytes);
+  /**
+   * \brief Write the record of a completed message.
+   * \param flow the key of the flow
+   * \param message the message id
+   * \param entry the message
+   */
+  void Complete(const FlowKey &flow, uint32_t message, const Entry &entry);
+
+  Ptr<TraceOutput> m_output;               //!< Output of the records
+  std::map<FlowKey, Flow> m_flows;         //!< Flows by connection
+  std::map<uint64_t, FlowKey> m_datagrams; //!< Fragmented datagrams by source and IP id
+  uint64_t m_completed;                    //!< Written records
+  uint64_t m_incomplete;                   //!< Messages not completed
+};
+
+} // namespace ns3
+
+#endif /* MESSAGE_TRACKER_H */
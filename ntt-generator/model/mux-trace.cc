@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "mux-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("MuxTrace");
+
+/**
+ * \brief One stream of a MuxTraceOutput.
+ */
+class MuxStreamOutput : public TraceOutput
+{
+public:
+  MuxStreamOutput(Ptr<MuxTraceOutput> mux, uint16_t stream)
+      : m_mux(mux),
+        m_stream(stream)
+  {
+  }
+
+  virtual void Write(const void *record)
+  {
+    m_mux->Write(m_stream, record);
+  }
+
+  virtual void Close(void)
+  {
+  }
+
+private:
+  Ptr<MuxTraceOutput> m_mux; //!< The shared file
+  uint16_t m_stream;         //!< Id of this stream
+};
+
+MuxTraceOutput::MuxTraceOutput(std::string filename, uint32_t bufferSize)
+    : m_file(filename.c_str(), std::ios::out | std::ios::binary),
+      m_buffer(bufferSize),
+      m_used(0)
+{
+  NS_LOG_FUNCTION(this << filename << bufferSize);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open trace file " << filename);
+  TraceFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "NTTX", 4);
+  header.version = TRACE_FILE_VERSION;
+  std::strncpy(header.format, "mux", sizeof(header.format) - 1);
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+MuxTraceOutput::~MuxTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+Ptr<TraceOutput> MuxTraceOutput::AddStream(std::string name, Ptr<const TraceFormat> format)
+{
+  NS_LOG_FUNCTION(this << name);
+  NS_ABORT_MSG_IF(m_names.size() == MUX_DECLARATION, "Too many trace streams");
+  NS_ABORT_MSG_IF(name.empty() || name.size() > 255, "Invalid trace stream name " << name);
+  NS_ABORT_MSG_IF(std::find(m_names.begin(), m_names.end(), name) != m_names.end(),
+                  "Trace stream " << name << " is declared twice");
+  std::string formatName = format->GetName();
+  uint16_t stream = m_names.size();
+  uint16_t recordSize = format->GetRecordSize();
+  uint8_t nameLength = name.size();
+  uint8_t formatLength = formatName.size();
+  Append(&MUX_DECLARATION, sizeof(MUX_DECLARATION));
+  Append(&stream, sizeof(stream));
+  Append(&recordSize, sizeof(recordSize));
+  Append(&nameLength, sizeof(nameLength));
+  Append(name.data(), nameLength);
+  Append(&formatLength, sizeof(formatLength));
+  Append(formatName.data(), formatLength);
+  m_names.push_back(name);
+  m_recordSizes.push_back(recordSize);
+  return Create<MuxStreamOutput>(this, stream);
+}
+
+void MuxTraceOutput::Write(uint16_t stream, const void *record)
+{
+  NS_ASSERT_MSG(m_file.is_open(), "Write to a closed trace output");
+  NS_ASSERT(stream < m_recordSizes.size());
+  uint32_t recordSize = m_recordSizes[stream];
+  if (m_used + sizeof(stream) + recordSize <= m_buffer.size())
+  {
+    std::memcpy(&m_buffer[m_used], &stream, sizeof(stream));
+    std::memcpy(&m_buffer[m_used + sizeof(stream)], record, recordSize);
+    m_used += sizeof(stream) + recordSize;
+    return;
+  }
+  Append(&stream, sizeof(stream));
+  Append(record, recordSize);
+}
+
+uint16_t MuxTraceOutput::GetNStreams(void) const
+{
+  return m_names.size();
+}
+
+void MuxTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (m_file.is_open())
+  {
+    Flush();
+    m_file.close();
+  }
+}
+
+void MuxTraceOutput::Append(const void *data, uint32_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  while (size > 0)
+  {
+    if (m_used == m_buffer.size())
+    {
+      Flush();
+    }
+    uint32_t chunk = std::min<uint32_t>(size, m_buffer.size() - m_used);
+    std::memcpy(&m_buffer[m_used], bytes, chunk);
+    m_used += chunk;
+    bytes += chunk;
+    size -= chunk;
+  }
+}
+
+void MuxTraceOutput::Flush(void)
+{
+  m_file.write(reinterpret_cast<const char *>(m_buffer.data()), m_used);
+  m_used = 0;
+}
+
+MuxTraceReader::MuxTraceReader(std::string filename)
+    : m_filename(filename),
+      m_file(filename.c_str(), std::ios::in | std::ios::binary)
+{
+  NS_LOG_FUNCTION(this << filename);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open " << filename);
+  TraceFileHeader header;
+  NS_ABORT_MSG_UNLESS(m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) &&
+                          std::memcmp(header.magic, "NTTX", 4) == 0 &&
+                          header.version == TRACE_FILE_VERSION,
+                      filename << " is not a multiplexed trace file of this version.");
+}
+
+bool MuxTraceReader::Next(uint16_t &stream)
+{
+  while (m_file.read(reinterpret_cast<char *>(&stream), sizeof(stream)))
+  {
+    if (stream == MUX_DECLARATION)
+    {
+      ReadDeclaration();
+      continue;
+    }
+    NS_ABORT_MSG_UNLESS(stream < m_formats.size(),
+                        "Record of an undeclared stream in " << m_filename);
+    m_record.resize(m_formats[stream]->GetRecordSize());
+    // A record cut off at the end of the file is not returned.
+    return static_cast<bool>(
+        m_file.read(reinterpret_cast<char *>(m_record.data()), m_record.size()));
+  }
+  return false;
+}
+
+void MuxTraceReader::ReadDeclaration(void)
+{
+  uint16_t stream;
+  uint16_t recordSize;
+  uint8_t length;
+  std::string name;
+  std::string format;
+  m_file.read(reinterpret_cast<char *>(&stream), sizeof(stream));
+  m_file.read(reinterpret_cast<char *>(&recordSize), sizeof(recordSize));
+  m_file.read(reinterpret_cast<char *>(&length), sizeof(length));
+  name.resize(length);
+  m_file.read(&name[0], length);
+  m_file.read(reinterpret_cast<char *>(&length), sizeof(length));
+  format.resize(length);
+  m_file.read(&format[0], length);
+  NS_ABORT_MSG_UNLESS(m_file && stream == m_formats.size(),
+                      "Invalid stream declaration in " << m_filename);
+  Ptr<TraceFormat> traceFormat = CreateTraceFormat(format);
+  NS_ABORT_MSG_UNLESS(traceFormat, "Unknown record format " << format);
+  NS_ABORT_MSG_UNLESS(traceFormat->GetRecordSize() == recordSize,
+                      "Record size of stream " << name << " does not match format "
+                                               << format);
+  m_names.push_back(name);
+  m_formats.push_back(traceFormat);
+}
+
+const uint8_t *MuxTraceReader::GetRecord(void) const
+{
+  return m_record.data();
+}
+
+uint16_t MuxTraceReader::GetNStreams(void) const
+{
+  return m_names.size();
+}
+
+std::string MuxTraceReader::GetName(uint16_t stream) const
+{
+  NS_ASSERT(stream < m_names.size());
+  return m_names[stream];
+}
+
+Ptr<TraceFormat> MuxTraceReader::GetFormat(uint16_t stream) const
+{
+  NS_ASSERT(stream < m_formats.size());
+  return m_formats[stream];
+}
+
+} // namespace ns3
@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Several record streams of different formats in one file.
+//
+// Layout: a TraceFileHeader (magic "NTTX", format "mux", record size 0)
+// followed by frames. A frame starts with a uint16 stream id, all fields
+// are in host byte order. Stream ids are assigned in order from 0; a frame
+// with the id MUX_DECLARATION declares the next stream:
+//
+//   uint16 MUX_DECLARATION, uint16 id, uint16 record size,
+//   uint8 name length, name, uint8 format length, format name
+//
+// Every other frame is followed by one raw record of its stream. A stream
+// is declared before its first record.
+
+#ifndef MUX_TRACE_H
+#define MUX_TRACE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/// Stream id of the frames declaring a stream.
+const uint16_t MUX_DECLARATION = 0xffff;
+
+/**
+ * \brief Writes the records of many streams into one buffered file.
+ *
+ * Each stream is a TraceOutput, so the usual trace sinks can write to it;
+ * writing a record only copies it with its stream id into the buffer.
+ * Closing a stream does nothing, the file is written until Close().
+ */
+class MuxTraceOutput : public SimpleRefCount<MuxTraceOutput>
+{
+public:
+  /**
+   * \param filename the file to create
+   * \param bufferSize bytes collected before they are written to the file
+   */
+  MuxTraceOutput(std::string filename, uint32_t bufferSize = 1 << 20);
+  ~MuxTraceOutput();
+
+  /**
+   * \brief Declare a stream. Aborts if the name is used already.
+   * \param name the name of the stream, at most 255 characters
+   * \param format the format of its records
+   * \return the output writing records of the stream
+   */
+  Ptr<TraceOutput> AddStream(std::string name, Ptr<const TraceFormat> format);
+
+  /**
+   * \param stream a stream id returned in order by AddStream
+   * \param record the record of the stream to copy
+   */
+  void Write(uint16_t stream, const void *record);
+
+  /**
+   * \return the number of declared streams
+   */
+  uint16_t GetNStreams(void) const;
+
+  /**
+   * \brief Write the buffered frames and close the file.
+   */
+  void Close(void);
+
+private:
+  /// Append bytes to the buffer, writing it out when it is full.
+  void Append(const void *data, uint32_t size);
+  /// Write the buffer to the file.
+  void Flush(void);
+
+  std::ofstream m_file;                //!< The output file
+  std::vector<uint8_t> m_buffer;       //!< Frames not yet written
+  uint32_t m_used;                     //!< Bytes used in the buffer
+  std::vector<uint32_t> m_recordSizes; //!< Record size of every stream
+  std::vector<std::string> m_names;    //!< Name of every stream
+};
+
+/**
+ * \brief Sequential reader of the files written by MuxTraceOutput.
+ */
+class MuxTraceReader
+{
+public:
+  /**
+   * \brief Open a file. Aborts if it is not a multiplexed trace file.
+   * \param filename the file to read
+   */
+  MuxTraceReader(std::string filename);
+
+  /**
+   * \brief Read the next record, handling stream declarations on the way.
+   * \param stream the stream id of the record
+   * \return false at the end of the file
+   */
+  bool Next(uint16_t &stream);
+  /**
+   * \return the record read by the last successful Next()
+   */
+  const uint8_t *GetRecord(void) const;
+
+  /**
+   * \return the number of streams declared so far
+   */
+  uint16_t GetNStreams(void) const;
+  /**
+   * \param stream a declared stream id
+   * \return the name of the stream
+   */
+  std::string GetName(uint16_t stream) const;
+  /**
+   * \param stream a declared stream id
+   * \return the format of its records
+   */
+  Ptr<TraceFormat> GetFormat(uint16_t stream) const;
+
+private:
+  /// Read a declaration frame after its id.
+  void ReadDeclaration(void);
+
+  std::string m_filename;                  //!< The file, for messages
+  std::ifstream m_file;                    //!< The input file
+  std::vector<uint8_t> m_record;           //!< The last record read
+  std::vector<std::string> m_names;        //!< Name of every stream
+  std::vector<Ptr<TraceFormat>> m_formats; //!< Format of every stream
+};
+
+} // namespace ns3
+
+#endif /* MUX_TRACE_H */
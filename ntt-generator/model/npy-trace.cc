@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "npy-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("NpyTrace");
+
+// Records are written to the file in pieces of about this size.
+static const size_t BUFFER_SIZE = 1 << 20;
+
+NpyTraceOutput::NpyTraceOutput(std::string filename, std::string descr,
+                               uint32_t recordSize, std::vector<uint32_t> recordShape)
+    : m_descr(descr),
+      m_recordSize(recordSize),
+      m_recordShape(recordShape),
+      m_records(0)
+{
+  NS_LOG_FUNCTION(this << filename << descr << recordSize);
+  m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open trace file " << filename);
+  std::string header = MakeHeader(0);
+  m_file.write(header.data(), header.size());
+  m_buffer.reserve(BUFFER_SIZE + m_recordSize);
+}
+
+NpyTraceOutput::~NpyTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void NpyTraceOutput::Write(const void *record)
+{
+  NS_ASSERT_MSG(m_file.is_open(), "Write to a closed trace output");
+  const uint8_t *data = static_cast<const uint8_t *>(record);
+  m_buffer.insert(m_buffer.end(), data, data + m_recordSize);
+  ++m_records;
+  if (m_buffer.size() >= BUFFER_SIZE)
+  {
+    m_file.write(reinterpret_cast<const char *>(m_buffer.data()), m_buffer.size());
+    m_buffer.clear();
+  }
+}
+
+void NpyTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (!m_file.is_open())
+  {
+    return;
+  }
+  m_file.write(reinterpret_cast<const char *>(m_buffer.data()), m_buffer.size());
+  m_buffer.clear();
+  std::string header = MakeHeader(m_records);
+  m_file.seekp(0);
+  m_file.write(header.data(), header.size());
+  m_file.close();
+}
+
+uint64_t NpyTraceOutput::GetRecords(void) const
+{
+  return m_records;
+}
+
+std::string NpyTraceOutput::MakeHeader(uint64_t rows) const
+{
+  std::string count = std::to_string(rows);
+  std::ostringstream shape;
+  shape << '(' << count << ',';
+  for (uint32_t i = 0; i < m_recordShape.size(); ++i)
+  {
+    shape << (i ? ", " : " ") << m_recordShape[i];
+  }
+  shape << ')';
+  std::string dict = "{'descr': " + m_descr + ", 'fortran_order': False, 'shape': " +
+                     shape.str() + ", }";
+
+  // Leave room for the longest row count, so that the final header has
+  // the same size. The header ends with a newline, and the data starts at
+  // a multiple of 64 bytes.
+  size_t reserved = dict.size() - count.size() + 20;
+  bool large = 10 + reserved + 1 > 0xffff;
+  size_t prefix = large ? 12 : 10;
+  size_t length = (prefix + reserved + 1 + 63) / 64 * 64 - prefix;
+  dict.resize(length - 1, ' ');
+  dict += '\n';
+
+  std::string header("\x93NUMPY", 6);
+  header += static_cast<char>(large ? 2 : 1);
+  header += '\0';
+  for (uint32_t i = 0; i < (large ? 4u : 2u); ++i)
+  {
+    header += static_cast<char>((length >> (8 * i)) & 0xff);
+  }
+  return header + dict;
+}
+
+std::string QuoteNpyName(const std::string &name)
+{
+  std::string quoted = "'";
+  for (char c : name)
+  {
+    if (c == '\'' || c == '\\')
+    {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "'";
+}
+
+} // namespace ns3
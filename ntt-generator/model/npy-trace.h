@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NPY_TRACE_H
+#define NPY_TRACE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Trace output writing the records as a numpy array (.npy), to be
+ *        loaded with numpy.load.
+ *
+ * The array has one row per record. The header is written with room for
+ * any number of rows and updated with the final shape by Close().
+ */
+class NpyTraceOutput : public TraceOutput
+{
+public:
+  /**
+   * \param filename the file to create
+   * \param descr numpy description of the data type of one element, e.g.
+   *        "'<f4'" or "[('time', '<f8'), ('size', '<u4')]"
+   * \param recordSize size of one record in bytes
+   * \param recordShape shape of the elements of one record, empty if a
+   *        record is a single element
+   */
+  NpyTraceOutput(std::string filename, std::string descr, uint32_t recordSize,
+                 std::vector<uint32_t> recordShape = std::vector<uint32_t>());
+  virtual ~NpyTraceOutput();
+
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+  /**
+   * \return the number of records written so far
+   */
+  uint64_t GetRecords(void) const;
+
+private:
+  /**
+   * \param rows the number of rows
+   * \return the header for an array of rows records
+   */
+  std::string MakeHeader(uint64_t rows) const;
+
+  std::string m_descr;                 //!< numpy data type
+  uint32_t m_recordSize;               //!< Size of one record
+  std::vector<uint32_t> m_recordShape; //!< Shape of one record
+  uint64_t m_records;                  //!< Written records
+  std::vector<uint8_t> m_buffer;       //!< Records not yet written
+  std::ofstream m_file;                //!< The output file
+};
+
+/**
+ * \param name a field name
+ * \return the name quoted for a numpy data type description
+ */
+std::string QuoteNpyName(const std::string &name);
+
+} // namespace ns3
+
+#endif /* NPY_TRACE_H */
@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+
+#include "packet-header-view.h"
+
+namespace ns3
+{
+
+// Offsets in an Ethernet II frame carrying IPv4.
+static const uint32_t ETHER_TYPE = 12;
+static const uint32_t IPV4 = 14;
+static const uint16_t ETHER_TYPE_IPV4 = 0x0800;
+
+PacketHeaderView::PacketHeaderView(Ptr<const Packet> p)
+    : m_ipv4(false),
+      m_l4(0)
+{
+  uint32_t size = p->CopyData(m_data, MAX_HEADER_SIZE);
+  std::memset(m_data + size, 0, MAX_HEADER_SIZE - size);
+
+  if (size < IPV4 + 20 || Read16(ETHER_TYPE) != ETHER_TYPE_IPV4 ||
+      (m_data[IPV4] >> 4) != 4)
+  {
+    return;
+  }
+  m_ipv4 = true;
+  uint32_t l4 = IPV4 + (m_data[IPV4] & 0x0f) * 4;
+  uint8_t protocol = GetProtocol();
+  // Only the first fragment carries the transport header.
+  bool first = (Read16(IPV4 + 6) & 0x1fff) == 0;
+  if (first && ((protocol == 6 && size >= l4 + 20) || (protocol == 17 && size >= l4 + 8)))
+  {
+    m_l4 = l4;
+  }
+}
+
+bool PacketHeaderView::IsIpv4(void) const
+{
+  return m_ipv4;
+}
+
+bool PacketHeaderView::IsTcp(void) const
+{
+  return m_l4 != 0 && GetProtocol() == 6;
+}
+
+bool PacketHeaderView::IsUdp(void) const
+{
+  return m_l4 != 0 && GetProtocol() == 17;
+}
+
+uint16_t PacketHeaderView::GetIdentification(void) const
+{
+  return m_ipv4 ? Read16(IPV4 + 4) : 0;
+}
+
+uint8_t PacketHeaderView::GetDscp(void) const
+{
+  return m_ipv4 ? m_data[IPV4 + 1] >> 2 : 0;
+}
+
+uint8_t PacketHeaderView::GetEcn(void) const
+{
+  return m_ipv4 ? m_data[IPV4 + 1] & 0x03 : 0;
+}
+
+uint8_t PacketHeaderView::GetTtl(void) const
+{
+  return m_ipv4 ? m_data[IPV4 + 8] : 0;
+}
+
+uint8_t PacketHeaderView::GetProtocol(void) const
+{
+  return m_ipv4 ? m_data[IPV4 + 9] : 0;
+}
+
+uint16_t PacketHeaderView::GetPayloadSize(void) const
+{
+  if (!m_ipv4)
+  {
+    return 0;
+  }
+  return Read16(IPV4 + 2) - (m_data[IPV4] & 0x0f) * 4;
+}
+
+uint16_t PacketHeaderView::GetDataSize(void) const
+{
+  uint16_t payload = GetPayloadSize();
+  if (IsTcp())
+  {
+    return payload - (m_data[m_l4 + 12] >> 4) * 4;
+  }
+  if (IsUdp())
+  {
+    return payload - 8;
+  }
+  return payload;
+}
+
+Ipv4Address PacketHeaderView::GetSource(void) const
+{
+  return Ipv4Address(m_ipv4 ? Read32(IPV4 + 12) : 0);
+}
+
+Ipv4Address PacketHeaderView::GetDestination(void) const
+{
+  return Ipv4Address(m_ipv4 ? Read32(IPV4 + 16) : 0);
+}
+
+uint16_t PacketHeaderView::GetSourcePort(void) const
+{
+  return m_l4 ? Read16(m_l4) : 0;
+}
+
+uint16_t PacketHeaderView::GetDestinationPort(void) const
+{
+  return m_l4 ? Read16(m_l4 + 2) : 0;
+}
+
+uint32_t PacketHeaderView::GetSequenceNumber(void) const
+{
+  return IsTcp() ? Read32(m_l4 + 4) : 0;
+}
+
+uint32_t PacketHeaderView::GetAckNumber(void) const
+{
+  return IsTcp() ? Read32(m_l4 + 8) : 0;
+}
+
+uint8_t PacketHeaderView::GetFlags(void) const
+{
+  return IsTcp() ? m_data[m_l4 + 13] : 0;
+}
+
+uint16_t PacketHeaderView::GetWindowSize(void) const
+{
+  return IsTcp() ? Read16(m_l4 + 14) : 0;
+}
+
+uint16_t PacketHeaderView::Read16(uint32_t offset) const
+{
+  return (uint16_t(m_data[offset]) << 8) | m_data[offset + 1];
+}
+
+uint32_t PacketHeaderView::Read32(uint32_t offset) const
+{
+  return (uint32_t(m_data[offset]) << 24) | (uint32_t(m_data[offset + 1]) << 16) |
+         (uint32_t(m_data[offset + 2]) << 8) | m_data[offset + 3];
+}
+
+} // namespace ns3
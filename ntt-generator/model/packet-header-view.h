@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_HEADER_VIEW_H
+#define PACKET_HEADER_VIEW_H
+
+#include <stdint.h>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Read-only view of the Ethernet, IPv4 and TCP/UDP header fields
+ *        of a packet traced at a CsmaNetDevice.
+ *
+ * Instead of copying the packet and deserializing every header with
+ * RemoveHeader, the view copies only the first bytes of the packet buffer
+ * and reads the fields at their wire offsets. The packet is not modified.
+ *
+ * Only Ethernet II (DIX) framing is supported, which is the CsmaNetDevice
+ * default. Fields of a layer that is not present read as zero.
+ */
+class PacketHeaderView
+{
+public:
+  /**
+   * \param p the packet, starting with an Ethernet header
+   */
+  PacketHeaderView(Ptr<const Packet> p);
+
+  /**
+   * \return true if the packet carries IPv4
+   */
+  bool IsIpv4(void) const;
+  /**
+   * \return true if the packet carries TCP over IPv4
+   */
+  bool IsTcp(void) const;
+  /**
+   * \return true if the packet carries UDP over IPv4
+   */
+  bool IsUdp(void) const;
+
+  /**
+   * \return the IPv4 identification
+   */
+  uint16_t GetIdentification(void) const;
+  /**
+   * \return the IPv4 DSCP
+   */
+  uint8_t GetDscp(void) const;
+  /**
+   * \return the IPv4 ECN bits
+   */
+  uint8_t GetEcn(void) const;
+  /**
+   * \return the IPv4 TTL
+   */
+  uint8_t GetTtl(void) const;
+  /**
+   * \return the IPv4 protocol number
+   */
+  uint8_t GetProtocol(void) const;
+  /**
+   * \return the IPv4 payload size, i.e. total length minus header length
+   */
+  uint16_t GetPayloadSize(void) const;
+  /**
+   * \return the application data in the packet: the IPv4 payload without
+   *         the TCP or UDP header, all of it for non-first fragments
+   */
+  uint16_t GetDataSize(void) const;
+  /**
+   * \return the IPv4 source address
+   */
+  Ipv4Address GetSource(void) const;
+  /**
+   * \return the IPv4 destination address
+   */
+  Ipv4Address GetDestination(void) const;
+
+  /**
+   * \return the TCP or UDP source port
+   */
+  uint16_t GetSourcePort(void) const;
+  /**
+   * \return the TCP or UDP destination port
+   */
+  uint16_t GetDestinationPort(void) const;
+  /**
+   * \return the TCP sequence number
+   */
+  uint32_t GetSequenceNumber(void) const;
+  /**
+   * \return the TCP acknowledgement number
+   */
+  uint32_t GetAckNumber(void) const;
+  /**
+   * \return the TCP flags
+   */
+  uint8_t GetFlags(void) const;
+  /**
+   * \return the TCP window size, as carried in the header
+   */
+  uint16_t GetWindowSize(void) const;
+
+private:
+  /// Ethernet header, longest IPv4 header and fixed TCP header.
+  static const uint32_t MAX_HEADER_SIZE = 14 + 60 + 20;
+
+  /**
+   * \param offset offset in the copied bytes
+   * \return the big-endian 16 bit value at offset
+   */
+  uint16_t Read16(uint32_t offset) const;
+  /**
+   * \param offset offset in the copied bytes
+   * \return the big-endian 32 bit value at offset
+   */
+  uint32_t Read32(uint32_t offset) const;
+
+  uint8_t m_data[MAX_HEADER_SIZE]; //!< Start of the packet, zero padded
+  bool m_ipv4;                     //!< The packet carries IPv4
+  uint32_t m_l4;                   //!< Offset of the transport header, 0 if none
+};
+
+} // namespace ns3
+
+#endif /* PACKET_HEADER_VIEW_H */
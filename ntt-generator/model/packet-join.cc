@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include "packet-join.h"
+#include "packet-header-view.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PacketJoin");
+
+PacketJoin::PacketJoin(Ptr<TraceOutput> joined, Ptr<TraceOutput> dropped)
+    : m_joined(joined),
+      m_dropped(dropped),
+      m_joinedCount(0),
+      m_droppedCount(0),
+      m_inFlightCount(0),
+      m_unknownCount(0)
+{
+  NS_LOG_FUNCTION(this << joined << dropped);
+}
+
+void PacketJoin::Sent(uint32_t node, Ptr<const Packet> p)
+{
+  Entry &entry = m_sent[p->GetUid()];
+  entry.timestamp = Simulator::Now().GetNanoSeconds();
+  entry.node = node;
+  entry.size = p->GetSize();
+  entry.sequence = PacketHeaderView(p).GetSequenceNumber();
+}
+
+void PacketJoin::Received(Ptr<const Packet> p)
+{
+  auto it = m_sent.find(p->GetUid());
+  if (it == m_sent.end())
+  {
+    ++m_unknownCount;
+    return;
+  }
+  JoinedPacketRecord record;
+  if (MakePacketRecord(p, record.packet))
+  {
+    record.sentTimestamp = it->second.timestamp;
+    record.sender = it->second.node;
+    m_joined->Write(&record);
+    ++m_joinedCount;
+  }
+  m_sent.erase(it);
+}
+
+void PacketJoin::Dropped(Ptr<const Packet> p)
+{
+  auto it = m_sent.find(p->GetUid());
+  if (it == m_sent.end())
+  {
+    return;
+  }
+  if (m_dropped)
+  {
+    SenderRecord record;
+    record.timestamp = it->second.timestamp;
+    record.uid = it->first;
+    record.node = it->second.node;
+    record.size = it->second.size;
+    record.sequence = it->second.sequence;
+    m_dropped->Write(&record);
+  }
+  ++m_droppedCount;
+  m_sent.erase(it);
+}
+
+void PacketJoin::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  m_inFlightCount += m_sent.size();
+  m_sent.clear();
+}
+
+uint64_t PacketJoin::GetJoined(void) const
+{
+  return m_joinedCount;
+}
+
+uint64_t PacketJoin::GetDropped(void) const
+{
+  return m_droppedCount;
+}
+
+uint64_t PacketJoin::GetInFlight(void) const
+{
+  return m_inFlightCount;
+}
+
+uint64_t PacketJoin::GetUnknown(void) const
+{
+  return m_unknownCount;
+}
+
+} // namespace ns3
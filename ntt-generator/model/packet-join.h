@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_JOIN_H
+#define PACKET_JOIN_H
+
+#include <stdint.h>
+#include <unordered_map>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Joins the packets sent by the senders with the packets received
+ *        by the receivers, by packet uid.
+ *
+ * Sent packets are kept until they are received, then one
+ * JoinedPacketRecord is written. Only packets that MakePacketRecord
+ * accepts at the receiver are written, other received packets are just
+ * forgotten.
+ *
+ * A packet that is never received was either dropped on the way or still
+ * in flight when the simulation stopped. Dropped() takes the drops, e.g.
+ * traced at MacTxDrop of every device, and writes the SenderRecords of
+ * the sent packets among them. Close() only counts the packets still in
+ * flight.
+ */
+class PacketJoin : public SimpleRefCount<PacketJoin>
+{
+public:
+  /**
+   * \param joined output of the JoinedPacketRecords
+   * \param dropped output of the SenderRecords of the sent packets that
+   *        were dropped, may be 0
+   */
+  PacketJoin(Ptr<TraceOutput> joined, Ptr<TraceOutput> dropped);
+
+  /**
+   * \brief Remember a packet leaving a sender, e.g. traced at MacTx.
+   * \param node node id of the sender
+   * \param p the packet
+   */
+  void Sent(uint32_t node, Ptr<const Packet> p);
+  /**
+   * \brief Join a packet arriving at a receiver, e.g. traced at MacRx.
+   * \param p the packet, starting with an Ethernet header
+   */
+  void Received(Ptr<const Packet> p);
+  /**
+   * \brief Write a sent packet that was dropped, e.g. traced at MacTxDrop.
+   *        Drops of other packets are ignored.
+   * \param p the packet, starting with an Ethernet header
+   */
+  void Dropped(Ptr<const Packet> p);
+
+  /**
+   * \brief Count the packets that were sent but neither received nor
+   *        dropped as in flight. The outputs are not closed.
+   */
+  void Close(void);
+
+  /**
+   * \return the number of joined records written
+   */
+  uint64_t GetJoined(void) const;
+  /**
+   * \return the number of sent packets that were dropped
+   */
+  uint64_t GetDropped(void) const;
+  /**
+   * \return the number of sent packets still in flight, counted by
+   *         Close()
+   */
+  uint64_t GetInFlight(void) const;
+  /**
+   * \return the number of received packets that were not sent by a
+   *         sender
+   */
+  uint64_t GetUnknown(void) const;
+
+private:
+  /// What is kept of a sent packet.
+  struct Entry
+  {
+    uint64_t timestamp; //!< Time the packet was sent
+    uint32_t node;      //!< Node id of the sender
+    uint32_t size;      //!< Packet size
+    uint32_t sequence;  //!< TCP sequence number
+  };
+
+  Ptr<TraceOutput> m_joined;                   //!< Output of joined records
+  Ptr<TraceOutput> m_dropped;                  //!< Output of dropped packets
+  std::unordered_map<uint64_t, Entry> m_sent;  //!< Packets in flight, by uid
+  uint64_t m_joinedCount;                      //!< Joined records
+  uint64_t m_droppedCount;                     //!< Packets dropped
+  uint64_t m_inFlightCount;                    //!< Packets in flight at Close()
+  uint64_t m_unknownCount;                     //!< Packets not sent
+};
+
+} // namespace ns3
+
+#endif /* PACKET_JOIN_H */
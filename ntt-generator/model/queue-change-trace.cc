@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/config.h"
+#include "ns3/callback.h"
+#include "ns3/simulator.h"
+
+#include "queue-change-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("QueueChangeTrace");
+
+// Encoded entries are written to the file in pieces of about this size.
+static const size_t BUFFER_SIZE = 1 << 20;
+
+enum QueueChangeEntry
+{
+  QUEUE_CHANGE_PORT = 0,
+  QUEUE_CHANGE_GROUP = 1
+};
+
+static void AppendVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(value);
+}
+
+static void AppendSignedVarint(std::vector<uint8_t> &out, int64_t value)
+{
+  AppendVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+QueueChangeTraceOutput::QueueChangeTraceOutput(std::string filename, Time window)
+    : m_window(window.GetNanoSeconds()),
+      m_tick(0),
+      m_writtenTick(0)
+{
+  NS_LOG_FUNCTION(this << filename << window);
+  m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open trace file " << filename);
+
+  QueueRecordFormat format;
+  TraceFileHeader header;
+  MakeTraceFileHeader(format, header);
+  std::memcpy(header.magic, "NTTQ", 4);
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  uint64_t stored = window.GetNanoSeconds();
+  m_file.write(reinterpret_cast<const char *>(&stored), sizeof(stored));
+  m_buffer.reserve(BUFFER_SIZE + 64);
+}
+
+QueueChangeTraceOutput::~QueueChangeTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void QueueChangeTraceOutput::Write(const void *data)
+{
+  NS_ASSERT_MSG(m_file.is_open(), "Write to a closed trace output");
+  QueueRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  // Without a window, ticks are nanoseconds and every change is written
+  // on its own, also changes at the same nanosecond.
+  uint64_t tick = m_window == 0 ? record.timestamp : record.timestamp / m_window;
+  if (tick > m_tick)
+  {
+    FlushTick();
+    m_tick = tick;
+  }
+  Port &port = m_ports[GetPort(record.node, record.device)];
+  if (!port.dirty)
+  {
+    port.dirty = true;
+    m_dirty.push_back(&port - m_ports.data());
+  }
+  port.pending = record.value;
+  if (m_window == 0)
+  {
+    FlushTick();
+  }
+}
+
+void QueueChangeTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (!m_file.is_open())
+  {
+    return;
+  }
+  FlushTick();
+  FlushBuffer();
+  m_file.close();
+}
+
+uint32_t QueueChangeTraceOutput::GetPort(uint32_t node, uint32_t device)
+{
+  uint64_t key = (static_cast<uint64_t>(node) << 32) | device;
+  auto it = m_portIds.find(key);
+  if (it != m_portIds.end())
+  {
+    return it->second;
+  }
+  uint32_t id = m_ports.size();
+  m_portIds[key] = id;
+  m_ports.push_back(Port{0, 0, false});
+  AppendVarint(m_buffer, QUEUE_CHANGE_PORT);
+  AppendVarint(m_buffer, node);
+  AppendVarint(m_buffer, device);
+  return id;
+}
+
+void QueueChangeTraceOutput::FlushTick(void)
+{
+  // Changes that cancel out within the tick are dropped.
+  uint32_t changes = 0;
+  for (uint32_t id : m_dirty)
+  {
+    Port &port = m_ports[id];
+    port.dirty = false;
+    if (port.pending != port.written)
+    {
+      m_dirty[changes++] = id;
+    }
+  }
+  m_dirty.resize(changes);
+  if (m_dirty.empty())
+  {
+    return;
+  }
+
+  AppendVarint(m_buffer, QUEUE_CHANGE_GROUP);
+  AppendVarint(m_buffer, m_tick - m_writtenTick);
+  AppendVarint(m_buffer, m_dirty.size());
+  for (uint32_t id : m_dirty)
+  {
+    Port &port = m_ports[id];
+    AppendVarint(m_buffer, id);
+    AppendSignedVarint(m_buffer, static_cast<int64_t>(port.pending) - port.written);
+    port.written = port.pending;
+  }
+  m_dirty.clear();
+  m_writtenTick = m_tick;
+  if (m_buffer.size() >= BUFFER_SIZE)
+  {
+    FlushBuffer();
+  }
+}
+
+void QueueChangeTraceOutput::FlushBuffer(void)
+{
+  m_file.write(reinterpret_cast<const char *>(m_buffer.data()), m_buffer.size());
+  m_buffer.clear();
+}
+
+static void WriteQueueRecord(Ptr<TraceOutput> output, uint32_t node, uint32_t device,
+                             uint32_t oldValue, uint32_t newValue)
+{
+  QueueRecord record;
+  record.timestamp = Simulator::Now().GetNanoSeconds();
+  record.node = node;
+  record.device = device;
+  record.value = newValue;
+  output->Write(&record);
+}
+
+uint32_t ConnectQueueTrace(std::string path, Ptr<TraceOutput> output)
+{
+  std::string::size_type slash = path.rfind('/');
+  NS_ABORT_MSG_IF(slash == std::string::npos, "Invalid trace path " << path);
+  std::string source = path.substr(slash + 1);
+  Config::MatchContainer matches = Config::LookupMatches(path.substr(0, slash));
+  for (uint32_t i = 0; i < matches.GetN(); ++i)
+  {
+    uint32_t node;
+    uint32_t device;
+    NS_ABORT_MSG_UNLESS(ParseDeviceContext(matches.GetMatchedPath(i), node, device),
+                        "Not below a device: " << matches.GetMatchedPath(i));
+    bool connected = matches.Get(i)->TraceConnectWithoutContext(
+        source, MakeBoundCallback(&WriteQueueRecord, output, node, device));
+    NS_ABORT_MSG_UNLESS(connected, "No trace source " << source << " in "
+                                                      << matches.GetMatchedPath(i));
+  }
+  return matches.GetN();
+}
+
+} // namespace ns3
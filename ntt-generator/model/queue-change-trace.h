@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Change-compressed queue occupancy traces, read by ntt_trace.py.
+//
+// Layout: TraceFileHeader with magic "NTTQ" and format "queue", uint64
+// window in nanoseconds, then entries until the end of the file. All other
+// integers are LEB128 varints, signed ones zigzag encoded:
+//
+//   0 node device     defines the next port id, counting from 0
+//   1 ticks n changes n changes of the same tick, `ticks` windows (or
+//                     nanoseconds without a window) after the previous
+//                     group; a change is the port id and the signed
+//                     difference to the last value written for the port
+
+#ifndef QUEUE_CHANGE_TRACE_H
+#define QUEUE_CHANGE_TRACE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Trace output of QueueRecords writing only the changes of the
+ *        occupancy of every port.
+ *
+ * Ports get small ids in the order they first appear. With a window, all
+ * changes of a port within a window are coalesced into the occupancy at
+ * the end of the window, timestamped with the start of the window, and
+ * changes that cancel out are not written at all.
+ */
+class QueueChangeTraceOutput : public TraceOutput
+{
+public:
+  /**
+   * \param filename the file to create
+   * \param window the coalescing window, zero writes every change
+   */
+  QueueChangeTraceOutput(std::string filename, Time window = Time(0));
+  virtual ~QueueChangeTraceOutput();
+
+  /**
+   * \brief Write a change.
+   * \param record a QueueRecord, records must be in time order
+   */
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+private:
+  /// Occupancy of one port.
+  struct Port
+  {
+    uint32_t written; //!< Last value written
+    uint32_t pending; //!< Value at the end of the current tick
+    bool dirty;       //!< Changed in the current tick
+  };
+
+  /**
+   * \param node the node id
+   * \param device the device index
+   * \return the port id, defining it if it is new
+   */
+  uint32_t GetPort(uint32_t node, uint32_t device);
+  /// Write the changes of the current tick.
+  void FlushTick(void);
+  /// Write the encoded entries to the file.
+  void FlushBuffer(void);
+
+  uint64_t m_window;                                //!< Window in nanoseconds, 0 for none
+  uint64_t m_tick;                                  //!< Current tick
+  uint64_t m_writtenTick;                           //!< Tick of the last group
+  std::unordered_map<uint64_t, uint32_t> m_portIds; //!< Port ids by node and device
+  std::vector<Port> m_ports;                        //!< Ports by id
+  std::vector<uint32_t> m_dirty;                    //!< Ports changed in the current tick
+  std::vector<uint8_t> m_buffer;                    //!< Encoded entries
+  std::ofstream m_file;                             //!< The output file
+};
+
+/**
+ * \brief Connect PacketsInQueue-like trace sources to an output of
+ *        QueueRecords, without formatting a context for every change.
+ * \param path config path of the trace sources, the last element is the
+ *        name of the trace source and the others must match the objects
+ *        below a device, e.g. ".../$ns3::CsmaNetDevice/TxQueue/PacketsInQueue"
+ * \param output the output
+ * \return the number of connected trace sources
+ */
+uint32_t ConnectQueueTrace(std::string path, Ptr<TraceOutput> output);
+
+} // namespace ns3
+
+#endif /* QUEUE_CHANGE_TRACE_H */
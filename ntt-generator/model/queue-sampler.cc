@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+
+#include "queue-sampler.h"
+#include "npy-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("QueueSampler");
+
+QueueSampler::QueueSampler(Time interval)
+    : m_interval(interval)
+{
+  NS_LOG_FUNCTION(this << interval);
+  NS_ABORT_MSG_UNLESS(interval > Time(0), "The sampling interval must be positive");
+}
+
+void QueueSampler::AddQueue(Ptr<QueueBase> queue, std::string name)
+{
+  NS_LOG_FUNCTION(this << queue << name);
+  NS_ABORT_MSG_IF(m_output, "Queue added to a started sampler");
+  m_queues.push_back(queue);
+  m_names.push_back(name);
+}
+
+uint32_t QueueSampler::AddQueues(std::string path)
+{
+  NS_LOG_FUNCTION(this << path);
+  Config::MatchContainer matches = Config::LookupMatches(path);
+  for (uint32_t i = 0; i < matches.GetN(); ++i)
+  {
+    Ptr<QueueBase> queue = DynamicCast<QueueBase>(matches.Get(i));
+    NS_ABORT_MSG_UNLESS(queue, matches.GetMatchedPath(i) << " is not a queue");
+    AddQueue(queue, matches.GetMatchedPath(i) + "/PacketsInQueue");
+  }
+  return matches.GetN();
+}
+
+std::string QueueSampler::GetDescr(void) const
+{
+  std::string descr = "[('time', '<f8')";
+  for (const std::string &name : m_names)
+  {
+    descr += ", (" + QuoteNpyName(name) + ", '<u4')";
+  }
+  return descr + "]";
+}
+
+uint32_t QueueSampler::GetRowSize(void) const
+{
+  return sizeof(double) + m_queues.size() * sizeof(uint32_t);
+}
+
+void QueueSampler::Start(Ptr<TraceOutput> output)
+{
+  NS_LOG_FUNCTION(this << output);
+  m_output = output;
+  m_row.resize(GetRowSize());
+  Sample();
+}
+
+void QueueSampler::Sample(void)
+{
+  double time = Simulator::Now().GetSeconds();
+  std::memcpy(m_row.data(), &time, sizeof(time));
+  uint8_t *column = m_row.data() + sizeof(time);
+  for (const Ptr<QueueBase> &queue : m_queues)
+  {
+    uint32_t packets = queue->GetNPackets();
+    std::memcpy(column, &packets, sizeof(packets));
+    column += sizeof(packets);
+  }
+  m_output->Write(m_row.data());
+  Simulator::Schedule(m_interval, &QueueSampler::Sample, Ptr<QueueSampler>(this));
+}
+
+} // namespace ns3
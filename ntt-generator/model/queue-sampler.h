@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUEUE_SAMPLER_H
+#define QUEUE_SAMPLER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "ns3/queue.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Samples the occupancy of a set of queues at fixed intervals.
+ *
+ * Every interval, one row with the time in seconds (float64) and the
+ * number of packets in every queue (uint32) is written to an output,
+ * e.g. an NpyTraceOutput with the data type of GetDescr().
+ */
+class QueueSampler : public SimpleRefCount<QueueSampler>
+{
+public:
+  /**
+   * \param interval time between two samples
+   */
+  QueueSampler(Time interval);
+
+  /**
+   * \brief Add a queue.
+   * \param queue the queue
+   * \param name name of the column of the queue
+   */
+  void AddQueue(Ptr<QueueBase> queue, std::string name);
+  /**
+   * \brief Add all queues matching a config path. The columns are named
+   *        like the PacketsInQueue trace sources of the queues.
+   * \param path config path of the queues, e.g.
+   *        "/NodeList/6/DeviceList/0/$ns3::CsmaNetDevice/TxQueue"
+   * \return the number of added queues
+   */
+  uint32_t AddQueues(std::string path);
+
+  /**
+   * \return the numpy data type of a row
+   */
+  std::string GetDescr(void) const;
+  /**
+   * \return the size of a row in bytes
+   */
+  uint32_t GetRowSize(void) const;
+
+  /**
+   * \brief Write a row now and then every interval, until the simulation
+   *        stops. No queue can be added afterwards.
+   * \param output the output of the rows
+   */
+  void Start(Ptr<TraceOutput> output);
+
+private:
+  /// Write a row and schedule the next one.
+  void Sample(void);
+
+  Time m_interval;                      //!< Time between two samples
+  std::vector<Ptr<QueueBase>> m_queues; //!< The queues
+  std::vector<std::string> m_names;     //!< Column names of the queues
+  std::vector<uint8_t> m_row;           //!< Row being written
+  Ptr<TraceOutput> m_output;            //!< Output of the rows
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_SAMPLER_H */
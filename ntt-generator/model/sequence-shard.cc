@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/nstime.h"
+#include "ns3/trace-record.h"
+
+#include "sequence-shard.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("SequenceShard");
+
+SequenceShardTraceOutput::SequenceShardTraceOutput(std::string basename, uint32_t length,
+                                                   uint32_t stride, uint32_t shardSize)
+    : m_basename(basename),
+      m_length(length),
+      m_stride(stride),
+      m_shardSize(shardSize),
+      m_rows(static_cast<size_t>(length) * SEQUENCE_FEATURES),
+      m_sequence(m_rows.size()),
+      m_packets(0),
+      m_sequences(0),
+      m_shards(0),
+      m_closed(false)
+{
+  NS_LOG_FUNCTION(this << basename << length << stride << shardSize);
+  NS_ABORT_MSG_UNLESS(length > 0 && stride > 0 && shardSize > 0,
+                      "Sequence length, stride and shard size must be positive");
+}
+
+SequenceShardTraceOutput::~SequenceShardTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void SequenceShardTraceOutput::Write(const void *data)
+{
+  NS_ASSERT_MSG(!m_closed, "Write to a closed trace output");
+  PacketRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  uint32_t slot = m_packets % m_length;
+  double *row = &m_rows[static_cast<size_t>(slot) * SEQUENCE_FEATURES];
+  row[0] = NanoSeconds(record.timestamp).GetSeconds();
+  row[1] = record.size;
+  row[2] = NanoSeconds(record.delay).GetSeconds();
+  row[3] = record.workload;
+  row[4] = record.application;
+  row[5] = record.message;
+  ++m_packets;
+  if (m_packets < m_length || (m_packets - m_length) % m_stride != 0)
+  {
+    return;
+  }
+
+  // The oldest row is the one after the newest.
+  size_t split = static_cast<size_t>((slot + 1) % m_length) * SEQUENCE_FEATURES;
+  std::copy(m_rows.begin() + split, m_rows.end(), m_sequence.begin());
+  std::copy(m_rows.begin(), m_rows.begin() + split, m_sequence.end() - split);
+  if (!m_shard)
+  {
+    char index[16];
+    std::snprintf(index, sizeof(index), "_%05u.npy", m_shards++);
+    m_shard = Create<NpyTraceOutput>(m_basename + index, "'<f8'",
+                                     m_sequence.size() * sizeof(double),
+                                     std::vector<uint32_t>{m_length, SEQUENCE_FEATURES});
+  }
+  m_shard->Write(m_sequence.data());
+  ++m_sequences;
+  if (m_shard->GetRecords() == m_shardSize)
+  {
+    m_shard->Close();
+    m_shard = 0;
+  }
+}
+
+void SequenceShardTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (m_closed)
+  {
+    return;
+  }
+  m_closed = true;
+  if (m_shard)
+  {
+    m_shard->Close();
+    m_shard = 0;
+  }
+  NS_LOG_INFO("Wrote " << m_sequences << " sequences to " << m_shards << " shards");
+}
+
+uint64_t SequenceShardTraceOutput::GetSequences(void) const
+{
+  return m_sequences;
+}
+
+uint32_t SequenceShardTraceOutput::GetShards(void) const
+{
+  return m_shards;
+}
+
+} // namespace ns3
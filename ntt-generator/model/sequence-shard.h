@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SEQUENCE_SHARD_H
+#define SEQUENCE_SHARD_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/trace-output.h"
+#include "ns3/npy-trace.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Trace output cutting the PacketRecords into sliding sequences of
+ *        per-packet features, written as numpy shards for training.
+ *
+ * Every packet becomes a row of SEQUENCE_FEATURES float64 values:
+ * timestamp and delay in seconds, size, workload, application and message
+ * id. Once `length` packets were seen, a sequence of the last `length`
+ * rows is written every `stride` packets. The sequences go to the shards
+ * `basename`_00000.npy, `basename`_00001.npy, ..., arrays of shape
+ * (sequences, length, SEQUENCE_FEATURES) with at most `shardSize`
+ * sequences each, which numpy.load can memory-map.
+ */
+class SequenceShardTraceOutput : public TraceOutput
+{
+public:
+  /// Features per packet.
+  static const uint32_t SEQUENCE_FEATURES = 6;
+
+  /**
+   * \param basename the shards are basename_<index>.npy
+   * \param length packets per sequence
+   * \param stride packets between the starts of two sequences
+   * \param shardSize sequences per shard
+   */
+  SequenceShardTraceOutput(std::string basename, uint32_t length, uint32_t stride,
+                           uint32_t shardSize);
+  virtual ~SequenceShardTraceOutput();
+
+  /**
+   * \brief Add a packet.
+   * \param record a PacketRecord
+   */
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+  /**
+   * \return the number of sequences written so far
+   */
+  uint64_t GetSequences(void) const;
+  /**
+   * \return the number of shards created so far
+   */
+  uint32_t GetShards(void) const;
+
+private:
+  std::string m_basename;         //!< Shards are basename_<index>.npy
+  uint32_t m_length;              //!< Packets per sequence
+  uint32_t m_stride;              //!< Packets between sequence starts
+  uint32_t m_shardSize;           //!< Sequences per shard
+  std::vector<double> m_rows;     //!< The last m_length rows, circular
+  std::vector<double> m_sequence; //!< The sequence being written
+  uint64_t m_packets;             //!< Packets seen
+  uint64_t m_sequences;           //!< Sequences written
+  uint32_t m_shards;              //!< Shards created
+  Ptr<NpyTraceOutput> m_shard;    //!< The open shard, 0 if none
+  bool m_closed;                  //!< Close() was called
+};
+
+} // namespace ns3
+
+#endif /* SEQUENCE_SHARD_H */
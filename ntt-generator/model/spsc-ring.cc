@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+
+#include "ns3/assert.h"
+
+#include "spsc-ring.h"
+
+namespace ns3
+{
+
+SpscRing::SpscRing(uint32_t slotSize, uint32_t capacity)
+    : m_slotSize(slotSize),
+      m_head(0),
+      m_cachedTail(0),
+      m_tail(0),
+      m_cachedHead(0)
+{
+  NS_ASSERT_MSG(slotSize > 0 && capacity > 0, "Empty ring");
+  uint64_t slots = 1;
+  while (slots < capacity)
+  {
+    slots <<= 1;
+  }
+  m_mask = slots - 1;
+  m_data.resize(slots * m_slotSize);
+}
+
+bool SpscRing::TryPush(const void *slot)
+{
+  uint64_t tail = m_tail.load(std::memory_order_relaxed);
+  if (tail - m_cachedHead > m_mask)
+  {
+    m_cachedHead = m_head.load(std::memory_order_acquire);
+    if (tail - m_cachedHead > m_mask)
+    {
+      return false;
+    }
+  }
+  std::memcpy(&m_data[(tail & m_mask) * m_slotSize], slot, m_slotSize);
+  m_tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+const uint8_t *SpscRing::Front(void)
+{
+  uint64_t head = m_head.load(std::memory_order_relaxed);
+  if (head == m_cachedTail)
+  {
+    m_cachedTail = m_tail.load(std::memory_order_acquire);
+    if (head == m_cachedTail)
+    {
+      return 0;
+    }
+  }
+  return &m_data[(head & m_mask) * m_slotSize];
+}
+
+void SpscRing::Pop(void)
+{
+  m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint32_t SpscRing::GetCapacity(void) const
+{
+  return m_mask + 1;
+}
+
+} // namespace ns3
@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Lock-free ring of fixed-size slots for exactly one producer
+ *        thread and one consumer thread.
+ *
+ * The producer copies records in with TryPush(), the consumer reads them
+ * in place with Front() and releases them with Pop(). The memory used is
+ * fixed at construction.
+ */
+class SpscRing
+{
+public:
+  /**
+   * \param slotSize size of one slot in bytes
+   * \param capacity number of slots, rounded up to a power of two
+   */
+  SpscRing(uint32_t slotSize, uint32_t capacity);
+
+  /**
+   * \brief Copy one slot into the ring. Producer only.
+   * \param slot pointer to slotSize bytes
+   * \return false if the ring is full
+   */
+  bool TryPush(const void *slot);
+
+  /**
+   * \brief Oldest slot in the ring. Consumer only.
+   * \return pointer to the slot, or 0 if the ring is empty
+   */
+  const uint8_t *Front(void);
+
+  /**
+   * \brief Release the slot returned by Front(). Consumer only.
+   */
+  void Pop(void);
+
+  /**
+   * \return the number of slots
+   */
+  uint32_t GetCapacity(void) const;
+
+private:
+  uint32_t m_slotSize;         //!< Size of one slot
+  uint64_t m_mask;             //!< Capacity - 1
+  std::vector<uint8_t> m_data; //!< Slot storage
+
+  // Both indices only grow; they are kept on separate cache lines together
+  // with the other side's index as last seen, so the threads only touch
+  // each other's line when the cached value does not suffice.
+  alignas(64) std::atomic<uint64_t> m_head; //!< Next slot to read
+  uint64_t m_cachedTail;                    //!< Consumer's copy of m_tail
+  alignas(64) std::atomic<uint64_t> m_tail; //!< Next slot to write
+  uint64_t m_cachedHead;                    //!< Producer's copy of m_head
+};
+
+} // namespace ns3
+
+#endif /* SPSC_RING_H */
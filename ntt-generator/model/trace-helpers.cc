@@ -0,0 +1,363 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/trace-helper.h"
+
+#include "cdf-application.h"
+#include "packet-header-view.h"
+#include "queue-change-trace.h"
+#include "queue-sampler.h"
+#include "npy-trace.h"
+#include "flow-window.h"
+#include "sequence-shard.h"
+#include "drop-trace.h"
+#include "trace-helpers.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("TraceHelpers");
+
+// Trace source of the queue occupancy of the CSMA devices.
+static const char QUEUE_PATH[] =
+    "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue";
+
+// Log a packet as one csv row of PacketRecordFormat. With `printHeaders`,
+// the header dump of Packet::Print is appended as a quoted last column.
+static void WritePacketCsv(Ptr<OutputStreamWrapper> stream, bool printHeaders,
+                           Ptr<const Packet> p)
+{
+  static const PacketRecordFormat format;
+  PacketRecord record;
+  if (!MakePacketRecord(p, record))
+  {
+    return;
+  }
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(&record);
+  if (!printHeaders)
+  {
+    format.PrintCsv(*stream->GetStream(), data);
+    return;
+  }
+  std::ostringstream row;
+  format.PrintCsv(row, data);
+  std::ostringstream dump;
+  p->Print(dump);
+  std::string line = row.str();
+  line.pop_back();
+  *stream->GetStream() << line << ",\"";
+  for (char c : dump.str())
+  {
+    *stream->GetStream() << (c == '"' ? "\"\"" : std::string(1, c));
+  }
+  *stream->GetStream() << "\"\n";
+}
+
+static void WritePacketRecord(Ptr<TraceOutput> output, Ptr<const Packet> p)
+{
+  PacketRecord record;
+  if (MakePacketRecord(p, record))
+  {
+    output->Write(&record);
+  }
+}
+
+// Log a queue change as one csv row of QueueRecordFormat.
+static void WriteQueueCsv(Ptr<OutputStreamWrapper> stream, std::string context,
+                          uint32_t oldValue, uint32_t newValue)
+{
+  *stream->GetStream() << context << ',' << Simulator::Now().GetSeconds() << ','
+                       << newValue << '\n';
+}
+
+static void WriteQueueRecord(Ptr<TraceOutput> output, std::string context,
+                             uint32_t oldValue, uint32_t newValue)
+{
+  QueueRecord record;
+  MakeQueueRecord(context, newValue, record);
+  output->Write(&record);
+}
+
+// Log a drop as one csv row of DropRecordFormat, with the TCP sequence
+// number if `sequence`.
+static void WriteDropCsv(Ptr<OutputStreamWrapper> stream, bool sequence,
+                         std::string context, Ptr<const Packet> p)
+{
+  *stream->GetStream() << context << ',' << Simulator::Now().GetSeconds() << ','
+                       << p->GetSize();
+  if (sequence)
+  {
+    *stream->GetStream() << ',' << PacketHeaderView(p).GetSequenceNumber();
+  }
+  *stream->GetStream() << '\n';
+}
+
+static void WriteDropRecord(Ptr<TraceOutput> output, std::string context,
+                            Ptr<const Packet> p)
+{
+  DropRecord record;
+  MakeDropRecord(context, p, record);
+  output->Write(&record);
+}
+
+static void RecordDelay(Ptr<DelayHistogramSet> histograms, uint32_t receiver,
+                        Ptr<const Packet> p)
+{
+  histograms->Record(receiver, p);
+}
+
+TraceLogHelper::TraceLogHelper(void)
+    : m_format("csv"),
+      m_async(false),
+      m_printHeaders(false)
+{
+}
+
+void TraceLogHelper::SetFormat(std::string format)
+{
+  m_format = format;
+}
+
+void TraceLogHelper::SetAsync(bool async)
+{
+  m_async = async;
+}
+
+void TraceLogHelper::SetSample(std::string policy)
+{
+  m_sample = policy;
+}
+
+void TraceLogHelper::SetPrintHeaders(bool printHeaders)
+{
+  m_printHeaders = printHeaders;
+}
+
+Ptr<TraceOutput> TraceLogHelper::Wrap(Ptr<TraceOutput> output, uint32_t recordSize)
+{
+  if (m_async)
+  {
+    Ptr<AsyncTraceOutput> writer = Create<AsyncTraceOutput>(output, recordSize);
+    m_writers.push_back(writer);
+    return writer;
+  }
+  return output;
+}
+
+Ptr<TraceSampler> TraceLogHelper::CreateSampler(void) const
+{
+  if (m_sample.empty())
+  {
+    return 0;
+  }
+  return Create<TraceSampler>(m_sample);
+}
+
+Ptr<TraceOutput> TraceLogHelper::Open(std::string basename, Ptr<const TraceFormat> format)
+{
+  NS_LOG_FUNCTION(this << basename);
+  Ptr<TraceOutput> output =
+      Wrap(CreateFileTraceOutput(basename, format, m_format), format->GetRecordSize());
+  m_outputs.push_back(output);
+  return output;
+}
+
+Ptr<OutputStreamWrapper> TraceLogHelper::OpenCsv(std::string basename, const TraceFormat &format,
+                                                 const std::vector<TraceField> &extra)
+{
+  AsciiTraceHelper asciiTraceHelper;
+  Ptr<OutputStreamWrapper> stream = asciiTraceHelper.CreateFileStream(basename + ".csv");
+  format.PrintCsvSchema(*stream->GetStream(), extra);
+  return stream;
+}
+
+Callback<void, Ptr<const Packet>> TraceLogHelper::PacketLog(std::string basename)
+{
+  Ptr<TraceSampler> sampler = CreateSampler();
+  if (m_format == "csv" && (!m_async || m_printHeaders))
+  {
+    std::vector<TraceField> extra;
+    if (m_printHeaders)
+    {
+      extra.push_back({"headers", "str", ""});
+    }
+    return MakeSampledCallback(
+        sampler, MakeBoundCallback(&WritePacketCsv, OpenCsv(basename, PacketRecordFormat(), extra),
+                                   m_printHeaders));
+  }
+  Ptr<TraceOutput> output = Open(basename, Create<PacketRecordFormat>());
+  return MakeSampledCallback(sampler, MakeBoundCallback(&WritePacketRecord, output));
+}
+
+Callback<void, std::string, uint32_t, uint32_t> TraceLogHelper::QueueLog(std::string basename)
+{
+  if (m_format == "csv" && !m_async)
+  {
+    return MakeBoundCallback(&WriteQueueCsv, OpenCsv(basename, QueueRecordFormat()));
+  }
+  return MakeBoundCallback(&WriteQueueRecord, Open(basename, Create<QueueRecordFormat>()));
+}
+
+Callback<void, std::string, Ptr<const Packet>> TraceLogHelper::DropLog(std::string basename,
+                                                                       bool sequence)
+{
+  Ptr<TraceSampler> sampler = CreateSampler();
+  if (m_format == "csv" && !m_async)
+  {
+    return MakeSampledCallback(
+        sampler, MakeBoundCallback(&WriteDropCsv, OpenCsv(basename, DropRecordFormat(sequence)),
+                                   sequence));
+  }
+  Ptr<TraceOutput> output = Open(basename, Create<DropRecordFormat>(sequence));
+  return MakeSampledCallback(sampler, MakeBoundCallback(&WriteDropRecord, output));
+}
+
+void TraceLogHelper::ConnectDropPacketLog(std::string basename)
+{
+  Ptr<TraceOutput> output = Open(basename, Create<DropPacketRecordFormat>());
+  std::ofstream ports((basename + "_ports.csv").c_str());
+  ConnectDropPacketTrace(output, ports, CreateSampler());
+}
+
+void TraceLogHelper::ConnectQueueChangeLog(std::string basename, Time window)
+{
+  Ptr<TraceOutput> output =
+      Wrap(Create<QueueChangeTraceOutput>(basename + ".ntq", window), sizeof(QueueRecord));
+  m_outputs.push_back(output);
+  ConnectQueueTrace(QUEUE_PATH, output);
+}
+
+void TraceLogHelper::StartQueueSampler(std::string basename, Time interval, std::string path)
+{
+  Ptr<QueueSampler> sampler = Create<QueueSampler>(interval);
+  sampler->AddQueues(path);
+  Ptr<TraceOutput> output = Wrap(
+      Create<NpyTraceOutput>(basename + ".npy", sampler->GetDescr(), sampler->GetRowSize()),
+      sampler->GetRowSize());
+  m_outputs.push_back(output);
+  sampler->Start(output);
+}
+
+Ptr<MessageTracker> TraceLogHelper::StartMessageTracker(std::string basename,
+                                                        NodeContainer receivers)
+{
+  Ptr<MessageTracker> tracker =
+      Create<MessageTracker>(Open(basename, Create<MessageRecordFormat>()));
+  Config::ConnectWithoutContext(
+      "/NodeList/*/ApplicationList/*/$ns3::CdfApplication/TxMessageWithAddresses",
+      MakeCallback(&MessageTracker::Started, tracker));
+  for (NodeContainer::Iterator it = receivers.Begin(); it != receivers.End(); ++it)
+  {
+    (*it)->GetDevice(0)->TraceConnectWithoutContext(
+        "MacRx", MakeCallback(&MessageTracker::Received, tracker));
+  }
+  return tracker;
+}
+
+void TraceLogHelper::ConnectFlowWindowLog(std::string basename, Time window, Time step,
+                                          NodeContainer receivers)
+{
+  // The aggregation closes the log, so only it is kept for Close().
+  Ptr<const TraceFormat> format = Create<FlowWindowRecordFormat>();
+  Ptr<TraceOutput> output = Create<FlowWindowTraceOutput>(
+      Wrap(CreateFileTraceOutput(basename, format, m_format), format->GetRecordSize()), window,
+      step);
+  m_outputs.push_back(output);
+  for (NodeContainer::Iterator it = receivers.Begin(); it != receivers.End(); ++it)
+  {
+    (*it)->GetDevice(0)->TraceConnectWithoutContext(
+        "MacRx", MakeBoundCallback(&WritePacketRecord, output));
+  }
+}
+
+void TraceLogHelper::ConnectSequenceExport(std::string basename, uint32_t length, uint32_t stride,
+                                           uint32_t shardSize, NodeContainer receivers)
+{
+  Ptr<TraceOutput> output =
+      Wrap(Create<SequenceShardTraceOutput>(basename, length, stride, shardSize),
+           sizeof(PacketRecord));
+  m_outputs.push_back(output);
+  for (NodeContainer::Iterator it = receivers.Begin(); it != receivers.End(); ++it)
+  {
+    (*it)->GetDevice(0)->TraceConnectWithoutContext(
+        "MacRx", MakeBoundCallback(&WritePacketRecord, output));
+  }
+}
+
+void TraceLogHelper::ConnectDelayHistograms(Ptr<DelayHistogramSet> histograms,
+                                            NodeContainer receivers)
+{
+  for (NodeContainer::Iterator it = receivers.Begin(); it != receivers.End(); ++it)
+  {
+    (*it)->GetDevice(0)->TraceConnectWithoutContext(
+        "MacRx", MakeBoundCallback(&RecordDelay, histograms, (*it)->GetId()));
+  }
+}
+
+void TraceLogHelper::Close(std::ostream &os)
+{
+  NS_LOG_FUNCTION(this);
+  for (Ptr<TraceOutput> output : m_outputs)
+  {
+    output->Close();
+  }
+  m_outputs.clear();
+  // Some writers are inside the outputs, e.g. of the flow windows.
+  for (Ptr<AsyncTraceOutput> writer : m_writers)
+  {
+    if (writer->GetStalls() > 0)
+    {
+      os << "Trace writer stalled the simulation " << writer->GetStalls() << " times for "
+         << writer->GetStallSeconds() << "s\n";
+    }
+  }
+  m_writers.clear();
+}
+
+void ReportBacklogs(std::ostream &os)
+{
+  uint64_t deferred = 0;
+  uint64_t dropped = 0;
+  uint64_t failed = 0;
+  uint64_t waiting = 0;
+  for (NodeList::Iterator node = NodeList::Begin(); node != NodeList::End(); ++node)
+  {
+    for (uint32_t i = 0; i < (*node)->GetNApplications(); ++i)
+    {
+      Ptr<CdfApplication> app = DynamicCast<CdfApplication>((*node)->GetApplication(i));
+      if (app)
+      {
+        deferred += app->GetDeferred();
+        dropped += app->GetDropped();
+        failed += app->GetFailed();
+        waiting += app->GetBacklog();
+      }
+    }
+  }
+  os << "Deferred " << deferred << " messages, dropped " << dropped << ", failed " << failed
+     << ", " << waiting << " still waiting for the send buffer.\n";
+}
+
+} // namespace ns3
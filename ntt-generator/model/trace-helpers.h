@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_HELPERS_H
+#define TRACE_HELPERS_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/callback.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/trace-sampler.h"
+#include "ns3/message-tracker.h"
+#include "ns3/delay-histogram.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Create the logs of the traffic generation experiments and connect
+ *        them to the trace sources of the simulation.
+ *
+ * All logs are written in one trace format, see CreateFileTraceOutput,
+ * and with SetAsync by background writers, so the simulation only copies
+ * the records into a ring buffer. The helper keeps the record outputs it
+ * opens; Close() closes them once the simulation is done.
+ */
+class TraceLogHelper
+{
+public:
+  TraceLogHelper(void);
+
+  /// \param format the trace format of the logs, see CreateFileTraceOutput
+  void SetFormat(std::string format);
+  /// \param async whether background writers write the logs
+  void SetAsync(bool async);
+  /**
+   * \param policy sampling policy of the packet and drop logs, see
+   *        TraceSampler; every log gets its own sampler, all packets are
+   *        logged if empty
+   */
+  void SetSample(std::string policy);
+  /**
+   * \param printHeaders whether the synchronous csv packet logs get the
+   *        header dump of Packet::Print as a quoted last column; this needs
+   *        Packet::EnablePrinting()
+   */
+  void SetPrintHeaders(bool printHeaders);
+
+  /**
+   * \brief Open a log of fixed-size records in the trace format.
+   * \param basename the log file without extension
+   * \param format the format of the records
+   * \return the output, closed by Close()
+   */
+  Ptr<TraceOutput> Open(std::string basename, Ptr<const TraceFormat> format);
+  /**
+   * \brief Open the csv log `basename`.csv and write the schema of
+   *        `format`, see TraceFormat::PrintCsvSchema.
+   */
+  static Ptr<OutputStreamWrapper> OpenCsv(std::string basename, const TraceFormat &format,
+                                          const std::vector<TraceField> &extra =
+                                              std::vector<TraceField>());
+
+  /**
+   * \brief Create the packet log `basename`.
+   *
+   * The csv is written directly by the returned callback unless it is
+   * written asynchronously without header dumps.
+   *
+   * \return the trace sink for MacRx or MacTx
+   */
+  Callback<void, Ptr<const Packet>> PacketLog(std::string basename);
+  /**
+   * \brief Create the queue log `basename`.
+   * \return the trace sink for PacketsInQueue, connected with context
+   */
+  Callback<void, std::string, uint32_t, uint32_t> QueueLog(std::string basename);
+  /**
+   * \brief Create the drop log `basename`.
+   * \param sequence whether the csv has the TCP sequence number column,
+   *        see DropRecordFormat
+   * \return the trace sink for MacTxDrop, connected with context
+   */
+  Callback<void, std::string, Ptr<const Packet>> DropLog(std::string basename,
+                                                         bool sequence = false);
+
+  /**
+   * \brief Log the dropped application packets with their tags and
+   *        5-tuple to `basename`, keyed by the port ids listed in
+   *        `basename`_ports.csv, see ConnectDropPacketTrace.
+   */
+  void ConnectDropPacketLog(std::string basename);
+  /**
+   * \brief Log only the changes of the occupancy of the CSMA device queues
+   *        to `basename`.ntq, see QueueChangeTraceOutput.
+   * \param window the coalescing window, zero to log every change
+   */
+  void ConnectQueueChangeLog(std::string basename, Time window);
+  /**
+   * \brief Sample the occupancy of the queues matching `path` every
+   *        `interval` into `basename`.npy, see QueueSampler.
+   */
+  void StartQueueSampler(std::string basename, Time interval, std::string path);
+  /**
+   * \brief Track the completion of the messages of all CdfApplications
+   *        delivered at `receivers` into the message log `basename`.
+   *
+   * Call it after the applications are installed.
+   *
+   * \return the tracker, to be closed before Close()
+   */
+  Ptr<MessageTracker> StartMessageTracker(std::string basename, NodeContainer receivers);
+  /**
+   * \brief Aggregate the packets arriving at `receivers` per flow into
+   *        the log `basename`, see FlowWindowTraceOutput.
+   */
+  void ConnectFlowWindowLog(std::string basename, Time window, Time step,
+                            NodeContainer receivers);
+  /**
+   * \brief Cut the packets arriving at `receivers` into sequences of
+   *        training features, written to the shards `basename`_<index>.npy,
+   *        see SequenceShardTraceOutput.
+   */
+  void ConnectSequenceExport(std::string basename, uint32_t length, uint32_t stride,
+                             uint32_t shardSize, NodeContainer receivers);
+  /**
+   * \brief Count the one-way delay of the packets arriving at `receivers`
+   *        in `histograms`, keyed by the receiver node id.
+   */
+  static void ConnectDelayHistograms(Ptr<DelayHistogramSet> histograms,
+                                     NodeContainer receivers);
+
+  /**
+   * \brief Close all record logs and report how often the simulation had
+   *        to wait for a background writer.
+   * \param os receives the report
+   */
+  void Close(std::ostream &os);
+
+private:
+  /// \return a sampler for one log, or a null pointer to log everything
+  Ptr<TraceSampler> CreateSampler(void) const;
+  /**
+   * \return `output`, wrapped in a background writer if the logs are
+   *         written asynchronously; Close() reports the stalls of the
+   *         writer
+   */
+  Ptr<TraceOutput> Wrap(Ptr<TraceOutput> output, uint32_t recordSize);
+
+  std::string m_format;                         //!< Trace format of the logs
+  bool m_async;                                 //!< Write with background writers
+  std::string m_sample;                         //!< Sampling policy, empty for none
+  bool m_printHeaders;                          //!< Dump the headers in the csv
+  std::vector<Ptr<TraceOutput>> m_outputs;      //!< The outputs to close
+  std::vector<Ptr<AsyncTraceOutput>> m_writers; //!< The background writers, to report
+};
+
+/**
+ * \brief Report how many messages of all CdfApplications had to wait for
+ *        send buffer space, were dropped because their backlog was full,
+ *        were refused by a datagram socket, or were still waiting.
+ * \param os receives the report
+ */
+void ReportBacklogs(std::ostream &os);
+
+} // namespace ns3
+
+#endif /* TRACE_HELPERS_H */
@@ -0,0 +1,276 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <chrono>
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "trace-output.h"
+#include "block-trace.h"
+#include "columnar-trace.h"
+#include "mapped-trace.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("TraceOutput");
+
+// Records are collected in a buffer of this size before they are written.
+static const uint32_t TRACE_BUFFER_SIZE = 1 << 20;
+
+void MakeTraceFileHeader(const TraceFormat &format, TraceFileHeader &header)
+{
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "NTTR", 4);
+  header.version = TRACE_FILE_VERSION;
+  header.recordSize = format.GetRecordSize();
+  std::strncpy(header.format, format.GetName().c_str(), sizeof(header.format) - 1);
+}
+
+bool ReadTraceFileHeader(std::istream &is, TraceFileHeader &header)
+{
+  if (!is.read(reinterpret_cast<char *>(&header), sizeof(header)))
+  {
+    return false;
+  }
+  header.format[sizeof(header.format) - 1] = '\0';
+  return std::memcmp(header.magic, "NTTR", 4) == 0 &&
+         header.version == TRACE_FILE_VERSION;
+}
+
+TraceOutput::~TraceOutput()
+{
+}
+
+FileTraceOutput::FileTraceOutput(std::string filename,
+                                 Ptr<const TraceFormat> format,
+                                 Encoding encoding)
+    : m_format(format),
+      m_encoding(encoding),
+      m_recordSize(format->GetRecordSize()),
+      m_buffer(TRACE_BUFFER_SIZE)
+{
+  NS_LOG_FUNCTION(this << filename << encoding);
+  // The buffer must be installed before the file is opened.
+  m_file.rdbuf()->pubsetbuf(m_buffer.data(), m_buffer.size());
+  m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS(m_file.is_open(), "Unable to open trace file " << filename);
+
+  if (m_encoding == BINARY)
+  {
+    TraceFileHeader header;
+    MakeTraceFileHeader(*m_format, header);
+    m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+  else
+  {
+    m_format->PrintCsvSchema(m_file);
+  }
+}
+
+FileTraceOutput::~FileTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void FileTraceOutput::Write(const void *record)
+{
+  NS_ASSERT_MSG(m_file.is_open(), "Write to a closed trace output");
+  if (m_encoding == BINARY)
+  {
+    m_file.write(static_cast<const char *>(record), m_recordSize);
+  }
+  else
+  {
+    m_format->PrintCsv(m_file, static_cast<const uint8_t *>(record));
+  }
+}
+
+void FileTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (m_file.is_open())
+  {
+    m_file.close();
+  }
+}
+
+Ptr<TraceOutput> CreateFileTraceOutput(std::string basename,
+                                       Ptr<const TraceFormat> format,
+                                       std::string layout)
+{
+  if (layout == "csv")
+  {
+    return Create<FileTraceOutput>(basename + ".csv", format, FileTraceOutput::CSV);
+  }
+  if (layout == "binary")
+  {
+    return Create<FileTraceOutput>(basename + ".bin", format, FileTraceOutput::BINARY);
+  }
+  if (layout == "compressed")
+  {
+    return Create<BlockTraceOutput>(basename + ".ntz", format);
+  }
+  if (layout == "columnar")
+  {
+    return Create<ColumnarTraceOutput>(basename + ".ntc", format);
+  }
+  if (layout == "mapped")
+  {
+    return Create<MappedTraceOutput>(basename + ".ntm", format);
+  }
+  NS_FATAL_ERROR("Unknown trace layout " << layout);
+  return 0;
+}
+
+AsyncTraceOutput::AsyncTraceOutput(Ptr<TraceOutput> sink, uint32_t recordSize,
+                                   uint32_t capacity, OverflowPolicy policy)
+    : m_sink(sink),
+      m_ring(recordSize, capacity),
+      m_policy(policy),
+      m_stop(false),
+      m_sleeping(false),
+      m_closed(false),
+      m_written(0),
+      m_dropped(0),
+      m_stalls(0),
+      m_stallSeconds(0)
+{
+  NS_LOG_FUNCTION(this << recordSize << capacity << policy);
+  m_writer = std::thread(&AsyncTraceOutput::Run, this);
+}
+
+AsyncTraceOutput::~AsyncTraceOutput()
+{
+  NS_LOG_FUNCTION(this);
+  Close();
+}
+
+void AsyncTraceOutput::Write(const void *record)
+{
+  NS_ASSERT_MSG(!m_closed, "Write to a closed trace output");
+  if (m_ring.TryPush(record))
+  {
+    ++m_written;
+    Notify();
+    return;
+  }
+  if (m_policy == DROP)
+  {
+    ++m_dropped;
+    return;
+  }
+  ++m_stalls;
+  auto start = std::chrono::steady_clock::now();
+  while (!m_ring.TryPush(record))
+  {
+    std::this_thread::yield();
+  }
+  std::chrono::duration<double> waited = std::chrono::steady_clock::now() - start;
+  m_stallSeconds += waited.count();
+  ++m_written;
+  Notify();
+}
+
+void AsyncTraceOutput::Notify(void)
+{
+  // Pairs with the fence in Run(): either the writer sees the record or
+  // this thread sees that the writer is going to sleep.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_sleeping.load(std::memory_order_relaxed))
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wake.notify_one();
+  }
+}
+
+void AsyncTraceOutput::Close(void)
+{
+  NS_LOG_FUNCTION(this);
+  if (m_closed)
+  {
+    return;
+  }
+  m_closed = true;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop.store(true, std::memory_order_release);
+    m_wake.notify_one();
+  }
+  m_writer.join();
+  m_sink->Close();
+  NS_LOG_INFO("Wrote " << m_written << " records, dropped " << m_dropped
+                       << ", " << m_stalls << " writes waited "
+                       << m_stallSeconds << "s for the writer");
+}
+
+uint64_t AsyncTraceOutput::GetWritten(void) const
+{
+  return m_written;
+}
+
+uint64_t AsyncTraceOutput::GetDropped(void) const
+{
+  return m_dropped;
+}
+
+uint64_t AsyncTraceOutput::GetStalls(void) const
+{
+  return m_stalls;
+}
+
+double AsyncTraceOutput::GetStallSeconds(void) const
+{
+  return m_stallSeconds;
+}
+
+void AsyncTraceOutput::Run(void)
+{
+  while (true)
+  {
+    const uint8_t *record = m_ring.Front();
+    if (record != 0)
+    {
+      m_sink->Write(record);
+      m_ring.Pop();
+    }
+    else if (m_stop.load(std::memory_order_acquire))
+    {
+      // Records pushed before the stop flag was set are visible now.
+      if (m_ring.Front() == 0)
+      {
+        return;
+      }
+    }
+    else
+    {
+      // Wait for Notify() instead of polling the empty ring.
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_sleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (m_ring.Front() == 0 && !m_stop.load(std::memory_order_acquire))
+      {
+        m_wake.wait(lock);
+      }
+      m_sleeping.store(false, std::memory_order_relaxed);
+    }
+  }
+}
+
+} // namespace ns3
@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Outputs for fixed-size trace records, see trace-record.h.
+
+#ifndef TRACE_OUTPUT_H
+#define TRACE_OUTPUT_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include "ns3/trace-record.h"
+#include "ns3/spsc-ring.h"
+
+namespace ns3
+{
+
+#pragma pack(push, 1)
+/**
+ * \brief Header at the start of every binary trace file.
+ */
+struct TraceFileHeader
+{
+  char magic[4];       //!< "NTTR"
+  uint16_t version;    //!< Version of the record layout
+  uint16_t recordSize; //!< Size of one record in bytes
+  char format[24];     //!< Name of the record format, zero padded
+};
+#pragma pack(pop)
+
+/// Version of the binary trace layout written by this module.
+const uint16_t TRACE_FILE_VERSION = 2;
+
+/**
+ * \brief Fill a trace file header for a record format.
+ * \param format the record format
+ * \param header the header to fill
+ */
+void MakeTraceFileHeader(const TraceFormat &format, TraceFileHeader &header);
+
+/**
+ * \brief Read and check the header of a binary trace file.
+ * \param is the input stream, positioned at the start of the file
+ * \param header the header to fill
+ * \return true if the magic and version are known
+ */
+bool ReadTraceFileHeader(std::istream &is, TraceFileHeader &header);
+
+/**
+ * \brief Destination of fixed-size trace records.
+ *
+ * Trace callbacks build a record on the stack and hand it to Write(); the
+ * output decides how and when it ends up on disk.
+ */
+class TraceOutput : public SimpleRefCount<TraceOutput>
+{
+public:
+  virtual ~TraceOutput();
+
+  /**
+   * \brief Write one record.
+   * \param record pointer to one record of the output's format
+   */
+  virtual void Write(const void *record) = 0;
+
+  /**
+   * \brief Flush all pending records and close the output.
+   *
+   * Writing after Close() is an error. Closing twice has no effect.
+   */
+  virtual void Close(void) = 0;
+};
+
+/**
+ * \brief Trace output writing records to a file, either as raw binary
+ *        records after a TraceFileHeader or converted to csv.
+ */
+class FileTraceOutput : public TraceOutput
+{
+public:
+  /// How records are stored in the file.
+  enum Encoding
+  {
+    BINARY, //!< TraceFileHeader, then the raw records
+    CSV     //!< Schema block, then one line of text per record, see TraceFormat::PrintCsv
+  };
+
+  /**
+   * \param filename the file to create
+   * \param format the format of the records written to this output
+   * \param encoding how records are stored
+   */
+  FileTraceOutput(std::string filename, Ptr<const TraceFormat> format,
+                  Encoding encoding = BINARY);
+  virtual ~FileTraceOutput();
+
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+private:
+  Ptr<const TraceFormat> m_format; //!< Format of the records
+  Encoding m_encoding;             //!< How records are stored
+  uint32_t m_recordSize;           //!< Cached record size
+  std::vector<char> m_buffer;      //!< Stream buffer, records are written in large blocks
+  std::ofstream m_file;            //!< The output file
+};
+
+/**
+ * \brief Create the output of a trace file in one of the supported layouts.
+ *
+ * "csv" writes text lines to basename.csv, "binary" raw records to
+ * basename.bin, "compressed" a BlockTraceOutput to basename.ntz,
+ * "columnar" a ColumnarTraceOutput to basename.ntc and "mapped" a
+ * MappedTraceOutput to basename.ntm.
+ *
+ * \param basename the file name without extension
+ * \param format the format of the records written to the output
+ * \param layout "csv", "binary", "compressed", "columnar" or "mapped"
+ * \return the output, aborts on an unknown layout
+ */
+Ptr<TraceOutput> CreateFileTraceOutput(std::string basename,
+                                       Ptr<const TraceFormat> format,
+                                       std::string layout);
+
+/**
+ * \brief Trace output handing records to another output on a background
+ *        writer thread.
+ *
+ * Write() only copies the record into a bounded SpscRing; the writer
+ * thread formats the records and writes them to the wrapped output, so
+ * the simulator thread never waits for the disk while there is space in
+ * the ring. While the ring is empty the writer sleeps until the next
+ * Write() wakes it, which only takes a lock when the writer is asleep.
+ * When the ring is full, the policy decides whether the simulator waits
+ * for the writer or the record is dropped; both cases are counted.
+ */
+class AsyncTraceOutput : public TraceOutput
+{
+public:
+  /// What happens to a record when the ring is full.
+  enum OverflowPolicy
+  {
+    BLOCK, //!< Wait until the writer has made space, nothing is lost
+    DROP   //!< Discard the record and count it
+  };
+
+  /**
+   * \param sink the output written by the writer thread
+   * \param recordSize size of one record in bytes
+   * \param capacity number of records the ring holds
+   * \param policy what to do when the ring is full
+   */
+  AsyncTraceOutput(Ptr<TraceOutput> sink, uint32_t recordSize,
+                   uint32_t capacity = 65536, OverflowPolicy policy = BLOCK);
+  virtual ~AsyncTraceOutput();
+
+  virtual void Write(const void *record);
+  virtual void Close(void);
+
+  /**
+   * \return the number of records handed to the writer
+   */
+  uint64_t GetWritten(void) const;
+  /**
+   * \return the number of records dropped because the ring was full
+   */
+  uint64_t GetDropped(void) const;
+  /**
+   * \return the number of writes that had to wait for the writer
+   */
+  uint64_t GetStalls(void) const;
+  /**
+   * \return the wall-clock time the simulator spent waiting for the writer
+   */
+  double GetStallSeconds(void) const;
+
+private:
+  /// Main loop of the writer thread.
+  void Run(void);
+  /// Wake the writer thread if it waits for records.
+  void Notify(void);
+
+  Ptr<TraceOutput> m_sink;        //!< Output used by the writer thread
+  SpscRing m_ring;                //!< Records not yet written
+  OverflowPolicy m_policy;        //!< Full ring policy
+  std::atomic<bool> m_stop;       //!< Set by Close(), the writer drains and exits
+  std::atomic<bool> m_sleeping;   //!< The writer waits on m_wake
+  std::mutex m_mutex;             //!< Protects the wait on m_wake
+  std::condition_variable m_wake; //!< Signals records or m_stop to the writer
+  std::thread m_writer;           //!< The writer thread
+  bool m_closed;                  //!< Close() was called
+  uint64_t m_written;             //!< Records pushed to the ring
+  uint64_t m_dropped;             //!< Records dropped
+  uint64_t m_stalls;              //!< Writes that waited
+  double m_stallSeconds;          //!< Time spent waiting
+};
+
+} // namespace ns3
+
+#endif /* TRACE_OUTPUT_H */
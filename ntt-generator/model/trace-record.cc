@@ -0,0 +1,712 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/flow-id-tag.h"
+
+#include "trace-record.h"
+#include "packet-header-view.h"
+#include "ns3/experiment-tags.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("TraceRecord");
+
+// Column description of field `field` of record type `type`.
+#define TRACE_COLUMN(type, field, encoding)                                   \
+  TraceColumn{#field, offsetof(type, field), sizeof(type::field),             \
+              std::is_signed<decltype(type::field)>::value,                   \
+              TraceColumn::encoding}
+
+bool MakePacketRecord(Ptr<const Packet> p, PacketRecord &record)
+{
+  TimestampTag timestampTag;
+  IdTag idTag;
+  if (!p->PeekPacketTag(timestampTag) || !p->PeekPacketTag(idTag))
+  {
+    return false;
+  }
+  std::memset(&record, 0, sizeof(record));
+
+  FlowIdTag flowid;
+  MessageTag mTag;
+  if (p->PeekPacketTag(flowid))
+  {
+    record.flowId = flowid.GetFlowId();
+  }
+  if (p->PeekPacketTag(mTag))
+  {
+    record.message = mTag.GetSimpleValue();
+  }
+
+  auto current_time = Simulator::Now();
+  record.timestamp = current_time.GetNanoSeconds();
+  record.delay = (current_time - timestampTag.GetTime()).GetNanoSeconds();
+  record.uid = p->GetUid();
+  record.size = p->GetSize();
+  record.workload = idTag.GetWorkload();
+  record.application = idTag.GetApplication();
+
+  PacketHeaderView header(p);
+  record.ipId = header.GetIdentification();
+  record.dscp = header.GetDscp();
+  record.ecn = header.GetEcn();
+  record.ttl = header.GetTtl();
+  record.payloadSize = header.GetPayloadSize();
+  record.protocol = header.GetProtocol();
+  record.source = header.GetSource().Get();
+  record.destination = header.GetDestination().Get();
+  record.sourcePort = header.GetSourcePort();
+  record.destinationPort = header.GetDestinationPort();
+  record.sequence = header.GetSequenceNumber();
+  record.window = header.GetWindowSize();
+  record.ackNumber = header.GetAckNumber();
+  record.tcpFlags = header.GetFlags();
+  return true;
+}
+
+bool ParseDeviceContext(const std::string &context, uint32_t &node,
+                        uint32_t &device)
+{
+  static const char nodeList[] = "/NodeList/";
+  static const char deviceList[] = "/DeviceList/";
+  const char *c = context.c_str();
+  if (std::strncmp(c, nodeList, sizeof(nodeList) - 1) != 0)
+  {
+    return false;
+  }
+  char *end;
+  node = std::strtoul(c + sizeof(nodeList) - 1, &end, 10);
+  if (std::strncmp(end, deviceList, sizeof(deviceList) - 1) != 0)
+  {
+    return false;
+  }
+  device = std::strtoul(end + sizeof(deviceList) - 1, &end, 10);
+  return true;
+}
+
+void MakeQueueRecord(const std::string &context, uint32_t value,
+                     QueueRecord &record)
+{
+  std::memset(&record, 0, sizeof(record));
+  record.timestamp = Simulator::Now().GetNanoSeconds();
+  NS_ABORT_MSG_UNLESS(ParseDeviceContext(context, record.node, record.device),
+                      "Not a device trace context: " << context);
+  record.value = value;
+}
+
+void MakeDropRecord(const std::string &context, Ptr<const Packet> p,
+                    DropRecord &record)
+{
+  std::memset(&record, 0, sizeof(record));
+  record.timestamp = Simulator::Now().GetNanoSeconds();
+  NS_ABORT_MSG_UNLESS(ParseDeviceContext(context, record.node, record.device),
+                      "Not a device trace context: " << context);
+  record.size = p->GetSize();
+  record.sequence = PacketHeaderView(p).GetSequenceNumber();
+}
+
+bool operator<(const TraceFlow &a, const TraceFlow &b)
+{
+  return std::memcmp(&a, &b, sizeof(TraceFlow)) < 0;
+}
+
+bool operator==(const TraceFlow &a, const TraceFlow &b)
+{
+  return std::memcmp(&a, &b, sizeof(TraceFlow)) == 0;
+}
+
+TraceFormat::~TraceFormat()
+{
+}
+
+bool TraceFormat::GetFlow(const uint8_t *record, TraceFlow &flow) const
+{
+  return false;
+}
+
+void TraceFormat::PrintCsvSchema(std::ostream &os, const std::vector<TraceField> &extra) const
+{
+  std::vector<TraceField> fields = GetFields();
+  fields.insert(fields.end(), extra.begin(), extra.end());
+  os << "# ntt-trace-schema " << TRACE_SCHEMA_VERSION << ' ' << GetName() << "\n# types ";
+  for (size_t i = 0; i < fields.size(); ++i)
+  {
+    os << (i ? "," : "") << fields[i].type;
+  }
+  os << "\n# units ";
+  for (size_t i = 0; i < fields.size(); ++i)
+  {
+    os << (i ? "," : "") << fields[i].unit;
+  }
+  os << "\n";
+  for (size_t i = 0; i < fields.size(); ++i)
+  {
+    os << (i ? "," : "") << fields[i].name;
+  }
+  os << "\n";
+}
+
+std::string PacketRecordFormat::GetName(void) const
+{
+  return "packet";
+}
+
+uint32_t PacketRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(PacketRecord);
+}
+
+// The columns of PacketRecordFormat, without the newline.
+static void PrintPacketFields(std::ostream &os, const PacketRecord &record)
+{
+  // Port 0 is reserved, so zero ports mean the packet had no transport
+  // header, as for the non-first fragments of a datagram.
+  bool transport = record.sourcePort != 0 || record.destinationPort != 0;
+  bool tcp = transport && record.protocol == 6;
+  bool ports = tcp || (transport && record.protocol == 17);
+  os << NanoSeconds(record.timestamp).GetSeconds() << ',' << record.flowId << ','
+     << record.uid << ',' << record.size << ',' << record.ipId << ','
+     << static_cast<uint16_t>(record.dscp) << ',' << static_cast<uint16_t>(record.ecn) << ','
+     << static_cast<uint16_t>(record.ttl) << ',' << record.payloadSize << ','
+     << static_cast<uint16_t>(record.protocol) << ',' << Ipv4Address(record.source) << ','
+     << Ipv4Address(record.destination) << ',';
+  if (ports)
+  {
+    os << record.sourcePort << ',' << record.destinationPort;
+  }
+  else
+  {
+    os << ',';
+  }
+  os << ',';
+  if (tcp)
+  {
+    os << record.sequence << ',' << record.window << ',' << record.ackNumber << ','
+       << static_cast<uint16_t>(record.tcpFlags);
+  }
+  else
+  {
+    os << ",,,";
+  }
+  os << ',' << NanoSeconds(record.delay).GetSeconds() << ',' << record.workload << ','
+     << record.application << ',' << record.message;
+}
+
+void PacketRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  PacketRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  PrintPacketFields(os, record);
+  os << "\n";
+}
+
+uint64_t PacketRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  uint64_t timestamp;
+  std::memcpy(&timestamp, data + offsetof(PacketRecord, timestamp), sizeof(timestamp));
+  return timestamp;
+}
+
+bool PacketRecordFormat::GetFlow(const uint8_t *data, TraceFlow &flow) const
+{
+  PacketRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  flow.source = record.source;
+  flow.destination = record.destination;
+  flow.sourcePort = record.sourcePort;
+  flow.destinationPort = record.destinationPort;
+  flow.protocol = record.protocol;
+  return true;
+}
+
+std::vector<TraceColumn> PacketRecordFormat::GetColumns(void) const
+{
+  return {
+      TRACE_COLUMN(PacketRecord, timestamp, DELTA),
+      TRACE_COLUMN(PacketRecord, uid, DELTA),
+      TRACE_COLUMN(PacketRecord, delay, DELTA),
+      TRACE_COLUMN(PacketRecord, size, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, flowId, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, source, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, destination, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, sequence, DELTA),
+      TRACE_COLUMN(PacketRecord, workload, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, application, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, message, DELTA),
+      TRACE_COLUMN(PacketRecord, ackNumber, DELTA),
+      TRACE_COLUMN(PacketRecord, sourcePort, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, destinationPort, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, ipId, DELTA),
+      TRACE_COLUMN(PacketRecord, payloadSize, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, window, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, protocol, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, dscp, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, ecn, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, ttl, DICTIONARY),
+      TRACE_COLUMN(PacketRecord, tcpFlags, DICTIONARY),
+  };
+}
+
+std::vector<TraceField> PacketRecordFormat::GetFields(void) const
+{
+  return {
+      {"timestamp", "f8", "s"},
+      {"flowId", "u4", ""},
+      {"uid", "u8", ""},
+      {"size", "u4", "B"},
+      {"ipId", "u2", ""},
+      {"dscp", "u1", ""},
+      {"ecn", "u1", ""},
+      {"ttl", "u1", ""},
+      {"payloadSize", "u2", "B"},
+      {"protocol", "u1", ""},
+      {"source", "ip", ""},
+      {"destination", "ip", ""},
+      {"sourcePort", "u2", ""},
+      {"destinationPort", "u2", ""},
+      {"sequence", "u4", ""},
+      {"window", "u2", ""},
+      {"ackNumber", "u4", ""},
+      {"tcpFlags", "u1", ""},
+      {"delay", "f8", "s"},
+      {"workload", "u4", ""},
+      {"application", "u4", ""},
+      {"message", "u4", ""},
+  };
+}
+
+std::string QueueRecordFormat::GetName(void) const
+{
+  return "queue";
+}
+
+uint32_t QueueRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(QueueRecord);
+}
+
+void QueueRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  QueueRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  os << "/NodeList/" << record.node << "/DeviceList/" << record.device
+     << "/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue" << ','
+     << NanoSeconds(record.timestamp).GetSeconds() << ','
+     << record.value << "\n";
+}
+
+uint64_t QueueRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  uint64_t timestamp;
+  std::memcpy(&timestamp, data + offsetof(QueueRecord, timestamp), sizeof(timestamp));
+  return timestamp;
+}
+
+std::vector<TraceColumn> QueueRecordFormat::GetColumns(void) const
+{
+  return {
+      TRACE_COLUMN(QueueRecord, timestamp, DELTA),
+      TRACE_COLUMN(QueueRecord, node, DICTIONARY),
+      TRACE_COLUMN(QueueRecord, device, DICTIONARY),
+      TRACE_COLUMN(QueueRecord, value, DELTA),
+  };
+}
+
+std::vector<TraceField> QueueRecordFormat::GetFields(void) const
+{
+  return {
+      {"source", "str", ""},
+      {"time", "f8", "s"},
+      {"size", "u4", "packets"},
+  };
+}
+
+DropRecordFormat::DropRecordFormat(bool printSequence)
+    : m_printSequence(printSequence)
+{
+}
+
+std::string DropRecordFormat::GetName(void) const
+{
+  return m_printSequence ? "drop-sequence" : "drop";
+}
+
+uint32_t DropRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(DropRecord);
+}
+
+void DropRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  DropRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  os << "/NodeList/" << record.node << "/DeviceList/" << record.device
+     << "/$ns3::CsmaNetDevice/MacTxDrop" << ','
+     << NanoSeconds(record.timestamp).GetSeconds() << ','
+     << record.size;
+  if (m_printSequence)
+  {
+    os << "," << record.sequence;
+  }
+  os << "\n";
+}
+
+uint64_t DropRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  uint64_t timestamp;
+  std::memcpy(&timestamp, data + offsetof(DropRecord, timestamp), sizeof(timestamp));
+  return timestamp;
+}
+
+std::vector<TraceColumn> DropRecordFormat::GetColumns(void) const
+{
+  return {
+      TRACE_COLUMN(DropRecord, timestamp, DELTA),
+      TRACE_COLUMN(DropRecord, node, DICTIONARY),
+      TRACE_COLUMN(DropRecord, device, DICTIONARY),
+      TRACE_COLUMN(DropRecord, size, DICTIONARY),
+      TRACE_COLUMN(DropRecord, sequence, PLAIN),
+  };
+}
+
+std::vector<TraceField> DropRecordFormat::GetFields(void) const
+{
+  std::vector<TraceField> fields = {
+      {"source", "str", ""},
+      {"time", "f8", "s"},
+      {"packetsize", "u4", "B"},
+  };
+  if (m_printSequence)
+  {
+    fields.push_back({"sequence", "u4", ""});
+  }
+  return fields;
+}
+
+std::string SenderRecordFormat::GetName(void) const
+{
+  return "sender";
+}
+
+uint32_t SenderRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(SenderRecord);
+}
+
+void SenderRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  SenderRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  os << NanoSeconds(record.timestamp).GetSeconds() << ',' << record.size << ','
+     << record.uid << ',' << record.sequence << ',' << record.node << "\n";
+}
+
+uint64_t SenderRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  uint64_t timestamp;
+  std::memcpy(&timestamp, data + offsetof(SenderRecord, timestamp), sizeof(timestamp));
+  return timestamp;
+}
+
+std::vector<TraceColumn> SenderRecordFormat::GetColumns(void) const
+{
+  return {
+      TRACE_COLUMN(SenderRecord, timestamp, DELTA),
+      TRACE_COLUMN(SenderRecord, uid, DELTA),
+      TRACE_COLUMN(SenderRecord, node, DICTIONARY),
+      TRACE_COLUMN(SenderRecord, size, DICTIONARY),
+      TRACE_COLUMN(SenderRecord, sequence, DELTA),
+  };
+}
+
+std::vector<TraceField> SenderRecordFormat::GetFields(void) const
+{
+  return {
+      {"timestamp", "f8", "s"},
+      {"size", "u4", "B"},
+      {"uid", "u8", ""},
+      {"sequence", "u4", ""},
+      {"node", "u4", ""},
+  };
+}
+
+std::string JoinedPacketRecordFormat::GetName(void) const
+{
+  return "joined";
+}
+
+uint32_t JoinedPacketRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(JoinedPacketRecord);
+}
+
+void JoinedPacketRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  JoinedPacketRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  PrintPacketFields(os, record.packet);
+  os << ',' << record.sender << ',' << NanoSeconds(record.sentTimestamp).GetSeconds() << "\n";
+}
+
+uint64_t JoinedPacketRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  return PacketRecordFormat().GetTimestamp(data);
+}
+
+bool JoinedPacketRecordFormat::GetFlow(const uint8_t *data, TraceFlow &flow) const
+{
+  return PacketRecordFormat().GetFlow(data, flow);
+}
+
+std::vector<TraceColumn> JoinedPacketRecordFormat::GetColumns(void) const
+{
+  std::vector<TraceColumn> columns = PacketRecordFormat().GetColumns();
+  columns.push_back(TRACE_COLUMN(JoinedPacketRecord, sentTimestamp, DELTA));
+  columns.push_back(TRACE_COLUMN(JoinedPacketRecord, sender, DICTIONARY));
+  return columns;
+}
+
+std::vector<TraceField> JoinedPacketRecordFormat::GetFields(void) const
+{
+  std::vector<TraceField> fields = PacketRecordFormat().GetFields();
+  fields.push_back({"sender", "u4", ""});
+  fields.push_back({"sentTimestamp", "f8", "s"});
+  return fields;
+}
+
+std::string DropPacketRecordFormat::GetName(void) const
+{
+  return "drop-packet";
+}
+
+uint32_t DropPacketRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(DropPacketRecord);
+}
+
+void DropPacketRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  DropPacketRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  PrintPacketFields(os, record.packet);
+  os << ',' << record.port << "\n";
+}
+
+uint64_t DropPacketRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  return PacketRecordFormat().GetTimestamp(data);
+}
+
+bool DropPacketRecordFormat::GetFlow(const uint8_t *data, TraceFlow &flow) const
+{
+  return PacketRecordFormat().GetFlow(data, flow);
+}
+
+std::vector<TraceColumn> DropPacketRecordFormat::GetColumns(void) const
+{
+  std::vector<TraceColumn> columns = PacketRecordFormat().GetColumns();
+  columns.push_back(TRACE_COLUMN(DropPacketRecord, port, DICTIONARY));
+  return columns;
+}
+
+std::vector<TraceField> DropPacketRecordFormat::GetFields(void) const
+{
+  std::vector<TraceField> fields = PacketRecordFormat().GetFields();
+  fields.push_back({"port", "u2", ""});
+  return fields;
+}
+
+std::string MessageRecordFormat::GetName(void) const
+{
+  return "message";
+}
+
+uint32_t MessageRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(MessageRecord);
+}
+
+void MessageRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  MessageRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  os << NanoSeconds(record.start).GetSeconds() << ','
+     << NanoSeconds(record.timestamp).GetSeconds() << ','
+     << NanoSeconds(record.timestamp - record.start).GetSeconds() << ','
+     << record.workload << ',' << record.application << ',' << record.message << ','
+     << record.size << ',' << record.packets << "\n";
+}
+
+uint64_t MessageRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  uint64_t timestamp;
+  std::memcpy(&timestamp, data + offsetof(MessageRecord, timestamp), sizeof(timestamp));
+  return timestamp;
+}
+
+std::vector<TraceColumn> MessageRecordFormat::GetColumns(void) const
+{
+  return {
+      TRACE_COLUMN(MessageRecord, timestamp, DELTA),
+      TRACE_COLUMN(MessageRecord, start, DELTA),
+      TRACE_COLUMN(MessageRecord, workload, DICTIONARY),
+      TRACE_COLUMN(MessageRecord, application, DICTIONARY),
+      TRACE_COLUMN(MessageRecord, message, DELTA),
+      TRACE_COLUMN(MessageRecord, size, PLAIN),
+      TRACE_COLUMN(MessageRecord, packets, PLAIN),
+  };
+}
+
+std::vector<TraceField> MessageRecordFormat::GetFields(void) const
+{
+  return {
+      {"start", "f8", "s"},
+      {"completion", "f8", "s"},
+      {"mct", "f8", "s"},
+      {"workload", "u4", ""},
+      {"application", "u4", ""},
+      {"message", "u4", ""},
+      {"size", "u4", "B"},
+      {"packets", "u4", ""},
+  };
+}
+
+std::string FlowWindowRecordFormat::GetName(void) const
+{
+  return "flow-window";
+}
+
+uint32_t FlowWindowRecordFormat::GetRecordSize(void) const
+{
+  return sizeof(FlowWindowRecord);
+}
+
+void FlowWindowRecordFormat::PrintCsv(std::ostream &os, const uint8_t *data) const
+{
+  FlowWindowRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  os << NanoSeconds(record.timestamp).GetSeconds() << ','
+     << Ipv4Address(record.source) << ',' << Ipv4Address(record.destination) << ','
+     << record.sourcePort << ',' << record.destinationPort << ','
+     << static_cast<uint32_t>(record.protocol) << ','
+     << record.packets << ',' << record.bytes << ','
+     << NanoSeconds(record.meanDelay).GetSeconds() << ','
+     << NanoSeconds(record.maxDelay).GetSeconds() << ','
+     << record.messages << "\n";
+}
+
+uint64_t FlowWindowRecordFormat::GetTimestamp(const uint8_t *data) const
+{
+  uint64_t timestamp;
+  std::memcpy(&timestamp, data + offsetof(FlowWindowRecord, timestamp), sizeof(timestamp));
+  return timestamp;
+}
+
+bool FlowWindowRecordFormat::GetFlow(const uint8_t *data, TraceFlow &flow) const
+{
+  FlowWindowRecord record;
+  std::memcpy(&record, data, sizeof(record));
+  flow.source = record.source;
+  flow.destination = record.destination;
+  flow.sourcePort = record.sourcePort;
+  flow.destinationPort = record.destinationPort;
+  flow.protocol = record.protocol;
+  return true;
+}
+
+std::vector<TraceColumn> FlowWindowRecordFormat::GetColumns(void) const
+{
+  return {
+      TRACE_COLUMN(FlowWindowRecord, timestamp, DELTA),
+      TRACE_COLUMN(FlowWindowRecord, bytes, PLAIN),
+      TRACE_COLUMN(FlowWindowRecord, meanDelay, PLAIN),
+      TRACE_COLUMN(FlowWindowRecord, maxDelay, PLAIN),
+      TRACE_COLUMN(FlowWindowRecord, packets, PLAIN),
+      TRACE_COLUMN(FlowWindowRecord, messages, PLAIN),
+      TRACE_COLUMN(FlowWindowRecord, source, DICTIONARY),
+      TRACE_COLUMN(FlowWindowRecord, destination, DICTIONARY),
+      TRACE_COLUMN(FlowWindowRecord, sourcePort, DICTIONARY),
+      TRACE_COLUMN(FlowWindowRecord, destinationPort, DICTIONARY),
+      TRACE_COLUMN(FlowWindowRecord, protocol, DICTIONARY),
+  };
+}
+
+std::vector<TraceField> FlowWindowRecordFormat::GetFields(void) const
+{
+  return {
+      {"timestamp", "f8", "s"},
+      {"source", "ip", ""},
+      {"destination", "ip", ""},
+      {"sourcePort", "u2", ""},
+      {"destinationPort", "u2", ""},
+      {"protocol", "u1", ""},
+      {"packets", "u4", ""},
+      {"bytes", "u8", "B"},
+      {"meanDelay", "f8", "s"},
+      {"maxDelay", "f8", "s"},
+      {"messages", "u4", ""},
+  };
+}
+
+Ptr<TraceFormat> CreateTraceFormat(std::string name)
+{
+  if (name == "packet")
+  {
+    return Create<PacketRecordFormat>();
+  }
+  if (name == "queue")
+  {
+    return Create<QueueRecordFormat>();
+  }
+  if (name == "drop" || name == "drop-sequence")
+  {
+    return Create<DropRecordFormat>(name == "drop-sequence");
+  }
+  if (name == "sender")
+  {
+    return Create<SenderRecordFormat>();
+  }
+  if (name == "joined")
+  {
+    return Create<JoinedPacketRecordFormat>();
+  }
+  if (name == "message")
+  {
+    return Create<MessageRecordFormat>();
+  }
+  if (name == "drop-packet")
+  {
+    return Create<DropPacketRecordFormat>();
+  }
+  if (name == "flow-window")
+  {
+    return Create<FlowWindowRecordFormat>();
+  }
+  return 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,476 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Fixed-size trace records, written by the trace callbacks of the
+// trafficgen simulations instead of formatting text on every packet.
+
+#ifndef TRACE_RECORD_H
+#define TRACE_RECORD_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3
+{
+
+#pragma pack(push, 1)
+/**
+ * \brief One received packet, with the fields of the packet csv.
+ *
+ * All integers are stored in host byte order, addresses as the integer
+ * value of the IPv4 address. Times are in nanoseconds of simulation time.
+ * The record also keeps the TCP fields that were only visible in the
+ * Packet::Print dump, so traces need no packet metadata.
+ */
+struct PacketRecord
+{
+  uint64_t timestamp;       //!< Time the packet was traced
+  uint64_t uid;             //!< Packet uid
+  int64_t delay;            //!< One-way delay since the sender timestamp
+  uint32_t size;            //!< Packet size, including all headers
+  uint32_t flowId;          //!< Flow id tag, zero if not tagged
+  uint32_t source;          //!< IPv4 source address
+  uint32_t destination;     //!< IPv4 destination address
+  uint32_t sequence;        //!< TCP sequence number
+  uint32_t workload;        //!< Workload id tag
+  uint32_t application;     //!< Application id tag
+  uint32_t message;         //!< Message id tag
+  uint32_t ackNumber;       //!< TCP acknowledgement number
+  uint16_t sourcePort;      //!< TCP/UDP source port
+  uint16_t destinationPort; //!< TCP/UDP destination port
+  uint16_t ipId;            //!< IPv4 identification
+  uint16_t payloadSize;     //!< IPv4 payload size
+  uint16_t window;          //!< TCP window size
+  uint8_t protocol;         //!< IPv4 protocol number
+  uint8_t dscp;             //!< IPv4 DSCP
+  uint8_t ecn;              //!< IPv4 ECN
+  uint8_t ttl;              //!< IPv4 TTL
+  uint8_t tcpFlags;         //!< TCP flags
+};
+
+/**
+ * \brief One change of a device queue, see TraceLogHelper::QueueLog.
+ */
+struct QueueRecord
+{
+  uint64_t timestamp; //!< Time of the change
+  uint32_t node;      //!< Node id of the device
+  uint32_t device;    //!< Device index on the node
+  uint32_t value;     //!< Packets in the queue after the change
+};
+
+/**
+ * \brief One packet dropped by a device, see TraceLogHelper::DropLog.
+ */
+struct DropRecord
+{
+  uint64_t timestamp; //!< Time of the drop
+  uint32_t node;      //!< Node id of the device
+  uint32_t device;    //!< Device index on the node
+  uint32_t size;      //!< Packet size, including all headers
+  uint32_t sequence;  //!< TCP sequence number, zero for other packets
+};
+
+/**
+ * \brief One packet sent by a sender, see logSenderPacket.
+ */
+struct SenderRecord
+{
+  uint64_t timestamp; //!< Time the packet was sent
+  uint64_t uid;       //!< Packet uid
+  uint32_t node;      //!< Node id of the sender
+  uint32_t size;      //!< Packet size, including all headers
+  uint32_t sequence;  //!< TCP sequence number
+};
+
+/**
+ * \brief A received packet joined with the record of its sender.
+ */
+struct JoinedPacketRecord
+{
+  PacketRecord packet;    //!< The packet at the receiver
+  uint64_t sentTimestamp; //!< Time the packet was sent
+  uint32_t sender;        //!< Node id of the sender
+};
+
+/**
+ * \brief An application packet dropped at a port, see ConnectDropPacketTrace.
+ */
+struct DropPacketRecord
+{
+  PacketRecord packet; //!< The packet, its delay is the time until the drop
+  uint16_t port;       //!< Port id of the device that dropped it
+};
+
+/**
+ * \brief One completed message, see MessageTracker.
+ */
+struct MessageRecord
+{
+  uint64_t timestamp;   //!< Time the last byte of the message was received
+  uint64_t start;       //!< Time the message was handed to the socket
+  uint32_t workload;    //!< Workload id tag
+  uint32_t application; //!< Application id tag
+  uint32_t message;     //!< Message id tag
+  uint32_t size;        //!< Message size in bytes
+  uint32_t packets;     //!< Received packets with data of the message
+};
+
+/**
+ * \brief The packets of one flow in one window, see FlowWindowTraceOutput.
+ */
+struct FlowWindowRecord
+{
+  uint64_t timestamp;       //!< Start of the window
+  uint64_t bytes;           //!< Bytes of the packets, including all headers
+  int64_t meanDelay;        //!< Mean one-way delay of the packets
+  int64_t maxDelay;         //!< Largest one-way delay of the packets
+  uint32_t packets;         //!< Number of packets
+  uint32_t messages;        //!< Number of distinct message ids
+  uint32_t source;          //!< IPv4 source address
+  uint32_t destination;     //!< IPv4 destination address
+  uint16_t sourcePort;      //!< TCP/UDP source port
+  uint16_t destinationPort; //!< TCP/UDP destination port
+  uint8_t protocol;         //!< IPv4 protocol number
+};
+
+/**
+ * \brief The 5-tuple identifying the flow of a record.
+ */
+struct TraceFlow
+{
+  uint32_t source;          //!< IPv4 source address
+  uint32_t destination;     //!< IPv4 destination address
+  uint16_t sourcePort;      //!< TCP/UDP source port
+  uint16_t destinationPort; //!< TCP/UDP destination port
+  uint8_t protocol;         //!< IPv4 protocol number
+};
+#pragma pack(pop)
+
+bool operator<(const TraceFlow &a, const TraceFlow &b);
+bool operator==(const TraceFlow &a, const TraceFlow &b);
+
+/**
+ * \brief Fill a record from a packet traced at a CsmaNetDevice.
+ *
+ * The packet must start with an Ethernet header. Packets without the
+ * TimestampTag and IdTag set by the senders are not application traffic
+ * and are skipped.
+ *
+ * \param p the traced packet
+ * \param record the record to fill
+ * \return true if the record was filled
+ */
+bool MakePacketRecord(Ptr<const Packet> p, PacketRecord &record);
+
+/**
+ * \brief Extract node id and device index from a trace context.
+ * \param context a config path like "/NodeList/3/DeviceList/1/..."
+ * \param node the node id
+ * \param device the device index
+ * \return false if the context does not have this form
+ */
+bool ParseDeviceContext(const std::string &context, uint32_t &node,
+                        uint32_t &device);
+
+/**
+ * \brief Fill a record from a PacketsInQueue trace.
+ * \param context the trace context
+ * \param value the new number of packets in the queue
+ * \param record the record to fill
+ */
+void MakeQueueRecord(const std::string &context, uint32_t value,
+                     QueueRecord &record);
+
+/**
+ * \brief Fill a record from a MacTxDrop trace.
+ * \param context the trace context
+ * \param p the dropped packet, starting with an Ethernet header
+ * \param record the record to fill
+ */
+void MakeDropRecord(const std::string &context, Ptr<const Packet> p,
+                    DropRecord &record);
+
+/**
+ * \brief One integer field of a record, as stored in columnar traces.
+ */
+struct TraceColumn
+{
+  /// Preferred encoding of the column.
+  enum Encoding
+  {
+    PLAIN,     //!< The values as they are
+    DELTA,     //!< Differences between consecutive values
+    DICTIONARY //!< Index into the distinct values of a chunk
+  };
+
+  std::string name;  //!< Name of the column, the record field name
+  uint32_t offset;   //!< Offset of the field in the record
+  uint32_t size;     //!< Size of the field, 1, 2, 4 or 8 bytes
+  bool isSigned;     //!< Whether the field is a signed integer
+  Encoding encoding; //!< Preferred encoding
+};
+
+/**
+ * \brief One column of the csv form of a record.
+ */
+struct TraceField
+{
+  std::string name; //!< Name of the column
+  std::string type; //!< u1, u2, u4, u8 (unsigned), i8, f8, ip (dotted quad) or str
+  std::string unit; //!< Unit of the values, e.g. "s" or "B", empty if none
+};
+
+/// Version of the csv schema block, see TraceFormat::PrintCsvSchema.
+const uint16_t TRACE_SCHEMA_VERSION = 1;
+
+/**
+ * \brief Description of one kind of fixed-size trace record.
+ *
+ * Trace outputs only see raw bytes, the format tells them how large a
+ * record is and how it is converted back to text.
+ */
+class TraceFormat : public SimpleRefCount<TraceFormat>
+{
+public:
+  virtual ~TraceFormat();
+
+  /**
+   * \return the name stored in the file header, e.g. "packet"
+   */
+  virtual std::string GetName(void) const = 0;
+  /**
+   * \return the size of one record in bytes
+   */
+  virtual uint32_t GetRecordSize(void) const = 0;
+  /**
+   * \brief Print one record as a line of text, including the newline.
+   * \param os the output stream
+   * \param record pointer to GetRecordSize() bytes
+   */
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const = 0;
+  /**
+   * \param record pointer to GetRecordSize() bytes
+   * \return the simulation time of the record in nanoseconds
+   */
+  virtual uint64_t GetTimestamp(const uint8_t *record) const = 0;
+  /**
+   * \brief Get the flow a record belongs to.
+   *
+   * The default implementation is for records without a flow.
+   *
+   * \param record pointer to GetRecordSize() bytes
+   * \param flow the flow to fill
+   * \return false if the record does not belong to a flow
+   */
+  virtual bool GetFlow(const uint8_t *record, TraceFlow &flow) const;
+  /**
+   * \return the fields of the record, in record order
+   */
+  virtual std::vector<TraceColumn> GetColumns(void) const = 0;
+  /**
+   * \return the columns of the csv form, in PrintCsv order
+   */
+  virtual std::vector<TraceField> GetFields(void) const = 0;
+
+  /**
+   * \brief Print the schema block that starts every csv trace of the
+   *        format:
+   *
+   *     # ntt-trace-schema <TRACE_SCHEMA_VERSION> <GetName()>
+   *     # types <type of every column>
+   *     # units <unit of every column>
+   *     <name of every column>
+   *
+   * Every PrintCsv line has exactly these columns. An empty value is
+   * null, e.g. the TCP columns of a UDP packet.
+   *
+   * \param os the output stream
+   * \param extra columns appended to every line by the caller
+   */
+  void PrintCsvSchema(std::ostream &os,
+                      const std::vector<TraceField> &extra = std::vector<TraceField>()) const;
+};
+
+/**
+ * \brief Format of PacketRecord.
+ *
+ * The csv has one column per record field, named like the field, with
+ * times in seconds. The ports are null for packets that are neither TCP
+ * nor UDP, the sequence and acknowledgement number, window and flags for
+ * packets that are not TCP. Both are also null for packets without a
+ * transport header, the non-first fragments of a datagram, which are
+ * recorded with zero ports.
+ */
+class PacketRecordFormat : public TraceFormat
+{
+public:
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual bool GetFlow(const uint8_t *record, TraceFlow &flow) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+};
+
+/**
+ * \brief Format of QueueRecord, printed like TraceLogHelper::QueueLog: the
+ *        columns are the trace source, the time in seconds and the packets
+ *        in the queue.
+ */
+class QueueRecordFormat : public TraceFormat
+{
+public:
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+};
+
+/**
+ * \brief Format of DropRecord, printed like TraceLogHelper::DropLog: the
+ *        columns are the trace source, the time in seconds and the packet
+ *        size.
+ *
+ * The test simulations also log the TCP sequence number of the dropped
+ * packet; the format is the same, only the csv has one more column.
+ */
+class DropRecordFormat : public TraceFormat
+{
+public:
+  /**
+   * \param printSequence whether the csv has the sequence number column
+   */
+  DropRecordFormat(bool printSequence = false);
+
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+
+private:
+  bool m_printSequence; //!< Print the sequence number column
+};
+
+/**
+ * \brief Format of SenderRecord, printed like logSenderPacket: the
+ *        columns are the send time in seconds, size, uid, TCP sequence
+ *        number and sender node.
+ */
+class SenderRecordFormat : public TraceFormat
+{
+public:
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+};
+
+/**
+ * \brief Format of JoinedPacketRecord.
+ *
+ * The csv form is the one of PacketRecordFormat with the sender node and
+ * send time appended.
+ */
+class JoinedPacketRecordFormat : public TraceFormat
+{
+public:
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual bool GetFlow(const uint8_t *record, TraceFlow &flow) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+};
+
+/**
+ * \brief Format of DropPacketRecord.
+ *
+ * The csv form is the one of PacketRecordFormat with the port id appended,
+ * so drops join with the delivered packets on the tag and flow columns.
+ */
+class DropPacketRecordFormat : public TraceFormat
+{
+public:
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual bool GetFlow(const uint8_t *record, TraceFlow &flow) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+};
+
+/**
+ * \brief Format of MessageRecord.
+ *
+ * The csv has the columns start, completion and message completion time
+ * in seconds, workload, application and message id, size and packets.
+ */
+class MessageRecordFormat : public TraceFormat
+{
+public:
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+};
+
+/**
+ * \brief Format of FlowWindowRecord.
+ *
+ * The csv has the columns window start, source and destination address
+ * and port, protocol, packets, bytes, mean and largest delay and distinct
+ * messages, times in seconds.
+ */
+class FlowWindowRecordFormat : public TraceFormat
+{
+public:
+  virtual std::string GetName(void) const;
+  virtual uint32_t GetRecordSize(void) const;
+  virtual void PrintCsv(std::ostream &os, const uint8_t *record) const;
+  virtual uint64_t GetTimestamp(const uint8_t *record) const;
+  virtual bool GetFlow(const uint8_t *record, TraceFlow &flow) const;
+  virtual std::vector<TraceColumn> GetColumns(void) const;
+  virtual std::vector<TraceField> GetFields(void) const;
+};
+
+/**
+ * \brief Look up a record format by the name stored in trace files.
+ * \param name the format name, see TraceFormat::GetName
+ * \return the format, or 0 if the name is unknown
+ */
+Ptr<TraceFormat> CreateTraceFormat(std::string name);
+
+} // namespace ns3
+
+#endif /* TRACE_RECORD_H */
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/config.h"
+#include "ns3/pointer.h"
+#include "ns3/queue.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/packet-header-view.h"
+#include "ns3/trace-sampler.h"
+
+#include "trace-registry.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("TraceRegistry");
+
+static void PacketTap(Ptr<TraceOutput> stream, Ptr<const Packet> p)
+{
+  PacketRecord record;
+  if (MakePacketRecord(p, record))
+  {
+    stream->Write(&record);
+  }
+}
+
+static void DropTap(Ptr<TraceOutput> stream, uint32_t node, uint32_t device,
+                    Ptr<const Packet> p)
+{
+  DropRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.timestamp = Simulator::Now().GetNanoSeconds();
+  record.node = node;
+  record.device = device;
+  record.size = p->GetSize();
+  record.sequence = PacketHeaderView(p).GetSequenceNumber();
+  stream->Write(&record);
+}
+
+static void QueueTap(Ptr<TraceOutput> stream, uint32_t node, uint32_t device,
+                     uint32_t oldValue, uint32_t newValue)
+{
+  QueueRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.timestamp = Simulator::Now().GetNanoSeconds();
+  record.node = node;
+  record.device = device;
+  record.value = newValue;
+  stream->Write(&record);
+}
+
+// Replace every {key} in the pattern by value.
+static void ReplaceAll(std::string &pattern, const std::string &key, uint32_t value)
+{
+  std::string text = std::to_string(value);
+  std::string::size_type pos;
+  while ((pos = pattern.find(key)) != std::string::npos)
+  {
+    pattern.replace(pos, key.size(), text);
+  }
+}
+
+TraceRegistry::TraceRegistry(Ptr<MuxTraceOutput> output, std::string sample)
+    : m_output(output),
+      m_sample(sample),
+      m_taps(0)
+{
+  NS_LOG_FUNCTION(this << sample);
+}
+
+void TraceRegistry::Load(std::string filename)
+{
+  NS_LOG_FUNCTION(this << filename);
+  std::ifstream file(filename.c_str());
+  NS_ABORT_MSG_UNLESS(file.is_open(), "Unable to open tap config " << filename);
+  std::string line;
+  uint32_t number = 0;
+  while (std::getline(file, line))
+  {
+    ++number;
+    line = line.substr(0, line.find('#'));
+    std::stringstream ss(line);
+    std::string devices;
+    std::string kind;
+    std::string name;
+    std::string rest;
+    if (!(ss >> devices))
+    {
+      continue;
+    }
+    NS_ABORT_MSG_UNLESS((ss >> kind >> name) && !(ss >> rest),
+                        filename << ":" << number << ": expected <devices> <kind> <name>");
+    NS_ABORT_MSG_IF(AddTap(devices, kind, name) == 0,
+                    filename << ":" << number << ": no device matches " << devices);
+  }
+}
+
+uint32_t TraceRegistry::AddTap(std::string devices, std::string kind, std::string name)
+{
+  NS_LOG_FUNCTION(this << devices << kind << name);
+  NS_ABORT_MSG_UNLESS(kind == "MacTx" || kind == "MacRx" || kind == "drop" || kind == "queue",
+                      "Unknown tap kind " << kind);
+  Config::MatchContainer matches = Config::LookupMatches(devices);
+  for (uint32_t i = 0; i < matches.GetN(); ++i)
+  {
+    Ptr<NetDevice> device = DynamicCast<NetDevice>(matches.Get(i));
+    NS_ABORT_MSG_UNLESS(device, matches.GetMatchedPath(i) << " is not a net device");
+    uint32_t nodeId = device->GetNode()->GetId();
+    uint32_t index = device->GetIfIndex();
+    std::string stream = name;
+    ReplaceAll(stream, "{node}", nodeId);
+    ReplaceAll(stream, "{device}", index);
+    ReplaceAll(stream, "{port}", index + 1);
+
+    // One sampler per tap, like one per log file without the registry.
+    Ptr<TraceSampler> sampler;
+    if (!m_sample.empty() && kind != "queue")
+    {
+      sampler = Create<TraceSampler>(m_sample);
+    }
+    bool ok;
+    if (kind == "queue")
+    {
+      PointerValue queue;
+      device->GetAttribute("TxQueue", queue);
+      Ptr<QueueBase> txQueue = queue.Get<QueueBase>();
+      NS_ABORT_MSG_UNLESS(txQueue, "Device " << index << " of node " << nodeId
+                                             << " has no TxQueue");
+      Ptr<TraceOutput> output = m_output->AddStream(stream, Create<QueueRecordFormat>());
+      ok = txQueue->TraceConnectWithoutContext(
+          "PacketsInQueue", MakeBoundCallback(&QueueTap, output, nodeId, index));
+    }
+    else if (kind == "drop")
+    {
+      Ptr<TraceOutput> output = m_output->AddStream(stream, Create<DropRecordFormat>(true));
+      ok = device->TraceConnectWithoutContext(
+          "MacTxDrop",
+          MakeSampledCallback(sampler, MakeBoundCallback(&DropTap, output, nodeId, index)));
+    }
+    else
+    {
+      Ptr<TraceOutput> output = m_output->AddStream(stream, Create<PacketRecordFormat>());
+      ok = device->TraceConnectWithoutContext(
+          kind, MakeSampledCallback(sampler, MakeBoundCallback(&PacketTap, output)));
+    }
+    NS_ABORT_MSG_UNLESS(ok, "Device " << index << " of node " << nodeId
+                                      << " has no trace for tap " << kind);
+    ++m_taps;
+  }
+  return matches.GetN();
+}
+
+uint32_t TraceRegistry::GetNTaps(void) const
+{
+  return m_taps;
+}
+
+} // namespace ns3
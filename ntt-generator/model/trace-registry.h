@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_REGISTRY_H
+#define TRACE_REGISTRY_H
+
+#include <stdint.h>
+#include <string>
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/mux-trace.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Connects trace taps listed in a config file, every tap writes a
+ *        stream of one MuxTraceOutput.
+ *
+ * Each line of the config file lists a tap as
+ *
+ *   <devices> <kind> <stream name>
+ *
+ * and '#' starts a comment. The devices are a config path matching net
+ * devices, e.g. "/NodeList/3/DeviceList/0" or, for nodes added to Names,
+ * "/Names/switchA/DeviceList/[0-2]". The kinds are
+ *
+ * - MacTx, MacRx: packet records of the packets sent or received
+ * - drop: drop records of the MacTxDrop trace
+ * - queue: queue records of the PacketsInQueue trace of the TxQueue
+ *
+ * The stream name may contain {node}, {device} and {port} (the device
+ * index plus one), which are replaced for every matched device.
+ *
+ * Every tap is a callback bound once to its stream and device. The sinks
+ * build the record on the stack and copy it into the buffer of the mux,
+ * so tracing does not allocate memory and there is no trace context to
+ * format or parse.
+ */
+class TraceRegistry : public SimpleRefCount<TraceRegistry>
+{
+public:
+  /**
+   * \param output the file every tap writes to
+   * \param sample the sampling policy of the packet and drop taps, see
+   *        TraceSampler; every packet is traced if empty
+   */
+  TraceRegistry(Ptr<MuxTraceOutput> output, std::string sample = "");
+
+  /**
+   * \brief Add the taps of a config file. Aborts on invalid lines.
+   * \param filename the config file
+   */
+  void Load(std::string filename);
+
+  /**
+   * \brief Connect a tap to every device matching a config path.
+   * \param devices the config path of the devices
+   * \param kind MacTx, MacRx, drop or queue
+   * \param name the stream name pattern
+   * \return the number of devices matched
+   */
+  uint32_t AddTap(std::string devices, std::string kind, std::string name);
+
+  /**
+   * \return the number of connected taps
+   */
+  uint32_t GetNTaps(void) const;
+
+private:
+  Ptr<MuxTraceOutput> m_output; //!< The shared file
+  std::string m_sample;         //!< Sampling policy of the packet taps
+  uint32_t m_taps;              //!< Connected taps
+};
+
+} // namespace ns3
+
+#endif /* TRACE_REGISTRY_H */
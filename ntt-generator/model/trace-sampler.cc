@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdlib>
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/experiment-tags.h"
+
+#include "trace-sampler.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("TraceSampler");
+
+// Hash of a flow, mixed so that the residues of consecutive application
+// ids are spread evenly (splitmix64 finalizer).
+static uint64_t FlowHash(uint32_t workload, uint32_t application)
+{
+  uint64_t h = (static_cast<uint64_t>(workload) << 32) | application;
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+// Parse an unsigned number of a rule, abort if it is not one.
+static uint32_t ParseCount(const std::string &rule, const std::string &value)
+{
+  char *end;
+  unsigned long count = std::strtoul(value.c_str(), &end, 10);
+  NS_ABORT_MSG_IF(value.empty() || *end != '\0', "Invalid sampling rule " << rule);
+  return count;
+}
+
+TraceSampler::TraceSampler(std::string policy)
+    : m_every(0),
+      m_everyCount(0),
+      m_flowModulus(0),
+      m_flowResidue(0),
+      m_window(false),
+      m_delayQuantile(0),
+      m_delayThreshold(0),
+      m_sinceUpdate(0),
+      m_selected(0),
+      m_rejected(0)
+{
+  NS_LOG_FUNCTION(this << policy);
+  std::stringstream ss(policy);
+  std::string rule;
+  while (std::getline(ss, rule, ','))
+  {
+    if (rule.empty())
+    {
+      continue;
+    }
+    std::string::size_type equals = rule.find('=');
+    NS_ABORT_MSG_IF(equals == std::string::npos, "Invalid sampling rule " << rule);
+    std::string key = rule.substr(0, equals);
+    std::string value = rule.substr(equals + 1);
+    if (key == "every")
+    {
+      m_every = ParseCount(rule, value);
+      NS_ABORT_MSG_IF(m_every == 0, "Invalid sampling rule " << rule);
+    }
+    else if (key == "flows")
+    {
+      std::string::size_type colon = value.find(':');
+      m_flowModulus = ParseCount(rule, value.substr(0, colon));
+      if (colon != std::string::npos)
+      {
+        m_flowResidue = ParseCount(rule, value.substr(colon + 1));
+      }
+      NS_ABORT_MSG_IF(m_flowModulus == 0 || m_flowResidue >= m_flowModulus,
+                      "Invalid sampling rule " << rule);
+    }
+    else if (key == "time")
+    {
+      std::string::size_type dash = value.find('-');
+      NS_ABORT_MSG_IF(dash == std::string::npos, "Invalid sampling rule " << rule);
+      m_window = true;
+      m_start = Time(value.substr(0, dash));
+      m_end = Time(value.substr(dash + 1));
+      NS_ABORT_MSG_IF(m_end < m_start, "Invalid sampling rule " << rule);
+    }
+    else if (key == "delay")
+    {
+      NS_ABORT_MSG_IF(value.size() < 2 || value[0] != 'p', "Invalid sampling rule " << rule);
+      char *end;
+      double percentile = std::strtod(value.c_str() + 1, &end);
+      NS_ABORT_MSG_IF(*end != '\0' || percentile <= 0 || percentile >= 100,
+                      "Invalid sampling rule " << rule);
+      m_delayQuantile = percentile / 100;
+    }
+    else
+    {
+      NS_FATAL_ERROR("Unknown sampling rule " << rule);
+    }
+  }
+}
+
+bool TraceSampler::Select(Ptr<const Packet> p)
+{
+  bool selected = true;
+  if (m_window)
+  {
+    Time now = Simulator::Now();
+    selected = now >= m_start && now <= m_end;
+  }
+  if (selected && m_flowModulus > 0)
+  {
+    IdTag idTag;
+    selected = p->PeekPacketTag(idTag) &&
+               FlowHash(idTag.GetWorkload(), idTag.GetApplication()) % m_flowModulus ==
+                   m_flowResidue;
+  }
+  if (selected && m_delayQuantile > 0)
+  {
+    selected = SelectDelay(p);
+  }
+  if (selected && m_every > 0)
+  {
+    selected = m_everyCount++ % m_every == 0;
+  }
+  if (selected)
+  {
+    ++m_selected;
+  }
+  else
+  {
+    ++m_rejected;
+  }
+  return selected;
+}
+
+bool TraceSampler::SelectDelay(Ptr<const Packet> p)
+{
+  TimestampTag timestampTag;
+  if (!p->PeekPacketTag(timestampTag))
+  {
+    return false;
+  }
+  uint64_t delay = (Simulator::Now() - timestampTag.GetTime()).GetNanoSeconds();
+  m_delays.Record(delay);
+  if (++m_sinceUpdate == DELAY_UPDATE)
+  {
+    m_delayThreshold = m_delays.GetQuantile(m_delayQuantile);
+    m_sinceUpdate = 0;
+  }
+  return delay > m_delayThreshold;
+}
+
+uint64_t TraceSampler::GetSelected(void) const
+{
+  return m_selected;
+}
+
+uint64_t TraceSampler::GetRejected(void) const
+{
+  return m_rejected;
+}
+
+static void SampledSink(Ptr<TraceSampler> sampler, Callback<void, Ptr<const Packet>> sink,
+                        Ptr<const Packet> p)
+{
+  if (sampler->Select(p))
+  {
+    sink(p);
+  }
+}
+
+static void SampledContextSink(Ptr<TraceSampler> sampler,
+                               Callback<void, std::string, Ptr<const Packet>> sink,
+                               std::string context, Ptr<const Packet> p)
+{
+  if (sampler->Select(p))
+  {
+    sink(context, p);
+  }
+}
+
+Callback<void, Ptr<const Packet>>
+MakeSampledCallback(Ptr<TraceSampler> sampler, Callback<void, Ptr<const Packet>> sink)
+{
+  if (!sampler)
+  {
+    return sink;
+  }
+  return MakeBoundCallback(&SampledSink, sampler, sink);
+}
+
+Callback<void, std::string, Ptr<const Packet>>
+MakeSampledCallback(Ptr<TraceSampler> sampler,
+                    Callback<void, std::string, Ptr<const Packet>> sink)
+{
+  if (!sampler)
+  {
+    return sink;
+  }
+  return MakeBoundCallback(&SampledContextSink, sampler, sink);
+}
+
+} // namespace ns3
@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_SAMPLER_H
+#define TRACE_SAMPLER_H
+
+#include <stdint.h>
+#include <string>
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/callback.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/delay-histogram.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Selects the packets a trace sink sees, from the packet tags only,
+ *        so rejected packets cost no header parsing or formatting.
+ *
+ * The policy is a comma separated list of rules, a packet is selected if
+ * all of them select it:
+ *
+ * - "time=START-END", e.g. "time=20s-40s": simulation time in [START, END]
+ * - "flows=K" or "flows=K:R": flows whose hash modulo K is R (default 0). A
+ *   flow is the workload and application of the IdTag, so every sampler
+ *   with the same rule selects the same flows.
+ * - "delay=pQ", e.g. "delay=p99": delay above the running estimate of the
+ *   quantile Q of the delays seen by this sampler. The estimate is updated
+ *   every DELAY_UPDATE delays, before the first update all delays are
+ *   above it.
+ * - "every=N": every Nth of the packets the other rules select.
+ *
+ * The rules are checked in this order. Packets without the tags a rule
+ * needs are rejected by it.
+ */
+class TraceSampler : public SimpleRefCount<TraceSampler>
+{
+public:
+  /// Delays recorded between two updates of the delay threshold.
+  static const uint32_t DELAY_UPDATE = 1024;
+
+  /**
+   * \param policy the rules, see the class description; selects every
+   *        packet if empty
+   */
+  TraceSampler(std::string policy);
+
+  /**
+   * \param p a packet about to be traced
+   * \return true if the packet is to be traced
+   */
+  bool Select(Ptr<const Packet> p);
+
+  /**
+   * \return the number of selected packets
+   */
+  uint64_t GetSelected(void) const;
+  /**
+   * \return the number of rejected packets
+   */
+  uint64_t GetRejected(void) const;
+
+private:
+  /**
+   * \param p a packet that passed the time and flow rules
+   * \return true if its delay is above the threshold
+   */
+  bool SelectDelay(Ptr<const Packet> p);
+
+  uint32_t m_every;          //!< Select every Nth packet, 0 if unused
+  uint64_t m_everyCount;     //!< Packets checked by the every rule
+  uint32_t m_flowModulus;    //!< Modulus of the flow hash, 0 if unused
+  uint32_t m_flowResidue;    //!< Selected flow hash residue
+  bool m_window;             //!< Whether the time rule is used
+  Time m_start;              //!< Start of the time rule
+  Time m_end;                //!< End of the time rule
+  double m_delayQuantile;    //!< Delay quantile, 0 if unused
+  DelayHistogram m_delays;   //!< Delays seen by the delay rule
+  uint64_t m_delayThreshold; //!< Current estimate of the quantile, in ns
+  uint32_t m_sinceUpdate;    //!< Delays recorded since the last update
+  uint64_t m_selected;       //!< Selected packets
+  uint64_t m_rejected;       //!< Rejected packets
+};
+
+/**
+ * \param sampler the sampler, or a null pointer to trace every packet
+ * \param sink the trace sink
+ * \return a callback passing the packets the sampler selects to the sink
+ */
+Callback<void, Ptr<const Packet>>
+MakeSampledCallback(Ptr<TraceSampler> sampler, Callback<void, Ptr<const Packet>> sink);
+
+/**
+ * \param sampler the sampler, or a null pointer to trace every packet
+ * \param sink the trace sink, with context
+ * \return a callback passing the packets the sampler selects to the sink
+ */
+Callback<void, std::string, Ptr<const Packet>>
+MakeSampledCallback(Ptr<TraceSampler> sampler,
+                    Callback<void, std::string, Ptr<const Packet>> sink);
+
+} // namespace ns3
+
+#endif /* TRACE_SAMPLER_H */
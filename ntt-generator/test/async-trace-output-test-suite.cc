@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the ring buffer and the background writer of the trace logs.
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "ns3/test.h"
+#include "ns3/trace-output.h"
+#include "ns3/spsc-ring.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief The ring buffer keeps its slots in order, is bounded and works
+ *        across a producer and a consumer thread.
+ */
+class SpscRingTestCase : public TestCase
+{
+public:
+  SpscRingTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+SpscRingTestCase::SpscRingTestCase()
+    : TestCase("Check the order and bounds of the SPSC ring")
+{
+}
+
+void SpscRingTestCase::DoRun(void)
+{
+  SpscRing ring(sizeof(uint64_t), 3);
+  NS_TEST_ASSERT_MSG_EQ(ring.GetCapacity(), 4, "Capacity not rounded to a power of two");
+  NS_TEST_ASSERT_MSG_EQ(ring.Front() == 0, true, "New ring not empty");
+
+  // Wrap around several times, with the ring full each time.
+  uint64_t next = 0;
+  uint64_t expected = 0;
+  for (uint32_t round = 0; round < 5; ++round)
+  {
+    while (ring.TryPush(&next))
+    {
+      ++next;
+    }
+    NS_TEST_ASSERT_MSG_EQ(next - expected, 4, "Ring does not hold its capacity");
+    for (const uint8_t *slot = ring.Front(); slot != 0; slot = ring.Front())
+    {
+      uint64_t value;
+      std::memcpy(&value, slot, sizeof(value));
+      NS_TEST_ASSERT_MSG_EQ(value, expected, "Slots out of order");
+      ring.Pop();
+      ++expected;
+    }
+    NS_TEST_ASSERT_MSG_EQ(expected, next, "Slots lost");
+  }
+
+  // One producer thread, the test is the consumer.
+  const uint64_t count = 100000;
+  SpscRing shared(sizeof(uint64_t), 64);
+  std::thread producer([&shared, count]() {
+    for (uint64_t i = 0; i < count; ++i)
+    {
+      while (!shared.TryPush(&i))
+      {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint64_t received = 0;
+  bool ordered = true;
+  while (received < count)
+  {
+    const uint8_t *slot = shared.Front();
+    if (slot == 0)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    uint64_t value;
+    std::memcpy(&value, slot, sizeof(value));
+    ordered = ordered && value == received;
+    shared.Pop();
+    ++received;
+  }
+  producer.join();
+  NS_TEST_ASSERT_MSG_EQ(ordered, true, "Slots out of order across threads");
+}
+
+/**
+ * \brief The background writer hands all records on in order, or counts
+ *        the ones it drops with the DROP policy.
+ */
+class AsyncTraceOutputTestCase : public TestCase
+{
+public:
+  AsyncTraceOutputTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+AsyncTraceOutputTestCase::AsyncTraceOutputTestCase()
+    : TestCase("Check the order and the overflow policies of the background writer")
+{
+}
+
+void AsyncTraceOutputTestCase::DoRun(void)
+{
+  const uint64_t count = 200000;
+  Ptr<RecordingTraceOutput<uint64_t>> sink = Create<RecordingTraceOutput<uint64_t>>();
+  Ptr<AsyncTraceOutput> output = Create<AsyncTraceOutput>(sink, sizeof(uint64_t), 64);
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    output->Write(&i);
+    if (i % 50000 == 0)
+    {
+      // Let the writer fall asleep on an empty ring.
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  output->Close();
+  NS_TEST_ASSERT_MSG_EQ(sink->m_closed, 1, "Sink not closed once");
+  NS_TEST_ASSERT_MSG_EQ(output->GetWritten(), count, "Records not counted");
+  NS_TEST_ASSERT_MSG_EQ(output->GetDropped(), 0, "Records dropped while blocking");
+  NS_TEST_ASSERT_MSG_EQ(sink->m_records.size(), count, "Records lost");
+  bool ordered = true;
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    ordered = ordered && sink->m_records[i] == i;
+  }
+  NS_TEST_ASSERT_MSG_EQ(ordered, true, "Records out of order");
+
+  // A stuck sink: the ring and the record the writer holds fill up, the
+  // rest is dropped.
+  Ptr<RecordingTraceOutput<uint64_t>> stuck = Create<RecordingTraceOutput<uint64_t>>();
+  stuck->m_blocked = true;
+  Ptr<AsyncTraceOutput> dropping =
+      Create<AsyncTraceOutput>(stuck, sizeof(uint64_t), 4, AsyncTraceOutput::DROP);
+  for (uint64_t i = 0; i < 100; ++i)
+  {
+    dropping->Write(&i);
+  }
+  NS_TEST_ASSERT_MSG_EQ(dropping->GetWritten() + dropping->GetDropped(), 100,
+                        "Records neither written nor dropped");
+  NS_TEST_ASSERT_MSG_EQ(dropping->GetWritten() <= 5, true, "More written than the ring holds");
+  stuck->m_blocked = false;
+  dropping->Close();
+  NS_TEST_ASSERT_MSG_EQ(stuck->m_records.size(), dropping->GetWritten(), "Written records lost");
+  NS_TEST_ASSERT_MSG_EQ(dropping->GetStalls(), 0, "Stalled with the DROP policy");
+}
+
+/**
+ * \brief Tests of the asynchronous trace output.
+ */
+class NttAsyncTraceOutputTestSuite : public TestSuite
+{
+public:
+  NttAsyncTraceOutputTestSuite();
+};
+
+NttAsyncTraceOutputTestSuite::NttAsyncTraceOutputTestSuite()
+    : TestSuite("ntt-async-trace-output", UNIT)
+{
+  AddTestCase(new SpscRingTestCase, TestCase::QUICK);
+  AddTestCase(new AsyncTraceOutputTestCase, TestCase::QUICK);
+}
+
+static NttAsyncTraceOutputTestSuite g_nttAsyncTraceOutputTestSuite;
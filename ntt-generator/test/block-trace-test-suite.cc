@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Round trips and index lookups of the block trace files.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/block-trace.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Block trace files hold all records, and the index finds the
+ *        blocks of a time range and of a flow.
+ */
+class BlockTraceTestCase : public TestCase
+{
+public:
+  BlockTraceTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+BlockTraceTestCase::BlockTraceTestCase()
+    : TestCase("Check the round trip and index of block trace files")
+{
+}
+
+void BlockTraceTestCase::DoRun(void)
+{
+  std::vector<PacketRecord> records;
+  for (uint32_t i = 0; i < TEST_RECORDS; ++i)
+  {
+    records.push_back(MakeTestRecord(i));
+  }
+  // A flow of a single record, in the eighth block.
+  records[500].destination = 0x0a0000ff;
+
+  std::string filename = CreateTempDirFilename("packets.ntz");
+  Ptr<TraceOutput> output = Create<BlockTraceOutput>(filename, Create<PacketRecordFormat>(),
+                                                     64 * sizeof(PacketRecord));
+  for (const PacketRecord &record : records)
+  {
+    output->Write(&record);
+  }
+  output->Close();
+
+  BlockTraceReader reader(filename);
+  NS_TEST_ASSERT_MSG_EQ(reader.GetFormat()->GetName(), "packet", "Wrong format");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetNBlocks(), (TEST_RECORDS + 63) / 64, "Wrong number of blocks");
+
+  std::vector<uint8_t> read;
+  std::vector<uint8_t> block;
+  for (uint32_t i = 0; i < reader.GetNBlocks(); ++i)
+  {
+    reader.ReadBlock(i, block);
+    NS_TEST_ASSERT_MSG_EQ(block.size(), reader.GetBlock(i).entry.records * sizeof(PacketRecord),
+                          "Wrong size of block " << i);
+    read.insert(read.end(), block.begin(), block.end());
+  }
+  NS_TEST_ASSERT_MSG_EQ(read.size(), TEST_RECORDS * sizeof(PacketRecord),
+                        "Wrong number of records");
+  NS_TEST_ASSERT_MSG_EQ(std::memcmp(read.data(), records.data(), read.size()), 0,
+                        "Records do not round trip");
+
+  std::vector<uint32_t> found = reader.FindBlocks(records[100].timestamp,
+                                                  records[130].timestamp);
+  NS_TEST_ASSERT_MSG_EQ(found.size(), 2, "Wrong blocks of a time range");
+  NS_TEST_ASSERT_MSG_EQ(found[0], 1, "Wrong blocks of a time range");
+  NS_TEST_ASSERT_MSG_EQ(found[1], 2, "Wrong blocks of a time range");
+
+  TraceFlow flow;
+  PacketRecordFormat().GetFlow(reinterpret_cast<const uint8_t *>(&records[500]), flow);
+  found = reader.FindBlocks(flow);
+  NS_TEST_ASSERT_MSG_EQ(found.size(), 1, "Wrong blocks of a flow");
+  NS_TEST_ASSERT_MSG_EQ(found[0], 500 / 64, "Wrong blocks of a flow");
+}
+
+/**
+ * \brief Tests of the block trace files.
+ */
+class NttBlockTraceTestSuite : public TestSuite
+{
+public:
+  NttBlockTraceTestSuite();
+};
+
+NttBlockTraceTestSuite::NttBlockTraceTestSuite()
+    : TestSuite("ntt-block-trace", UNIT)
+{
+  AddTestCase(new BlockTraceTestCase, TestCase::QUICK);
+}
+
+static NttBlockTraceTestSuite g_nttBlockTraceTestSuite;
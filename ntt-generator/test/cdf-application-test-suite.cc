@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the send backlog of the CdfApplication.
+
+#include <fstream>
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/mac48-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/cdf-table.h"
+#include "ns3/cdf-application.h"
+
+using namespace ns3;
+
+// Count the messages dropped from the full backlog.
+static void CountDrop(uint64_t *drops, Ptr<const Packet> message)
+{
+  ++*drops;
+}
+
+/**
+ * \brief Messages wait in a bounded backlog while the send buffer is
+ *        full, and newer ones are dropped once it is full too.
+ */
+class CdfApplicationBacklogTestCase : public TestCase
+{
+public:
+  CdfApplicationBacklogTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+CdfApplicationBacklogTestCase::CdfApplicationBacklogTestCase()
+    : TestCase("Check the send backlog of the CdfApplication")
+{
+}
+
+void CdfApplicationBacklogTestCase::DoRun(void)
+{
+  // Messages of 10 kB at 10 Mbit/s over a link of 1 Mbit/s to a receiver
+  // that never reads, so the send buffer fills up.
+  std::string filename = CreateTempDirFilename("backlog.txt");
+  {
+    std::ofstream os(filename.c_str());
+    os << "10000\n10000 1\n";
+  }
+
+  NodeContainer nodes;
+  nodes.Create(2);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nodes.GetN(); ++i)
+  {
+    Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice>();
+    device->SetAddress(Mac48Address::Allocate());
+    device->SetChannel(channel);
+    device->SetAttribute("DataRate", DataRateValue(DataRate("1Mbps")));
+    nodes.Get(i)->AddDevice(device);
+    devices.Add(device);
+  }
+  InternetStackHelper internet;
+  internet.Install(nodes);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = addresses.Assign(devices);
+
+  Ptr<Socket> receiver = Socket::CreateSocket(nodes.Get(1), TcpSocketFactory::GetTypeId());
+  receiver->Bind(InetSocketAddress(Ipv4Address::GetAny(), 9));
+  receiver->Listen();
+
+  Ptr<CdfApplication> application = CreateObject<CdfApplication>();
+  application->SetAttribute("Protocol", TypeIdValue(TcpSocketFactory::GetTypeId()));
+  application->SetAttribute("Remote", AddressValue(InetSocketAddress(interfaces.GetAddress(1), 9)));
+  application->SetAttribute("DataRate", DataRateValue(DataRate("10Mbps")));
+  application->SetAttribute("CdfFile", StringValue(filename));
+  application->SetAttribute("MaxBacklog", UintegerValue(4));
+  application->SetStartTime(Seconds(0.1));
+  application->SetStopTime(Seconds(2));
+  nodes.Get(0)->AddApplication(application);
+  uint64_t drops = 0;
+  application->TraceConnectWithoutContext("TxDrop", MakeBoundCallback(&CountDrop, &drops));
+
+  Simulator::Stop(Seconds(3));
+  Simulator::Run();
+
+  NS_TEST_ASSERT_MSG_GT(application->GetDeferred(), 0, "No message waited for buffer space");
+  NS_TEST_ASSERT_MSG_GT(application->GetDropped(), 0, "No message dropped");
+  NS_TEST_ASSERT_MSG_EQ(drops, application->GetDropped(), "Drops not traced");
+  NS_TEST_ASSERT_MSG_EQ(application->GetBacklog() <= 4, true, "Backlog exceeds its limit");
+  NS_TEST_ASSERT_MSG_EQ(application->GetFailed(), 0, "Stream socket refused a message");
+  Simulator::Destroy();
+  CdfTable::ClearCache();
+}
+
+/**
+ * \brief Tests of the CdfApplication.
+ */
+class NttCdfApplicationTestSuite : public TestSuite
+{
+public:
+  NttCdfApplicationTestSuite();
+};
+
+NttCdfApplicationTestSuite::NttCdfApplicationTestSuite()
+    : TestSuite("ntt-cdf-application", UNIT)
+{
+  AddTestCase(new CdfApplicationBacklogTestCase, TestCase::QUICK);
+}
+
+static NttCdfApplicationTestSuite g_nttCdfApplicationTestSuite;
@@ -0,0 +1,342 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the shared message size tables.
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/cdf-table.h"
+
+using namespace ns3;
+
+// A table of many points with steps of different sizes, so that some
+// slices of the guide table hold several points and others none.
+static void MakeTestPoints(std::vector<double> &values, std::vector<double> &cdfs)
+{
+  const uint32_t points = 300;
+  for (uint32_t i = 0; i < points; ++i)
+  {
+    double x = static_cast<double>(i) / (points - 1);
+    values.push_back(100 + 10 * i * i);
+    cdfs.push_back(x * x * x);
+  }
+}
+
+// Write the points as a CDF file, see CdfTable.
+static void WriteCdfFile(std::string filename, double averageSize,
+                         const std::vector<double> &values, const std::vector<double> &cdfs)
+{
+  std::ofstream os(filename.c_str());
+  os.precision(17);
+  os << averageSize << "\n";
+  for (uint32_t i = 0; i < values.size(); ++i)
+  {
+    os << values[i] << " " << cdfs[i] << "\n";
+  }
+}
+
+/**
+ * \brief Sizes are interpolated linearly between the points, and the mean
+ *        is the one of the interpolated sizes.
+ */
+class CdfTableInterpolationTestCase : public TestCase
+{
+public:
+  CdfTableInterpolationTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+CdfTableInterpolationTestCase::CdfTableInterpolationTestCase()
+    : TestCase("Check the interpolated sizes and the mean of CDF tables")
+{
+}
+
+void CdfTableInterpolationTestCase::DoRun(void)
+{
+  CdfTable table(200, {100, 200, 400}, {0.2, 0.6, 1.0});
+  NS_TEST_ASSERT_MSG_EQ(table.GetNPoints(), 3, "Wrong number of points");
+  NS_TEST_ASSERT_MSG_EQ(table.GetAverageSize(), 200, "Wrong average size");
+  NS_TEST_ASSERT_MSG_EQ(table.IsMapped(), false, "Parsed table is mapped");
+  NS_TEST_ASSERT_MSG_EQ(table.Sample(0), 100, "Wrong size below the first point");
+  NS_TEST_ASSERT_MSG_EQ(table.Sample(0.2), 100, "Wrong size at the first point");
+  NS_TEST_ASSERT_MSG_EQ_TOL(table.Sample(0.4), 150, 1e-9, "Wrong interpolated size");
+  NS_TEST_ASSERT_MSG_EQ_TOL(table.Sample(0.6), 200, 1e-9, "Wrong size at a point");
+  NS_TEST_ASSERT_MSG_EQ_TOL(table.Sample(0.8), 300, 1e-9, "Wrong interpolated size");
+  NS_TEST_ASSERT_MSG_EQ_TOL(table.GetMean(), 200, 1e-9, "Wrong mean");
+
+  // The last size for the variates above the last probability.
+  CdfTable below(0, {100, 300}, {0.5, 0.75});
+  NS_TEST_ASSERT_MSG_EQ(below.Sample(0.9), 300, "Wrong size above the last point");
+  NS_TEST_ASSERT_MSG_EQ_TOL(below.GetMean(), 175, 1e-9, "Wrong mean of a short table");
+  // No variate reaches a probability above 1.
+  CdfTable above(0, {0, 100}, {0, 2});
+  NS_TEST_ASSERT_MSG_EQ_TOL(above.Sample(0.5), 25, 1e-9, "Wrong size of a long table");
+  NS_TEST_ASSERT_MSG_EQ_TOL(above.GetMean(), 25, 1e-9, "Wrong mean of a long table");
+
+  // The mean of evenly spread variates.
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  MakeTestPoints(values, cdfs);
+  // A point of zero probability.
+  cdfs[151] = cdfs[150];
+  CdfTable many(2000, values, cdfs);
+  NS_TEST_ASSERT_MSG_EQ(many.Sample(cdfs[150]), values[151], "Wrong size at a repeated point");
+  double sum = 0;
+  const uint32_t draws = 1000000;
+  for (uint32_t i = 0; i < draws; ++i)
+  {
+    sum += many.Sample((i + 0.5) / draws);
+  }
+  NS_TEST_ASSERT_MSG_EQ_TOL(sum / draws, many.GetMean(), 1e-4 * many.GetMean(),
+                            "Mean of the drawn sizes differs from the table mean");
+}
+
+/**
+ * \brief The guide table maps every variate to the same size as a binary
+ *        search, also at the edges of the table.
+ */
+class CdfTableSampleTestCase : public TestCase
+{
+public:
+  CdfTableSampleTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+CdfTableSampleTestCase::CdfTableSampleTestCase()
+    : TestCase("Check the guide table of CDF tables against a binary search")
+{
+}
+
+void CdfTableSampleTestCase::DoRun(void)
+{
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  MakeTestPoints(values, cdfs);
+  // A point of zero probability.
+  cdfs[151] = cdfs[150];
+  CdfTable table(2000, values, cdfs);
+
+  bool equal = true;
+  for (uint32_t i = 0; i < 1000000; ++i)
+  {
+    double u = i / 1000000.0;
+    equal = equal && table.Sample(u) == table.SampleSearch(u);
+  }
+  // The probabilities of the points themselves, and their neighbours.
+  for (double cdf : cdfs)
+  {
+    for (double u : {cdf, std::nextafter(cdf, 0.0), std::nextafter(cdf, 1.0)})
+    {
+      if (u >= 0 && u < 1)
+      {
+        equal = equal && table.Sample(u) == table.SampleSearch(u);
+      }
+    }
+  }
+  NS_TEST_ASSERT_MSG_EQ(equal, true, "Guide table differs from the binary search");
+  NS_TEST_ASSERT_MSG_EQ(table.Sample(0), values[0], "Wrong size at the first point");
+  NS_TEST_ASSERT_MSG_EQ(table.Sample(cdfs[150]), values[151], "Point of zero probability drawn");
+  NS_TEST_ASSERT_MSG_EQ_TOL(table.Sample(std::nextafter(1.0, 0.0)), values.back(), 1e-6,
+                            "Wrong size at the last point");
+}
+
+/**
+ * \brief Sizes drawn from a table are the ones an EmpiricalRandomVariable
+ *        of the same points draws from the same stream.
+ */
+class CdfTableEmpiricalTestCase : public TestCase
+{
+public:
+  CdfTableEmpiricalTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+CdfTableEmpiricalTestCase::CdfTableEmpiricalTestCase()
+    : TestCase("Check that CDF tables draw like EmpiricalRandomVariable")
+{
+}
+
+void CdfTableEmpiricalTestCase::DoRun(void)
+{
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  MakeTestPoints(values, cdfs);
+  CdfTable table(2000, values, cdfs);
+
+  Ptr<EmpiricalRandomVariable> empirical = CreateObject<EmpiricalRandomVariable>();
+  empirical->SetStream(7);
+  for (uint32_t i = 0; i < values.size(); ++i)
+  {
+    empirical->CDF(values[i], cdfs[i]);
+  }
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable>();
+  uniform->SetStream(7);
+
+  uint32_t differences = 0;
+  double sum = 0;
+  const uint32_t draws = 100000;
+  for (uint32_t i = 0; i < draws; ++i)
+  {
+    double size = table.Sample(uniform->GetValue());
+    differences += size != empirical->GetValue();
+    sum += size;
+  }
+  NS_TEST_ASSERT_MSG_EQ(differences, 0, "Sizes differ from EmpiricalRandomVariable");
+  NS_TEST_ASSERT_MSG_EQ_TOL(sum / draws, table.GetMean(), 0.02 * table.GetMean(),
+                            "Mean of the drawn sizes differs from the table mean");
+}
+
+/**
+ * \brief Parsed tables are cached per file until the cache is cleared.
+ */
+class CdfTableFileTestCase : public TestCase
+{
+public:
+  CdfTableFileTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+CdfTableFileTestCase::CdfTableFileTestCase()
+    : TestCase("Check the cache of parsed CDF files")
+{
+}
+
+void CdfTableFileTestCase::DoRun(void)
+{
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  MakeTestPoints(values, cdfs);
+  CdfTable expected(2000, values, cdfs);
+  std::string filename = CreateTempDirFilename("sizes.txt");
+  WriteCdfFile(filename, 2000, values, cdfs);
+
+  CdfTable::ClearCache();
+  Ptr<const CdfTable> loaded = CdfTable::Load(filename);
+  NS_TEST_ASSERT_MSG_EQ(bool(loaded), true, "CDF file not parsed");
+  NS_TEST_ASSERT_MSG_EQ((CdfTable::Load(filename) == loaded), true, "Table not cached");
+  NS_TEST_ASSERT_MSG_EQ(CdfTable::GetCacheSize(), 1, "Wrong number of cached tables");
+  NS_TEST_ASSERT_MSG_EQ(bool(CdfTable::Load(CreateTempDirFilename("missing.txt"))), false,
+                        "Missing file parsed");
+
+  NS_TEST_ASSERT_MSG_EQ(loaded->GetNPoints(), expected.GetNPoints(), "Wrong number of points");
+  NS_TEST_ASSERT_MSG_EQ(loaded->GetAverageSize(), expected.GetAverageSize(),
+                        "Wrong average size");
+  NS_TEST_ASSERT_MSG_EQ(loaded->GetMean(), expected.GetMean(), "Wrong mean");
+  bool equal = true;
+  for (uint32_t i = 0; i < 100000; ++i)
+  {
+    double u = i / 100000.0;
+    equal = equal && loaded->Sample(u) == expected.Sample(u);
+  }
+  NS_TEST_ASSERT_MSG_EQ(equal, true, "Table does not round trip");
+
+  CdfTable::ClearCache();
+  NS_TEST_ASSERT_MSG_EQ(CdfTable::GetCacheSize(), 0, "Cache not cleared");
+  NS_TEST_ASSERT_MSG_EQ(loaded->Sample(0.5), expected.Sample(0.5), "Table in use invalidated");
+  NS_TEST_ASSERT_MSG_EQ((CdfTable::Load(filename) == loaded), false, "Cache not cleared");
+}
+
+/**
+ * \brief Compiled files map to a table equal to the parsed one, which
+ *        stays valid after the cache is cleared.
+ */
+class CdfTableCompiledTestCase : public TestCase
+{
+public:
+  CdfTableCompiledTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+CdfTableCompiledTestCase::CdfTableCompiledTestCase()
+    : TestCase("Check the round trip of compiled CDF files")
+{
+}
+
+void CdfTableCompiledTestCase::DoRun(void)
+{
+  NS_TEST_ASSERT_MSG_EQ(CdfTable::GetCompiledName("dist/web.txt"), "dist/web.cdfb",
+                        "Extension not replaced");
+  NS_TEST_ASSERT_MSG_EQ(CdfTable::GetCompiledName("dist.v2/web"), "dist.v2/web.cdfb",
+                        "Extension of a directory replaced");
+
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  MakeTestPoints(values, cdfs);
+  CdfTable expected(2000, values, cdfs);
+  std::string filename = CreateTempDirFilename("sizes.txt");
+  WriteCdfFile(filename, 2000, values, cdfs);
+
+  CdfTable::ClearCache();
+  std::string compiled = CdfTable::GetCompiledName(filename);
+  NS_TEST_ASSERT_MSG_EQ(expected.Save(compiled), true, "Compiled file not written");
+  Ptr<const CdfTable> mapped = CdfTable::Map(compiled);
+  NS_TEST_ASSERT_MSG_EQ(bool(mapped), true, "Compiled file not mapped");
+  NS_TEST_ASSERT_MSG_EQ(mapped->IsMapped(), true, "Compiled table not mapped");
+  NS_TEST_ASSERT_MSG_EQ((CdfTable::Map(compiled) == mapped), true, "Mapped table not cached");
+  NS_TEST_ASSERT_MSG_EQ(bool(CdfTable::Map(filename)), false, "Text file mapped");
+  NS_TEST_ASSERT_MSG_EQ(CdfTable::GetCacheSize(), 1, "Wrong number of cached tables");
+
+  NS_TEST_ASSERT_MSG_EQ(mapped->GetNPoints(), expected.GetNPoints(), "Wrong number of points");
+  NS_TEST_ASSERT_MSG_EQ(mapped->GetAverageSize(), expected.GetAverageSize(),
+                        "Wrong average size");
+  NS_TEST_ASSERT_MSG_EQ(mapped->GetMean(), expected.GetMean(), "Wrong mean");
+  bool equal = true;
+  for (uint32_t i = 0; i < 100000; ++i)
+  {
+    double u = i / 100000.0;
+    equal = equal && mapped->Sample(u) == expected.Sample(u);
+  }
+  NS_TEST_ASSERT_MSG_EQ(equal, true, "Table does not round trip");
+
+  CdfTable::ClearCache();
+  NS_TEST_ASSERT_MSG_EQ(mapped->Sample(0.5), expected.Sample(0.5), "Table in use unmapped");
+}
+
+/**
+ * \brief Tests of the message size tables.
+ */
+class NttCdfTableTestSuite : public TestSuite
+{
+public:
+  NttCdfTableTestSuite();
+};
+
+NttCdfTableTestSuite::NttCdfTableTestSuite()
+    : TestSuite("ntt-cdf-table", UNIT)
+{
+  AddTestCase(new CdfTableInterpolationTestCase, TestCase::QUICK);
+  AddTestCase(new CdfTableSampleTestCase, TestCase::QUICK);
+  AddTestCase(new CdfTableEmpiricalTestCase, TestCase::QUICK);
+  AddTestCase(new CdfTableFileTestCase, TestCase::QUICK);
+  AddTestCase(new CdfTableCompiledTestCase, TestCase::QUICK);
+}
+
+static NttCdfTableTestSuite g_nttCdfTableTestSuite;
@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Round trips of the columnar trace files, decoded by hand.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/columnar-trace.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Columnar trace files decode to the records written, following
+ *        the layout documented in columnar-trace.h.
+ */
+class ColumnarTraceTestCase : public TestCase
+{
+public:
+  ColumnarTraceTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+ColumnarTraceTestCase::ColumnarTraceTestCase()
+    : TestCase("Check the round trip of columnar trace files")
+{
+}
+
+void ColumnarTraceTestCase::DoRun(void)
+{
+  Ptr<const TraceFormat> format = Create<PacketRecordFormat>();
+  std::vector<PacketRecord> records;
+  for (uint32_t i = 0; i < TEST_RECORDS; ++i)
+  {
+    records.push_back(MakeTestRecord(i));
+  }
+  std::string filename = CreateTempDirFilename("packets.ntc");
+  Ptr<TraceOutput> output = Create<ColumnarTraceOutput>(filename, format, 300);
+  for (const PacketRecord &record : records)
+  {
+    output->Write(&record);
+  }
+  output->Close();
+
+  std::vector<uint8_t> file = ReadFile(filename);
+  NS_TEST_ASSERT_MSG_EQ(file.size() > sizeof(TraceFileHeader), true, "File too short");
+  NS_TEST_ASSERT_MSG_EQ(std::string(reinterpret_cast<const char *>(file.data()), 4), "NTTC",
+                        "Wrong magic");
+  size_t offset = sizeof(TraceFileHeader);
+
+  std::vector<TraceColumn> columns = format->GetColumns();
+  NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(&file[offset], 2), columns.size(),
+                        "Wrong number of columns");
+  offset += 2;
+  for (const TraceColumn &column : columns)
+  {
+    std::string name(reinterpret_cast<const char *>(&file[offset + 1]), file[offset]);
+    NS_TEST_ASSERT_MSG_EQ(name, column.name, "Wrong column name");
+    offset += 1 + name.size();
+    NS_TEST_ASSERT_MSG_EQ(uint32_t(file[offset]), column.size, "Wrong column size");
+    NS_TEST_ASSERT_MSG_EQ(bool(file[offset + 1]), column.isSigned, "Wrong column sign");
+    offset += 2;
+  }
+
+  std::vector<uint8_t> read;
+  uint32_t chunks = 0;
+  while (offset < file.size())
+  {
+    uint32_t rows = ReadLittleEndian(&file[offset], 4);
+    offset += 4;
+    std::vector<uint8_t> encodings;
+    std::vector<uint32_t> lengths;
+    for (uint32_t i = 0; i < columns.size(); ++i)
+    {
+      encodings.push_back(file[offset]);
+      lengths.push_back(ReadLittleEndian(&file[offset + 1], 4));
+      offset += 5;
+    }
+    std::vector<uint8_t> chunk(rows * format->GetRecordSize());
+    for (uint32_t i = 0; i < columns.size(); ++i)
+    {
+      const TraceColumn &column = columns[i];
+      const uint8_t *data = &file[offset];
+      std::vector<uint64_t> values(rows);
+      if (encodings[i] == TraceColumn::DELTA)
+      {
+        uint64_t value = ReadLittleEndian(data, 8);
+        uint32_t width = data[8];
+        for (uint32_t row = 0; row < rows; ++row)
+        {
+          uint64_t zigzag = ReadLittleEndian(data + 9 + row * width, width);
+          value += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+          values[row] = value;
+        }
+      }
+      else if (encodings[i] == TraceColumn::DICTIONARY)
+      {
+        uint32_t distinct = ReadLittleEndian(data, 4);
+        const uint8_t *indices = data + 4 + distinct * column.size;
+        uint32_t width = indices[0];
+        for (uint32_t row = 0; row < rows; ++row)
+        {
+          uint64_t index = ReadLittleEndian(indices + 1 + row * width, width);
+          values[row] = ReadLittleEndian(data + 4 + index * column.size, column.size);
+        }
+      }
+      else
+      {
+        for (uint32_t row = 0; row < rows; ++row)
+        {
+          values[row] = ReadLittleEndian(data + row * column.size, column.size);
+        }
+      }
+      for (uint32_t row = 0; row < rows; ++row)
+      {
+        uint8_t *field = &chunk[row * format->GetRecordSize() + column.offset];
+        for (uint32_t byte = 0; byte < column.size; ++byte)
+        {
+          field[byte] = values[row] >> (8 * byte);
+        }
+      }
+      offset += lengths[i];
+    }
+    read.insert(read.end(), chunk.begin(), chunk.end());
+    ++chunks;
+  }
+  NS_TEST_ASSERT_MSG_EQ(offset, file.size(), "Chunk lengths do not add up to the file");
+  NS_TEST_ASSERT_MSG_EQ(chunks, (TEST_RECORDS + 299) / 300, "Wrong number of chunks");
+  NS_TEST_ASSERT_MSG_EQ(read.size(), TEST_RECORDS * sizeof(PacketRecord),
+                        "Wrong number of records");
+  NS_TEST_ASSERT_MSG_EQ(std::memcmp(read.data(), records.data(), read.size()), 0,
+                        "Records do not round trip");
+}
+
+/**
+ * \brief Tests of the columnar trace files.
+ */
+class NttColumnarTraceTestSuite : public TestSuite
+{
+public:
+  NttColumnarTraceTestSuite();
+};
+
+NttColumnarTraceTestSuite::NttColumnarTraceTestSuite()
+    : TestSuite("ntt-columnar-trace", UNIT)
+{
+  AddTestCase(new ColumnarTraceTestCase, TestCase::QUICK);
+}
+
+static NttColumnarTraceTestSuite g_nttColumnarTraceTestSuite;
@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the delay histograms and their files.
+
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/delay-histogram.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Merged histograms equal the histogram of all values, and
+ *        histograms round trip through their file encoding.
+ */
+class DelayHistogramTestCase : public TestCase
+{
+public:
+  DelayHistogramTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+DelayHistogramTestCase::DelayHistogramTestCase()
+    : TestCase("Check the buckets, merge and encoding of delay histograms")
+{
+}
+
+void DelayHistogramTestCase::DoRun(void)
+{
+  DelayHistogram low;
+  DelayHistogram high;
+  DelayHistogram all;
+  for (uint64_t value = 0; value < 100000; value += 7)
+  {
+    low.Record(value);
+    all.Record(value);
+  }
+  for (uint64_t value = 50000; value < 100000000; value = value * 21 / 20 + 3)
+  {
+    high.Record(value);
+    all.Record(value);
+  }
+
+  // Every value lies in its bucket, which is at most 1/128 of it wide.
+  for (uint64_t value = 1; value < (static_cast<uint64_t>(1) << 40); value = value * 3 + 1)
+  {
+    uint32_t bucket = DelayHistogram::GetBucket(value);
+    uint64_t start = DelayHistogram::GetBucketStart(bucket);
+    uint64_t width = DelayHistogram::GetBucketWidth(bucket);
+    NS_TEST_ASSERT_MSG_EQ(start <= value && value < start + width, true,
+                          "Value " << value << " not in its bucket");
+    NS_TEST_ASSERT_MSG_EQ(width == 1 || width * 128 <= start, true,
+                          "Bucket of " << value << " too wide");
+  }
+
+  DelayHistogram merged = low;
+  merged.Merge(high);
+  NS_TEST_ASSERT_MSG_EQ(merged.GetCount(), all.GetCount(), "Merge lost values");
+  NS_TEST_ASSERT_MSG_EQ(merged.GetMin(), all.GetMin(), "Wrong minimum after merge");
+  NS_TEST_ASSERT_MSG_EQ(merged.GetMax(), all.GetMax(), "Wrong maximum after merge");
+  NS_TEST_ASSERT_MSG_EQ(merged.GetQuantile(0.99), all.GetQuantile(0.99),
+                        "Wrong quantile after merge");
+  std::vector<uint8_t> mergedData;
+  std::vector<uint8_t> allData;
+  merged.Serialize(mergedData);
+  all.Serialize(allData);
+  NS_TEST_ASSERT_MSG_EQ((mergedData == allData), true, "Merge differs from recording all values");
+
+  DelayHistogram uniform;
+  for (uint64_t value = 1; value <= 10000; ++value)
+  {
+    uniform.Record(value);
+  }
+  NS_TEST_ASSERT_MSG_EQ_TOL(uniform.GetMean(), 5000.5, 1e-9, "Wrong mean");
+  NS_TEST_ASSERT_MSG_EQ_TOL(double(uniform.GetQuantile(0.5)), 5000, 5000 / 128.0 + 1,
+                            "Median outside the bucket error");
+
+  size_t offset = 0;
+  DelayHistogram read;
+  NS_TEST_ASSERT_MSG_EQ(read.Deserialize(allData.data(), allData.size(), offset), true,
+                        "Encoding not accepted");
+  NS_TEST_ASSERT_MSG_EQ(offset, allData.size(), "Encoding not read to its end");
+  std::vector<uint8_t> readData;
+  read.Serialize(readData);
+  NS_TEST_ASSERT_MSG_EQ((readData == allData), true, "Histogram does not round trip");
+  offset = 0;
+  NS_TEST_ASSERT_MSG_EQ(read.Deserialize(allData.data(), allData.size() / 2, offset), false,
+                        "Truncated encoding accepted");
+}
+
+/**
+ * \brief Histogram files hold all histograms of a set, and reading adds
+ *        them to the histograms already there.
+ */
+class DelayHistogramSetTestCase : public TestCase
+{
+public:
+  DelayHistogramSetTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+DelayHistogramSetTestCase::DelayHistogramSetTestCase()
+    : TestCase("Check the round trip of delay histogram files")
+{
+}
+
+void DelayHistogramSetTestCase::DoRun(void)
+{
+  Ptr<DelayHistogramSet> written = Create<DelayHistogramSet>();
+  for (uint64_t i = 0; i < 3000; ++i)
+  {
+    written->Record(DelayHistogramSet::Key(1, i % 3, 5 + i % 2), 1000 + i * i);
+  }
+  std::string filename = CreateTempDirFilename("delays.ntd");
+  written->Write(filename);
+
+  Ptr<DelayHistogramSet> read = Create<DelayHistogramSet>();
+  read->Read(filename);
+  NS_TEST_ASSERT_MSG_EQ(read->GetHistograms().size(), 6, "Wrong number of histograms");
+  for (const auto &histogram : written->GetHistograms())
+  {
+    auto it = read->GetHistograms().find(histogram.first);
+    NS_TEST_ASSERT_MSG_EQ((it != read->GetHistograms().end()), true, "Histogram missing");
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> actual;
+    histogram.second.Serialize(expected);
+    it->second.Serialize(actual);
+    NS_TEST_ASSERT_MSG_EQ((actual == expected), true, "Histogram does not round trip");
+  }
+
+  read->Read(filename);
+  const DelayHistogram &twice = read->GetHistograms().begin()->second;
+  NS_TEST_ASSERT_MSG_EQ(twice.GetCount(),
+                        2 * written->GetHistograms().begin()->second.GetCount(),
+                        "Reading does not add to the histograms");
+}
+
+// Record a packet arriving at receiver 7.
+static void RecordPacket(Ptr<DelayHistogramSet> histograms, Ptr<Packet> p)
+{
+  histograms->Record(7, p);
+}
+
+/**
+ * \brief Traced frames count for the histogram of their receiver and
+ *        sender, with the time since their TimestampTag.
+ */
+class DelayHistogramPacketTestCase : public TestCase
+{
+public:
+  DelayHistogramPacketTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+DelayHistogramPacketTestCase::DelayHistogramPacketTestCase()
+    : TestCase("Check the delays of traced frames")
+{
+}
+
+void DelayHistogramPacketTestCase::DoRun(void)
+{
+  // The frames are sent at 0.
+  Ptr<DelayHistogramSet> histograms = Create<DelayHistogramSet>();
+  Simulator::Schedule(MilliSeconds(5), &RecordPacket, histograms, MakeFrame(2, 9, 6, 1001, 500));
+  Simulator::Schedule(MilliSeconds(5), &RecordPacket, histograms, Create<Packet>(100));
+  Simulator::Run();
+  Simulator::Destroy();
+  NS_TEST_ASSERT_MSG_EQ(histograms->GetHistograms().size(), 1, "Wrong histograms");
+  const auto &histogram = *histograms->GetHistograms().begin();
+  NS_TEST_ASSERT_MSG_EQ((histogram.first == DelayHistogramSet::Key(1, 2, 7)), true,
+                        "Wrong histogram key");
+  NS_TEST_ASSERT_MSG_EQ(histogram.second.GetCount(), 1, "Wrong delay count");
+  NS_TEST_ASSERT_MSG_EQ(histogram.second.GetMin(), 5000000, "Wrong delay");
+}
+
+/**
+ * \brief Tests of the delay histograms.
+ */
+class NttDelayHistogramTestSuite : public TestSuite
+{
+public:
+  NttDelayHistogramTestSuite();
+};
+
+NttDelayHistogramTestSuite::NttDelayHistogramTestSuite()
+    : TestSuite("ntt-delay-histogram", UNIT)
+{
+  AddTestCase(new DelayHistogramTestCase, TestCase::QUICK);
+  AddTestCase(new DelayHistogramSetTestCase, TestCase::QUICK);
+  AddTestCase(new DelayHistogramPacketTestCase, TestCase::QUICK);
+}
+
+static NttDelayHistogramTestSuite g_nttDelayHistogramTestSuite;
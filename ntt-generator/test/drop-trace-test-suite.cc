@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the drop records of the net devices.
+
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-sampler.h"
+#include "ns3/drop-trace.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Drops are logged with the port of the device, only for the
+ *        devices with a MacTxDrop trace and for tagged packets.
+ */
+class DropPacketTraceTestCase : public TestCase
+{
+public:
+  DropPacketTraceTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+DropPacketTraceTestCase::DropPacketTraceTestCase()
+    : TestCase("Check the drop records of every port")
+{
+}
+
+void DropPacketTraceTestCase::DoRun(void)
+{
+  Ptr<TapNetDevice> first = MakeTapNode();
+  // No MacTxDrop trace, so no port.
+  Ptr<Node> plain = CreateObject<Node>();
+  plain->AddDevice(CreateObject<SimpleNetDevice>());
+  Ptr<TapNetDevice> second = MakeTapNode();
+
+  Ptr<RecordingTraceOutput<DropPacketRecord>> output =
+      Create<RecordingTraceOutput<DropPacketRecord>>();
+  std::ostringstream ports;
+  NS_TEST_ASSERT_MSG_EQ(ConnectDropPacketTrace(output, ports), 2, "Wrong number of ports");
+  std::ostringstream expected;
+  expected << "port,node,device\n"
+           << "0," << first->GetNode()->GetId() << ",0\n"
+           << "1," << second->GetNode()->GetId() << ",0\n";
+  NS_TEST_ASSERT_MSG_EQ(ports.str(), expected.str(), "Wrong port table");
+
+  second->FireMacTxDrop(MakeFrame(2, 9, 6, 1001, 500));
+  first->FireMacTxDrop(Create<Packet>(100));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 1, "Wrong number of drop records");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].port, 1, "Wrong port");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].packet.sequence, 1001, "Wrong sequence number");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].packet.application, 2, "Wrong application");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].packet.message, 9, "Wrong message");
+  Simulator::Destroy();
+
+  // Every second drop with a sampler.
+  Ptr<TapNetDevice> sampled = MakeTapNode();
+  Ptr<RecordingTraceOutput<DropPacketRecord>> sampledOutput =
+      Create<RecordingTraceOutput<DropPacketRecord>>();
+  std::ostringstream sampledPorts;
+  NS_TEST_ASSERT_MSG_EQ(ConnectDropPacketTrace(sampledOutput, sampledPorts,
+                                               Create<TraceSampler>("every=2")),
+                        1, "Wrong number of sampled ports");
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    sampled->FireMacTxDrop(MakeFrame(2, 9, 6, 1001 + 500 * i, 500));
+  }
+  NS_TEST_ASSERT_MSG_EQ(sampledOutput->m_records.size(), 2, "Drops not sampled");
+  NS_TEST_ASSERT_MSG_EQ(sampledOutput->m_records[1].packet.sequence, 2001,
+                        "Wrong sampled drop");
+  Simulator::Destroy();
+}
+
+/**
+ * \brief Tests of the drop records.
+ */
+class NttDropTraceTestSuite : public TestSuite
+{
+public:
+  NttDropTraceTestSuite();
+};
+
+NttDropTraceTestSuite::NttDropTraceTestSuite()
+    : TestSuite("ntt-drop-trace", UNIT)
+{
+  AddTestCase(new DropPacketTraceTestCase, TestCase::QUICK);
+}
+
+static NttDropTraceTestSuite g_nttDropTraceTestSuite;
@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the per-flow window aggregates.
+
+#include <cstring>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/flow-window.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+// A packet record of 100 bytes from source.
+static PacketRecord MakeWindowRecord(uint64_t timestamp, uint32_t source, uint32_t message,
+                                     int64_t delay)
+{
+  PacketRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.timestamp = timestamp;
+  record.source = source;
+  record.size = 100;
+  record.message = message;
+  record.delay = delay;
+  record.protocol = 6;
+  return record;
+}
+
+static void WriteRecord(Ptr<TraceOutput> output, PacketRecord record)
+{
+  output->Write(&record);
+}
+
+/**
+ * \brief Flow windows slide by their step, are written once they ended
+ *        and count distinct messages.
+ */
+class FlowWindowTestCase : public TestCase
+{
+public:
+  FlowWindowTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+FlowWindowTestCase::FlowWindowTestCase()
+    : TestCase("Check the aggregation of flow windows")
+{
+}
+
+void FlowWindowTestCase::DoRun(void)
+{
+  // The windows of the records, each packet is 100 bytes.
+  struct Expected
+  {
+    uint64_t timestamp;
+    uint32_t source;
+    uint32_t packets;
+    uint32_t messages;
+    int64_t meanDelay;
+    int64_t maxDelay;
+  };
+  Expected tumbling[] = {{0, 1, 2, 2, 7, 9}, {0, 2, 1, 1, 1, 1}, {100, 1, 1, 1, 2, 2},
+                         {400, 1, 1, 1, 3, 3}};
+  Expected sliding[] = {{0, 1, 2, 2, 7, 9},   {0, 2, 1, 1, 1, 1},   {50, 1, 2, 2, 5, 9},
+                        {50, 2, 1, 1, 1, 1},  {100, 1, 1, 1, 2, 2}, {350, 1, 1, 1, 3, 3},
+                        {400, 1, 1, 1, 3, 3}};
+  PacketRecord records[] = {MakeWindowRecord(10, 1, 1, 5), MakeWindowRecord(60, 1, 2, 9),
+                            MakeWindowRecord(60, 2, 3, 1), MakeWindowRecord(130, 1, 4, 2),
+                            MakeWindowRecord(420, 1, 5, 3)};
+
+  for (uint32_t step : {100, 50})
+  {
+    Ptr<RecordingTraceOutput<FlowWindowRecord>> output =
+        Create<RecordingTraceOutput<FlowWindowRecord>>();
+    Ptr<TraceOutput> windows =
+        Create<FlowWindowTraceOutput>(output, NanoSeconds(100), NanoSeconds(step));
+    for (const PacketRecord &record : records)
+    {
+      Simulator::Schedule(NanoSeconds(record.timestamp), &WriteRecord, windows, record);
+    }
+    Simulator::Run();
+    const Expected *expected = step == 100 ? tumbling : sliding;
+    uint32_t count = step == 100 ? 4 : 7;
+    // The last windows are written at their end, before Close().
+    NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), count, "Ended windows not written");
+    windows->Close();
+    Simulator::Destroy();
+    NS_TEST_ASSERT_MSG_EQ(output->m_closed, 1, "Output not closed");
+    NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), count, "Wrong number of windows");
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      const FlowWindowRecord &record = output->m_records[i];
+      NS_TEST_ASSERT_MSG_EQ(record.timestamp, expected[i].timestamp, "Wrong window " << i);
+      NS_TEST_ASSERT_MSG_EQ(record.source, expected[i].source, "Wrong flow " << i);
+      NS_TEST_ASSERT_MSG_EQ(record.packets, expected[i].packets, "Wrong packets " << i);
+      NS_TEST_ASSERT_MSG_EQ(record.bytes, 100 * expected[i].packets, "Wrong bytes " << i);
+      NS_TEST_ASSERT_MSG_EQ(record.messages, expected[i].messages, "Wrong messages " << i);
+      NS_TEST_ASSERT_MSG_EQ(record.meanDelay, expected[i].meanDelay, "Wrong mean " << i);
+      NS_TEST_ASSERT_MSG_EQ(record.maxDelay, expected[i].maxDelay, "Wrong maximum " << i);
+    }
+  }
+
+  // Beyond EXACT_MESSAGES, distinct messages are estimated.
+  Ptr<RecordingTraceOutput<FlowWindowRecord>> output =
+      Create<RecordingTraceOutput<FlowWindowRecord>>();
+  Ptr<TraceOutput> windows = Create<FlowWindowTraceOutput>(output, NanoSeconds(1000));
+  for (uint32_t i = 0; i < 400; ++i)
+  {
+    PacketRecord record = MakeWindowRecord(i, 1, i / 4, 0);
+    windows->Write(&record);
+  }
+  windows->Close();
+  Simulator::Destroy();
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 1, "Wrong number of windows");
+  NS_TEST_ASSERT_MSG_EQ_TOL(double(output->m_records[0].messages), 100, 15,
+                            "Distinct messages badly estimated");
+}
+
+/**
+ * \brief Tests of the flow windows.
+ */
+class NttFlowWindowTestSuite : public TestSuite
+{
+public:
+  NttFlowWindowTestSuite();
+};
+
+NttFlowWindowTestSuite::NttFlowWindowTestSuite()
+    : TestSuite("ntt-flow-window", UNIT)
+{
+  AddTestCase(new FlowWindowTestCase, TestCase::QUICK);
+}
+
+static NttFlowWindowTestSuite g_nttFlowWindowTestSuite;
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the memory-mapped trace files.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/mapped-trace.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Mapped trace files hold the committed records also before the
+ *        output is closed.
+ */
+class MappedTraceTestCase : public TestCase
+{
+public:
+  MappedTraceTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+MappedTraceTestCase::MappedTraceTestCase()
+    : TestCase("Check the round trip of mapped trace files")
+{
+}
+
+void MappedTraceTestCase::DoRun(void)
+{
+  std::string filename = CreateTempDirFilename("packets.ntm");
+  // Small steps, so that the file grows several times.
+  Ptr<TraceOutput> output = Create<MappedTraceOutput>(filename, Create<PacketRecordFormat>(),
+                                                      4096);
+  std::vector<PacketRecord> records;
+  for (uint32_t i = 0; i < TEST_RECORDS; ++i)
+  {
+    records.push_back(MakeTestRecord(i));
+    output->Write(&records.back());
+  }
+
+  {
+    // As after a run that was killed.
+    MappedTraceReader reader(filename);
+    NS_TEST_ASSERT_MSG_EQ(reader.IsClosed(), false, "Open output read as closed");
+    NS_TEST_ASSERT_MSG_EQ(reader.GetNRecords(), TEST_RECORDS, "Committed records missing");
+    NS_TEST_ASSERT_MSG_EQ(std::memcmp(reader.GetRecord(TEST_RECORDS - 1), &records.back(),
+                                      sizeof(PacketRecord)),
+                          0, "Last record does not round trip");
+  }
+
+  output->Close();
+  MappedTraceReader reader(filename);
+  NS_TEST_ASSERT_MSG_EQ(reader.GetFormat()->GetName(), "packet", "Wrong format");
+  NS_TEST_ASSERT_MSG_EQ(reader.IsClosed(), true, "Closed output read as open");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetNRecords(), TEST_RECORDS, "Wrong number of records");
+  bool equal = true;
+  for (uint32_t i = 0; i < TEST_RECORDS; ++i)
+  {
+    equal = equal && std::memcmp(reader.GetRecord(i), &records[i], sizeof(PacketRecord)) == 0;
+  }
+  NS_TEST_ASSERT_MSG_EQ(equal, true, "Records do not round trip");
+}
+
+/**
+ * \brief Tests of the memory-mapped trace files.
+ */
+class NttMappedTraceTestSuite : public TestSuite
+{
+public:
+  NttMappedTraceTestSuite();
+};
+
+NttMappedTraceTestSuite::NttMappedTraceTestSuite()
+    : TestSuite("ntt-mapped-trace", UNIT)
+{
+  AddTestCase(new MappedTraceTestCase, TestCase::QUICK);
+}
+
+static NttMappedTraceTestSuite g_nttMappedTraceTestSuite;
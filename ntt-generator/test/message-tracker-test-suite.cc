@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the completion of the messages of the applications.
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/experiment-tags.h"
+#include "ns3/trace-record.h"
+#include "ns3/message-tracker.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+// A message as traced at the CdfApplication TxMessage source.
+static Ptr<Packet> MakeMessage(uint32_t application, uint32_t message, uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet>(size);
+  IdTag idTag;
+  idTag.SetWorkload(1);
+  idTag.SetApplication(application);
+  p->AddPacketTag(idTag);
+  MessageTag messageTag;
+  messageTag.SetSimpleValue(message);
+  p->AddPacketTag(messageTag);
+  return p;
+}
+
+// The socket address of an application, as MakeFrame uses it.
+static Address Local(uint32_t application, Ipv4Address source = Ipv4Address("10.0.0.1"))
+{
+  return InetSocketAddress(source, 1000 + application);
+}
+
+// The address the applications send to.
+static Address Peer(void)
+{
+  return InetSocketAddress(Ipv4Address("10.0.0.2"), 80);
+}
+
+/**
+ * \brief Messages complete once all their bytes arrived, whatever the
+ *        order and retransmissions of the segments carrying them.
+ */
+class MessageTrackerTestCase : public TestCase
+{
+public:
+  MessageTrackerTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+MessageTrackerTestCase::MessageTrackerTestCase()
+    : TestCase("Check the completion of messages")
+{
+}
+
+void MessageTrackerTestCase::DoRun(void)
+{
+  Ptr<RecordingTraceOutput<MessageRecord>> output =
+      Create<RecordingTraceOutput<MessageRecord>>();
+  Ptr<MessageTracker> tracker = Create<MessageTracker>(output);
+
+  // Two messages in the byte stream of a TCP flow; the segments carry the
+  // tags of the first message and arrive out of order.
+  tracker->Started(MakeMessage(1, 0, 1000), Local(1), Peer());
+  tracker->Started(MakeMessage(1, 1, 500), Local(1), Peer());
+  tracker->Received(MakeFrame(1, 0, 6, 1001, 500));
+  tracker->Received(MakeFrame(1, 0, 6, 1, 600));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 0, "Message completed with a gap");
+  tracker->Received(MakeFrame(1, 0, 6, 1, 600));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 0, "Retransmission completed a message");
+  tracker->Received(MakeFrame(1, 0, 6, 601, 400));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 2, "Contiguous messages not completed");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].message, 0, "Wrong first message");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].size, 1000, "Wrong first message size");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].packets, 2, "Retransmission counted");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[1].message, 1, "Wrong second message");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[1].size, 500, "Wrong second message size");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[1].packets, 1, "Wrong second message packets");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[1].application, 1, "Wrong application");
+
+  // Datagrams count for the message of their tags.
+  tracker->Started(MakeMessage(2, 5, 300), Local(2), Peer());
+  tracker->Started(MakeMessage(2, 6, 300), Local(2), Peer());
+  tracker->Received(MakeFrame(2, 5, 17, 0, 200));
+  tracker->Received(MakeFrame(2, 5, 17, 0, 100));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 3, "Datagram message not completed");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[2].message, 5, "Wrong datagram message");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[2].packets, 2, "Wrong datagram count");
+
+  tracker->Close();
+  NS_TEST_ASSERT_MSG_EQ(tracker->GetCompleted(), 3, "Wrong number of completed messages");
+  NS_TEST_ASSERT_MSG_EQ(tracker->GetIncomplete(), 1, "Wrong number of incomplete messages");
+  NS_TEST_ASSERT_MSG_EQ(output->m_closed, 0, "Tracker closed its output");
+}
+
+/**
+ * \brief Connections that share an IdTag are tracked apart, and the IP
+ *        fragments of a datagram count for the message of its first
+ *        fragment.
+ */
+class MessageTrackerConnectionTestCase : public TestCase
+{
+public:
+  MessageTrackerConnectionTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+MessageTrackerConnectionTestCase::MessageTrackerConnectionTestCase()
+    : TestCase("Check the messages of connections with the same IdTag")
+{
+}
+
+void MessageTrackerConnectionTestCase::DoRun(void)
+{
+  Ptr<RecordingTraceOutput<MessageRecord>> output =
+      Create<RecordingTraceOutput<MessageRecord>>();
+  Ptr<MessageTracker> tracker = Create<MessageTracker>(output);
+
+  // Two senders with the same IdTag and ports, each with its own byte
+  // stream and message ids.
+  Ipv4Address other("10.0.0.3");
+  tracker->Started(MakeMessage(1, 0, 1000), Local(1), Peer());
+  tracker->Started(MakeMessage(1, 0, 400), Local(1, other), Peer());
+  tracker->Received(MakeFrame(1, 0, 6, 1, 400, other));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 1, "Message of the second sender missed");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[0].size, 400, "Messages of the senders merged");
+  tracker->Received(MakeFrame(1, 0, 6, 1, 600));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 1, "Bytes of the senders merged");
+  tracker->Received(MakeFrame(1, 0, 6, 601, 400));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 2, "Message of the first sender missed");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[1].size, 1000, "Wrong message of the first sender");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[1].packets, 2, "Wrong packets of the first sender");
+
+  // A datagram of three fragments; only the first has the UDP header.
+  tracker->Started(MakeMessage(2, 5, 3000), Local(2), Peer());
+  tracker->Received(MakeFragment(2, 5, 99, 1480, 1480));
+  tracker->Received(MakeFrame(2, 5, 17, 7, 1472));
+  tracker->Received(MakeFragment(2, 5, 7, 1480, 1480));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 2, "Datagram completed early");
+  tracker->Received(MakeFragment(2, 5, 7, 2960, 48));
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 3, "Fragmented datagram not completed");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[2].message, 5, "Wrong datagram message");
+  NS_TEST_ASSERT_MSG_EQ(output->m_records[2].packets, 3, "Wrong fragment count");
+
+  tracker->Close();
+  NS_TEST_ASSERT_MSG_EQ(tracker->GetIncomplete(), 0, "Wrong number of incomplete messages");
+}
+
+/**
+ * \brief Tests of the message tracker.
+ */
+class NttMessageTrackerTestSuite : public TestSuite
+{
+public:
+  NttMessageTrackerTestSuite();
+};
+
+NttMessageTrackerTestSuite::NttMessageTrackerTestSuite()
+    : TestSuite("ntt-message-tracker", UNIT)
+{
+  AddTestCase(new MessageTrackerTestCase, TestCase::QUICK);
+  AddTestCase(new MessageTrackerConnectionTestCase, TestCase::QUICK);
+}
+
+static NttMessageTrackerTestSuite g_nttMessageTrackerTestSuite;
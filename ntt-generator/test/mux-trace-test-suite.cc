@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the multiplexed trace files and the taps written into them.
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/names.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/mux-trace.h"
+#include "ns3/trace-registry.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Multiplexed trace files return the records of every stream in
+ *        the order they were written, with the stream declarations.
+ */
+class MuxTraceTestCase : public TestCase
+{
+public:
+  MuxTraceTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+MuxTraceTestCase::MuxTraceTestCase()
+    : TestCase("Check the round trip of multiplexed trace files")
+{
+}
+
+void MuxTraceTestCase::DoRun(void)
+{
+  std::string filename = CreateTempDirFilename("trace.ntx");
+  // A small buffer, so that it is written out several times.
+  Ptr<MuxTraceOutput> mux = Create<MuxTraceOutput>(filename, 4096);
+  Ptr<TraceOutput> packets = mux->AddStream("packets", Create<PacketRecordFormat>());
+  Ptr<TraceOutput> queues = mux->AddStream("queues", Create<QueueRecordFormat>());
+  NS_TEST_ASSERT_MSG_EQ(mux->GetNStreams(), 2, "Wrong number of streams");
+
+  for (uint32_t i = 0; i < TEST_RECORDS; ++i)
+  {
+    PacketRecord packet = MakeTestRecord(i);
+    packets->Write(&packet);
+    if (i % 3 == 0)
+    {
+      QueueRecord queue = {packet.timestamp, 1, 2, i};
+      queues->Write(&queue);
+    }
+  }
+  packets->Close();
+  queues->Close();
+  mux->Close();
+
+  MuxTraceReader reader(filename);
+  uint16_t stream;
+  uint32_t packetCount = 0;
+  uint32_t queueCount = 0;
+  bool ordered = true;
+  while (reader.Next(stream))
+  {
+    if (stream == 0)
+    {
+      PacketRecord expected = MakeTestRecord(packetCount++);
+      ordered = ordered && std::memcmp(reader.GetRecord(), &expected, sizeof(expected)) == 0;
+    }
+    else
+    {
+      QueueRecord queue;
+      std::memcpy(&queue, reader.GetRecord(), sizeof(queue));
+      ordered = ordered && queue.value == 3 * queueCount && queue.value + 1 == packetCount;
+      ++queueCount;
+    }
+  }
+  NS_TEST_ASSERT_MSG_EQ(reader.GetNStreams(), 2, "Wrong number of streams");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetName(0), "packets", "Wrong stream name");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetName(1), "queues", "Wrong stream name");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetFormat(1)->GetName(), "queue", "Wrong stream format");
+  NS_TEST_ASSERT_MSG_EQ(packetCount, TEST_RECORDS, "Wrong number of packet records");
+  NS_TEST_ASSERT_MSG_EQ(queueCount, (TEST_RECORDS + 2) / 3, "Wrong number of queue records");
+  NS_TEST_ASSERT_MSG_EQ(ordered, true, "Records do not round trip in order");
+}
+
+/**
+ * \brief The registry connects a tap of every line of its config file to
+ *        each matched device, with the stream names of the device.
+ */
+class TraceRegistryTestCase : public TestCase
+{
+public:
+  TraceRegistryTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+TraceRegistryTestCase::TraceRegistryTestCase()
+    : TestCase("Check the taps of the trace registry config")
+{
+}
+
+void TraceRegistryTestCase::DoRun(void)
+{
+  Ptr<TapNetDevice> sender = MakeTapNode();
+  Ptr<TapNetDevice> receiver = MakeTapNode();
+  Names::Add("tapReceiver", receiver->GetNode());
+  uint32_t senderId = sender->GetNode()->GetId();
+  uint32_t receiverId = receiver->GetNode()->GetId();
+
+  std::string config = CreateTempDirFilename("taps.conf");
+  {
+    std::ofstream file(config.c_str());
+    file << "# Taps of both nodes\n"
+         << "\n"
+         << "/NodeList/[" << senderId << "-" << receiverId << "]/DeviceList/0 MacTx "
+         << "tx-{node}-{port}\n"
+         << "  /Names/tapReceiver/DeviceList/0   MacRx   rx-{device}  # received\n"
+         << "/Names/tapReceiver/DeviceList/0 drop drops\n"
+         << "/Names/tapReceiver/DeviceList/0 queue queue\n";
+  }
+  std::string filename = CreateTempDirFilename("taps.ntx");
+  Ptr<MuxTraceOutput> mux = Create<MuxTraceOutput>(filename);
+  Ptr<TraceRegistry> registry = Create<TraceRegistry>(mux);
+  registry->Load(config);
+  NS_TEST_ASSERT_MSG_EQ(registry->GetNTaps(), 5, "Wrong number of taps");
+  NS_TEST_ASSERT_MSG_EQ(mux->GetNStreams(), 5, "Wrong number of streams");
+
+  sender->FireMacTx(MakeFrame(2, 9, 6, 1001, 500));
+  sender->FireMacTx(Create<Packet>(100));
+  receiver->FireMacRx(MakeFrame(2, 9, 6, 1001, 500));
+  receiver->FireMacTxDrop(MakeFrame(2, 10, 6, 1501, 500));
+  receiver->GetQueue()->Enqueue(Create<Packet>(100));
+  mux->Close();
+
+  MuxTraceReader reader(filename);
+  std::vector<uint32_t> counts;
+  DropRecord drop;
+  std::memset(&drop, 0, sizeof(drop));
+  uint16_t stream;
+  while (reader.Next(stream))
+  {
+    counts.resize(reader.GetNStreams());
+    ++counts[stream];
+    if (stream == 3)
+    {
+      std::memcpy(&drop, reader.GetRecord(), sizeof(drop));
+    }
+  }
+  std::ostringstream tx;
+  tx << "tx-" << senderId << "-1";
+  NS_TEST_ASSERT_MSG_EQ(reader.GetNStreams(), 5, "Wrong number of streams read");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetName(0), tx.str(), "Wrong sender stream name");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetName(2), "rx-0", "Wrong receiver stream name");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetFormat(3)->GetName(), "drop-sequence",
+                        "Wrong drop stream format");
+  NS_TEST_ASSERT_MSG_EQ(reader.GetFormat(4)->GetName(), "queue", "Wrong queue stream format");
+  counts.resize(5);
+  NS_TEST_ASSERT_MSG_EQ(counts[0], 1, "Untagged packet traced");
+  NS_TEST_ASSERT_MSG_EQ(counts[1], 0, "Packet of the receiver traced as sent");
+  NS_TEST_ASSERT_MSG_EQ(counts[2], 1, "Received packet not traced");
+  NS_TEST_ASSERT_MSG_EQ(counts[3], 1, "Drop not traced");
+  NS_TEST_ASSERT_MSG_EQ(drop.node, receiverId, "Wrong node of the drop");
+  NS_TEST_ASSERT_MSG_EQ(drop.sequence, 1501, "Wrong sequence number of the drop");
+  NS_TEST_ASSERT_MSG_EQ(counts[4], 1, "Queue change not traced");
+  Simulator::Destroy();
+}
+
+/**
+ * \brief Tests of the multiplexed trace files and the trace registry.
+ */
+class NttMuxTraceTestSuite : public TestSuite
+{
+public:
+  NttMuxTraceTestSuite();
+};
+
+NttMuxTraceTestSuite::NttMuxTraceTestSuite()
+    : TestSuite("ntt-mux-trace", UNIT)
+{
+  AddTestCase(new MuxTraceTestCase, TestCase::QUICK);
+  AddTestCase(new TraceRegistryTestCase, TestCase::QUICK);
+}
+
+static NttMuxTraceTestSuite g_nttMuxTraceTestSuite;
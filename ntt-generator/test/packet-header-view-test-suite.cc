@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the header fields read from traced frames.
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/tcp-header.h"
+#include "ns3/packet-header-view.h"
+#include "ns3/trace-record.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief The view reads the header fields at their wire offsets, without
+ *        changing the packet, and reads missing layers as zero.
+ */
+class PacketHeaderViewTestCase : public TestCase
+{
+public:
+  PacketHeaderViewTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+PacketHeaderViewTestCase::PacketHeaderViewTestCase()
+    : TestCase("Check the fields of the packet header view")
+{
+}
+
+void PacketHeaderViewTestCase::DoRun(void)
+{
+  Ptr<Packet> tcp = MakeFrame(2, 9, 6, 1001, 500);
+  uint32_t size = tcp->GetSize();
+  PacketHeaderView view(tcp);
+  NS_TEST_ASSERT_MSG_EQ(tcp->GetSize(), size, "Packet changed");
+  NS_TEST_ASSERT_MSG_EQ(view.IsIpv4(), true, "IPv4 not found");
+  NS_TEST_ASSERT_MSG_EQ(view.IsTcp(), true, "TCP not found");
+  NS_TEST_ASSERT_MSG_EQ(view.IsUdp(), false, "TCP read as UDP");
+  NS_TEST_ASSERT_MSG_EQ(view.GetSource(), Ipv4Address("10.0.0.1"), "Wrong source");
+  NS_TEST_ASSERT_MSG_EQ(view.GetDestination(), Ipv4Address("10.0.0.2"), "Wrong destination");
+  NS_TEST_ASSERT_MSG_EQ(view.GetIdentification(), 1001, "Wrong identification");
+  NS_TEST_ASSERT_MSG_EQ(uint32_t(view.GetTtl()), 64, "Wrong TTL");
+  NS_TEST_ASSERT_MSG_EQ(uint32_t(view.GetProtocol()), 6, "Wrong protocol");
+  NS_TEST_ASSERT_MSG_EQ(view.GetPayloadSize(), 520, "Wrong payload size");
+  NS_TEST_ASSERT_MSG_EQ(view.GetDataSize(), 500, "Wrong data size");
+  NS_TEST_ASSERT_MSG_EQ(view.GetSourcePort(), 1002, "Wrong source port");
+  NS_TEST_ASSERT_MSG_EQ(view.GetDestinationPort(), 80, "Wrong destination port");
+  NS_TEST_ASSERT_MSG_EQ(view.GetSequenceNumber(), 1001, "Wrong sequence number");
+  NS_TEST_ASSERT_MSG_EQ(view.GetAckNumber(), 1, "Wrong ack number");
+  NS_TEST_ASSERT_MSG_EQ(uint32_t(view.GetFlags()), uint32_t(TcpHeader::ACK), "Wrong flags");
+  NS_TEST_ASSERT_MSG_EQ(view.GetWindowSize(), 4000, "Wrong window");
+
+  PacketHeaderView udp(MakeFrame(2, 9, 17, 7, 300));
+  NS_TEST_ASSERT_MSG_EQ(udp.IsUdp(), true, "UDP not found");
+  NS_TEST_ASSERT_MSG_EQ(udp.GetDataSize(), 300, "Wrong datagram size");
+  NS_TEST_ASSERT_MSG_EQ(udp.GetSourcePort(), 1002, "Wrong datagram source port");
+  NS_TEST_ASSERT_MSG_EQ(udp.GetSequenceNumber(), 0, "Sequence number of a datagram");
+
+  // A non-first fragment has no transport header.
+  PacketHeaderView fragment(MakeFragment(2, 9, 7, 1480, 300));
+  NS_TEST_ASSERT_MSG_EQ(fragment.IsIpv4(), true, "IPv4 of a fragment not found");
+  NS_TEST_ASSERT_MSG_EQ(fragment.IsUdp(), false, "Fragment read as UDP");
+  NS_TEST_ASSERT_MSG_EQ(fragment.GetSourcePort(), 0, "Port of a fragment");
+  NS_TEST_ASSERT_MSG_EQ(fragment.GetDataSize(), 300, "Wrong fragment size");
+
+  PacketHeaderView empty(Create<Packet>(100));
+  NS_TEST_ASSERT_MSG_EQ(empty.IsIpv4(), false, "IPv4 found in random bytes");
+  NS_TEST_ASSERT_MSG_EQ(empty.GetPayloadSize(), 0, "Payload of a packet without IPv4");
+  NS_TEST_ASSERT_MSG_EQ(empty.GetSourcePort(), 0, "Port of a packet without IPv4");
+}
+
+/**
+ * \brief Packet records get the header fields and tags of traced frames,
+ *        and only tagged frames are recorded.
+ */
+class PacketRecordTestCase : public TestCase
+{
+public:
+  PacketRecordTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+PacketRecordTestCase::PacketRecordTestCase()
+    : TestCase("Check the records made from traced frames")
+{
+}
+
+void PacketRecordTestCase::DoRun(void)
+{
+  PacketRecord record;
+  Ptr<Packet> tcp = MakeFrame(2, 9, 6, 1001, 500);
+  NS_TEST_ASSERT_MSG_EQ(MakePacketRecord(tcp, record), true, "Tagged frame skipped");
+  NS_TEST_ASSERT_MSG_EQ(record.size, tcp->GetSize(), "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ(record.protocol, 6, "Wrong protocol");
+  NS_TEST_ASSERT_MSG_EQ(record.source, Ipv4Address("10.0.0.1").Get(), "Wrong source");
+  NS_TEST_ASSERT_MSG_EQ(record.destination, Ipv4Address("10.0.0.2").Get(), "Wrong destination");
+  NS_TEST_ASSERT_MSG_EQ(record.sourcePort, 1002, "Wrong source port");
+  NS_TEST_ASSERT_MSG_EQ(record.destinationPort, 80, "Wrong destination port");
+  NS_TEST_ASSERT_MSG_EQ(record.sequence, 1001, "Wrong sequence number");
+  NS_TEST_ASSERT_MSG_EQ(record.window, 4000, "Wrong window");
+  NS_TEST_ASSERT_MSG_EQ(record.payloadSize, 520, "Wrong payload size");
+  NS_TEST_ASSERT_MSG_EQ(record.ttl, 64, "Wrong TTL");
+  NS_TEST_ASSERT_MSG_EQ(record.workload, 1, "Wrong workload");
+  NS_TEST_ASSERT_MSG_EQ(record.application, 2, "Wrong application");
+  NS_TEST_ASSERT_MSG_EQ(record.message, 9, "Wrong message");
+
+  Ptr<Packet> fragment = MakeFragment(2, 9, 7, 1480, 300);
+  NS_TEST_ASSERT_MSG_EQ(MakePacketRecord(fragment, record), true, "Tagged fragment skipped");
+  NS_TEST_ASSERT_MSG_EQ(record.protocol, 17, "Wrong fragment protocol");
+  NS_TEST_ASSERT_MSG_EQ(record.sourcePort, 0, "Port of a fragment");
+  NS_TEST_ASSERT_MSG_EQ(record.payloadSize, 300, "Wrong fragment payload size");
+
+  Ptr<Packet> untagged = Create<Packet>(100);
+  NS_TEST_ASSERT_MSG_EQ(MakePacketRecord(untagged, record), false, "Untagged packet recorded");
+}
+
+/**
+ * \brief Tests of the packet header view and the packet records.
+ */
+class NttPacketHeaderViewTestSuite : public TestSuite
+{
+public:
+  NttPacketHeaderViewTestSuite();
+};
+
+NttPacketHeaderViewTestSuite::NttPacketHeaderViewTestSuite()
+    : TestSuite("ntt-packet-header-view", UNIT)
+{
+  AddTestCase(new PacketHeaderViewTestCase, TestCase::QUICK);
+  AddTestCase(new PacketRecordTestCase, TestCase::QUICK);
+}
+
+static NttPacketHeaderViewTestSuite g_nttPacketHeaderViewTestSuite;
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the join of the sent and the received packets.
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/trace-record.h"
+#include "ns3/packet-join.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Received packets are joined with the sender and the time they
+ *        were sent, dropped ones are written as they are dropped, and the
+ *        rest is counted as in flight at Close().
+ */
+class PacketJoinTestCase : public TestCase
+{
+public:
+  PacketJoinTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+PacketJoinTestCase::PacketJoinTestCase()
+    : TestCase("Check the join of sent and received packets")
+{
+}
+
+void PacketJoinTestCase::DoRun(void)
+{
+  Ptr<RecordingTraceOutput<JoinedPacketRecord>> joined =
+      Create<RecordingTraceOutput<JoinedPacketRecord>>();
+  Ptr<RecordingTraceOutput<SenderRecord>> dropped =
+      Create<RecordingTraceOutput<SenderRecord>>();
+  Ptr<PacketJoin> join = Create<PacketJoin>(joined, dropped);
+
+  Ptr<Packet> received = MakeFrame(2, 9, 6, 1001, 500);
+  Ptr<Packet> lost = MakeFrame(2, 9, 6, 1501, 500);
+  Ptr<Packet> other = MakeFrame(1, 4, 6, 1, 100);
+  Ptr<Packet> inFlight = MakeFrame(1, 4, 6, 101, 100);
+  Simulator::Schedule(MicroSeconds(10), &PacketJoin::Sent, join, 3, received);
+  Simulator::Schedule(MicroSeconds(20), &PacketJoin::Sent, join, 3, lost);
+  Simulator::Schedule(MicroSeconds(30), &PacketJoin::Sent, join, 4, other);
+  Simulator::Schedule(MicroSeconds(35), &PacketJoin::Sent, join, 4, inFlight);
+  Simulator::Schedule(MicroSeconds(40), &PacketJoin::Dropped, join, other);
+  Simulator::Schedule(MicroSeconds(45), &PacketJoin::Dropped, join, lost);
+  Simulator::Schedule(MicroSeconds(50), &PacketJoin::Received, join, received);
+  Simulator::Schedule(MicroSeconds(60), &PacketJoin::Received, join, Create<Packet>(100));
+  Simulator::Run();
+  Simulator::Destroy();
+
+  NS_TEST_ASSERT_MSG_EQ(join->GetJoined(), 1, "Wrong number of joined packets");
+  NS_TEST_ASSERT_MSG_EQ(join->GetUnknown(), 1, "Wrong number of unknown packets");
+  NS_TEST_ASSERT_MSG_EQ(joined->m_records.size(), 1, "Wrong joined records");
+  const JoinedPacketRecord &record = joined->m_records[0];
+  NS_TEST_ASSERT_MSG_EQ(record.sender, 3, "Wrong sender");
+  NS_TEST_ASSERT_MSG_EQ(record.sentTimestamp, 10000, "Wrong send time");
+  NS_TEST_ASSERT_MSG_EQ(record.packet.timestamp, 50000, "Wrong receive time");
+  NS_TEST_ASSERT_MSG_EQ(record.packet.sequence, 1001, "Wrong packet");
+
+  // Received again, the packet is no longer known.
+  join->Received(received);
+  NS_TEST_ASSERT_MSG_EQ(join->GetUnknown(), 2, "Packet joined twice");
+
+  // Drops of packets that were not sent are ignored.
+  join->Dropped(Create<Packet>(100));
+  join->Dropped(received);
+  NS_TEST_ASSERT_MSG_EQ(join->GetDropped(), 2, "Wrong number of dropped packets");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records.size(), 2, "Wrong dropped records");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records[0].uid, other->GetUid(), "Wrong first drop");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records[0].node, 4, "Wrong sender of a drop");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records[0].timestamp, 30000, "Wrong send time of a drop");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records[1].uid, lost->GetUid(), "Wrong second drop");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records[1].node, 3, "Wrong sender of a drop");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records[1].sequence, 1501, "Wrong sequence of a drop");
+
+  // The packet still in flight is only counted.
+  join->Close();
+  NS_TEST_ASSERT_MSG_EQ(join->GetInFlight(), 1, "Wrong number of packets in flight");
+  NS_TEST_ASSERT_MSG_EQ(dropped->m_records.size(), 2, "Packet in flight written as dropped");
+  NS_TEST_ASSERT_MSG_EQ(join->GetDropped(), 2, "Packet in flight counted as dropped");
+  NS_TEST_ASSERT_MSG_EQ(joined->m_closed + dropped->m_closed, 0, "Outputs closed");
+}
+
+/**
+ * \brief Tests of the packet join.
+ */
+class NttPacketJoinTestSuite : public TestSuite
+{
+public:
+  NttPacketJoinTestSuite();
+};
+
+NttPacketJoinTestSuite::NttPacketJoinTestSuite()
+    : TestSuite("ntt-packet-join", UNIT)
+{
+  AddTestCase(new PacketJoinTestCase, TestCase::QUICK);
+}
+
+static NttPacketJoinTestSuite g_nttPacketJoinTestSuite;
@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Round trips of the queue change traces, decoded by hand.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/queue-change-trace.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/// A change decoded from a queue change trace.
+struct QueueChange
+{
+  uint64_t timestamp; //!< Time of the change
+  uint32_t node;      //!< Node id of the device
+  uint32_t device;    //!< Device index on the node
+  uint32_t value;     //!< Packets in the queue after the change
+
+  bool operator==(const QueueChange &other) const
+  {
+    return timestamp == other.timestamp && node == other.node && device == other.device &&
+           value == other.value;
+  }
+};
+
+// Decode a LEB128 varint at offset and advance offset past it.
+static bool ReadVarint(const std::vector<uint8_t> &data, size_t &offset, uint64_t &value)
+{
+  value = 0;
+  for (uint32_t shift = 0; offset < data.size() && shift < 64; shift += 7)
+  {
+    uint8_t byte = data[offset++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Decode a file written by QueueChangeTraceOutput, see the layout in
+// queue-change-trace.h.
+static bool ReadQueueChanges(std::string filename, uint64_t &window,
+                             std::vector<QueueChange> &changes)
+{
+  std::vector<uint8_t> data = ReadFile(filename);
+  if (data.size() < sizeof(TraceFileHeader) + sizeof(window) ||
+      std::memcmp(data.data(), "NTTQ", 4) != 0)
+  {
+    return false;
+  }
+  std::memcpy(&window, &data[sizeof(TraceFileHeader)], sizeof(window));
+  size_t offset = sizeof(TraceFileHeader) + sizeof(window);
+
+  std::vector<QueueChange> ports;
+  uint64_t tick = 0;
+  uint64_t entry, a, b;
+  while (offset < data.size())
+  {
+    if (!ReadVarint(data, offset, entry) || !ReadVarint(data, offset, a) ||
+        !ReadVarint(data, offset, b))
+    {
+      return false;
+    }
+    if (entry == 0)
+    {
+      ports.push_back(QueueChange{0, static_cast<uint32_t>(a), static_cast<uint32_t>(b), 0});
+      continue;
+    }
+    tick += a;
+    for (uint64_t i = 0; i < b; ++i)
+    {
+      uint64_t port, zigzag;
+      if (!ReadVarint(data, offset, port) || !ReadVarint(data, offset, zigzag) ||
+          port >= ports.size())
+      {
+        return false;
+      }
+      ports[port].value += static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+      ports[port].timestamp = window == 0 ? tick : tick * window;
+      changes.push_back(ports[port]);
+    }
+  }
+  return true;
+}
+
+/**
+ * \brief Queue change traces decode to the changes of every port,
+ *        coalesced per window if there is one.
+ */
+class QueueChangeTraceTestCase : public TestCase
+{
+public:
+  QueueChangeTraceTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+QueueChangeTraceTestCase::QueueChangeTraceTestCase()
+    : TestCase("Check the round trip of queue change traces")
+{
+}
+
+void QueueChangeTraceTestCase::DoRun(void)
+{
+  // Without a window, every change is written, also two at the same time,
+  // but not the ones that do not change the occupancy.
+  std::string filename = CreateTempDirFilename("queues.ntq");
+  Ptr<TraceOutput> output = Create<QueueChangeTraceOutput>(filename);
+  QueueRecord changes[] = {
+      {10, 1, 0, 1}, {10, 1, 0, 2}, {20, 2, 1, 5}, {30, 1, 0, 2}, {40, 1, 0, 0}};
+  for (const QueueRecord &change : changes)
+  {
+    output->Write(&change);
+  }
+  output->Close();
+
+  uint64_t window;
+  std::vector<QueueChange> read;
+  NS_TEST_ASSERT_MSG_EQ(ReadQueueChanges(filename, window, read), true, "File not decoded");
+  NS_TEST_ASSERT_MSG_EQ(window, 0, "Wrong window");
+  QueueChange expected[] = {{10, 1, 0, 1}, {10, 1, 0, 2}, {20, 2, 1, 5}, {40, 1, 0, 0}};
+  NS_TEST_ASSERT_MSG_EQ(read.size(), 4, "Wrong number of changes");
+  for (uint32_t i = 0; i < read.size(); ++i)
+  {
+    NS_TEST_ASSERT_MSG_EQ((read[i] == expected[i]), true, "Wrong change " << i);
+  }
+
+  // A window keeps the last value of a port in every window; port 1 is
+  // back at zero at the end of the first window.
+  filename = CreateTempDirFilename("queues-window.ntq");
+  output = Create<QueueChangeTraceOutput>(filename, NanoSeconds(100));
+  QueueRecord windowed[] = {{10, 1, 0, 1},  {50, 1, 0, 2},  {60, 2, 1, 3},
+                            {90, 2, 1, 0},  {150, 1, 0, 0}, {420, 1, 0, 4}};
+  for (const QueueRecord &change : windowed)
+  {
+    output->Write(&change);
+  }
+  output->Close();
+
+  read.clear();
+  NS_TEST_ASSERT_MSG_EQ(ReadQueueChanges(filename, window, read), true, "File not decoded");
+  NS_TEST_ASSERT_MSG_EQ(window, 100, "Wrong window");
+  QueueChange coalesced[] = {{0, 1, 0, 2}, {100, 1, 0, 0}, {400, 1, 0, 4}};
+  NS_TEST_ASSERT_MSG_EQ(read.size(), 3, "Wrong number of coalesced changes");
+  for (uint32_t i = 0; i < read.size(); ++i)
+  {
+    NS_TEST_ASSERT_MSG_EQ((read[i] == coalesced[i]), true, "Wrong coalesced change " << i);
+  }
+}
+
+/**
+ * \brief Tests of the queue change traces.
+ */
+class NttQueueChangeTraceTestSuite : public TestSuite
+{
+public:
+  NttQueueChangeTraceTestSuite();
+};
+
+NttQueueChangeTraceTestSuite::NttQueueChangeTraceTestSuite()
+    : TestSuite("ntt-queue-change-trace", UNIT)
+{
+  AddTestCase(new QueueChangeTraceTestCase, TestCase::QUICK);
+}
+
+static NttQueueChangeTraceTestSuite g_nttQueueChangeTraceTestSuite;
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the npy files and of the queue sampler writing them.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/trace-output.h"
+#include "ns3/npy-trace.h"
+#include "ns3/queue-sampler.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief npy files have a version 1 header with the final shape, padded
+ *        so that the data starts at a multiple of 64 bytes.
+ */
+class NpyTraceTestCase : public TestCase
+{
+public:
+  NpyTraceTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+NpyTraceTestCase::NpyTraceTestCase()
+    : TestCase("Check the header and data of npy files")
+{
+}
+
+void NpyTraceTestCase::DoRun(void)
+{
+  std::string filename = CreateTempDirFilename("values.npy");
+  Ptr<NpyTraceOutput> output = Create<NpyTraceOutput>(filename, "'<u4'", 2 * sizeof(uint32_t),
+                                                      std::vector<uint32_t>{2});
+  std::vector<uint32_t> values;
+  for (uint32_t i = 0; i < 3000; ++i)
+  {
+    values.push_back(i);
+  }
+  for (uint32_t i = 0; i < values.size(); i += 2)
+  {
+    output->Write(&values[i]);
+  }
+  NS_TEST_ASSERT_MSG_EQ(output->GetRecords(), 1500, "Wrong number of records");
+  output->Close();
+
+  std::vector<uint8_t> file = ReadFile(filename);
+  NS_TEST_ASSERT_MSG_EQ(file.size() > 10, true, "File too short");
+  NS_TEST_ASSERT_MSG_EQ(std::string(reinterpret_cast<const char *>(file.data()), 6),
+                        std::string("\x93NUMPY", 6), "Wrong magic");
+  NS_TEST_ASSERT_MSG_EQ(uint32_t(file[6]), 1, "Wrong major version");
+  uint32_t length = ReadLittleEndian(&file[8], 2);
+  NS_TEST_ASSERT_MSG_EQ((10 + length) % 64, 0, "Data not aligned to 64 bytes");
+  std::string dict(reinterpret_cast<const char *>(&file[10]), length);
+  NS_TEST_ASSERT_MSG_EQ(dict.back(), '\n', "Header does not end with a newline");
+  NS_TEST_ASSERT_MSG_EQ(dict.find("'descr': '<u4'") != std::string::npos, true, "Wrong descr");
+  NS_TEST_ASSERT_MSG_EQ(dict.find("'shape': (1500, 2)") != std::string::npos, true,
+                        "Wrong shape in " << dict);
+  NS_TEST_ASSERT_MSG_EQ(file.size(), 10 + length + values.size() * sizeof(uint32_t),
+                        "Wrong data size");
+  NS_TEST_ASSERT_MSG_EQ(std::memcmp(&file[10 + length], values.data(),
+                                    values.size() * sizeof(uint32_t)),
+                        0, "Data does not round trip");
+}
+
+/// A row of a sampler of two queues.
+struct SamplerRow
+{
+  double time;         //!< Time in seconds
+  uint32_t packets[2]; //!< Packets in the queues
+};
+
+static void Enqueue(Ptr<Queue<Packet>> queue)
+{
+  queue->Enqueue(Create<Packet>(100));
+}
+
+static void Dequeue(Ptr<Queue<Packet>> queue)
+{
+  queue->Dequeue();
+}
+
+/**
+ * \brief The queue sampler writes the occupancy of every queue at the
+ *        start and then every interval.
+ */
+class QueueSamplerTestCase : public TestCase
+{
+public:
+  QueueSamplerTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+QueueSamplerTestCase::QueueSamplerTestCase()
+    : TestCase("Check the rows of the queue sampler")
+{
+}
+
+void QueueSamplerTestCase::DoRun(void)
+{
+  Ptr<Queue<Packet>> first = CreateObject<DropTailQueue<Packet>>();
+  Ptr<Queue<Packet>> second = CreateObject<DropTailQueue<Packet>>();
+  Ptr<QueueSampler> sampler = Create<QueueSampler>(MilliSeconds(1));
+  sampler->AddQueue(first, "first");
+  sampler->AddQueue(second, "it's");
+  NS_TEST_ASSERT_MSG_EQ(sampler->GetDescr(),
+                        "[('time', '<f8'), ('first', '<u4'), ('it\\'s', '<u4')]",
+                        "Wrong data type");
+  NS_TEST_ASSERT_MSG_EQ(sampler->GetRowSize(), sizeof(SamplerRow), "Wrong row size");
+
+  Ptr<RecordingTraceOutput<SamplerRow>> output = Create<RecordingTraceOutput<SamplerRow>>();
+  sampler->Start(output);
+  Simulator::Schedule(MicroSeconds(500), &Enqueue, first);
+  Simulator::Schedule(MicroSeconds(1500), &Enqueue, first);
+  Simulator::Schedule(MicroSeconds(1500), &Enqueue, second);
+  Simulator::Schedule(MicroSeconds(2500), &Dequeue, first);
+  Simulator::Stop(MicroSeconds(3500));
+  Simulator::Run();
+  Simulator::Destroy();
+
+  uint32_t expected[][2] = {{0, 0}, {1, 0}, {2, 1}, {1, 1}};
+  NS_TEST_ASSERT_MSG_EQ(output->m_records.size(), 4, "Wrong number of rows");
+  for (uint32_t i = 0; i < output->m_records.size(); ++i)
+  {
+    const SamplerRow &row = output->m_records[i];
+    NS_TEST_ASSERT_MSG_EQ_TOL(row.time, i * 1e-3, 1e-12, "Wrong time of row " << i);
+    NS_TEST_ASSERT_MSG_EQ(row.packets[0], expected[i][0], "Wrong first queue in row " << i);
+    NS_TEST_ASSERT_MSG_EQ(row.packets[1], expected[i][1], "Wrong second queue in row " << i);
+  }
+}
+
+/**
+ * \brief Tests of the npy files and the queue sampler.
+ */
+class NttQueueSamplerTestSuite : public TestSuite
+{
+public:
+  NttQueueSamplerTestSuite();
+};
+
+NttQueueSamplerTestSuite::NttQueueSamplerTestSuite()
+    : TestSuite("ntt-queue-sampler", UNIT)
+{
+  AddTestCase(new NpyTraceTestCase, TestCase::QUICK);
+  AddTestCase(new QueueSamplerTestCase, TestCase::QUICK);
+}
+
+static NttQueueSamplerTestSuite g_nttQueueSamplerTestSuite;
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the training sequences cut from the packet records.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/trace-record.h"
+#include "ns3/sequence-shard.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Sequences are cut every stride packets once the first one is
+ *        full, and spread over shards of at most the shard size.
+ */
+class SequenceShardTestCase : public TestCase
+{
+public:
+  SequenceShardTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+SequenceShardTestCase::SequenceShardTestCase()
+    : TestCase("Check the sequences and shards of packet features")
+{
+}
+
+void SequenceShardTestCase::DoRun(void)
+{
+  const uint32_t features = SequenceShardTraceOutput::SEQUENCE_FEATURES;
+  std::string basename = CreateTempDirFilename("sequences");
+  Ptr<SequenceShardTraceOutput> output = Create<SequenceShardTraceOutput>(basename, 4, 2, 3);
+  std::vector<PacketRecord> records;
+  for (uint32_t i = 0; i < 13; ++i)
+  {
+    records.push_back(MakeTestRecord(i));
+    output->Write(&records.back());
+  }
+  output->Close();
+  // The sequences end at packets 4, 6, 8, 10 and 12.
+  NS_TEST_ASSERT_MSG_EQ(output->GetSequences(), 5, "Wrong number of sequences");
+  NS_TEST_ASSERT_MSG_EQ(output->GetShards(), 2, "Wrong number of shards");
+
+  std::vector<uint8_t> first = ReadFile(basename + "_00000.npy");
+  NS_TEST_ASSERT_MSG_EQ(first.size() > 10, true, "First shard missing");
+  uint32_t length = ReadLittleEndian(&first[8], 2);
+  std::string dict(reinterpret_cast<const char *>(&first[10]), length);
+  NS_TEST_ASSERT_MSG_EQ(dict.find("'shape': (3, 4, 6)") != std::string::npos, true,
+                        "Wrong shape in " << dict);
+
+  std::vector<uint8_t> last = ReadFile(basename + "_00001.npy");
+  NS_TEST_ASSERT_MSG_EQ(last.size() > 10, true, "Last shard missing");
+  length = ReadLittleEndian(&last[8], 2);
+  dict = std::string(reinterpret_cast<const char *>(&last[10]), length);
+  NS_TEST_ASSERT_MSG_EQ(dict.find("'shape': (2, 4, 6)") != std::string::npos, true,
+                        "Wrong shape in " << dict);
+  NS_TEST_ASSERT_MSG_EQ(last.size(), 10 + length + 2 * 4 * features * sizeof(double),
+                        "Wrong data size");
+
+  // The last sequence holds the packets 8 to 11, oldest first.
+  std::vector<double> values(4 * features);
+  std::memcpy(values.data(), &last[10 + length + 4 * features * sizeof(double)],
+              values.size() * sizeof(double));
+  for (uint32_t row = 0; row < 4; ++row)
+  {
+    const PacketRecord &record = records[8 + row];
+    const double *columns = &values[row * features];
+    NS_TEST_ASSERT_MSG_EQ_TOL(columns[0], record.timestamp * 1e-9, 1e-15,
+                              "Wrong time in row " << row);
+    NS_TEST_ASSERT_MSG_EQ(columns[1], record.size, "Wrong size in row " << row);
+    NS_TEST_ASSERT_MSG_EQ_TOL(columns[2], record.delay * 1e-9, 1e-15,
+                              "Wrong delay in row " << row);
+    NS_TEST_ASSERT_MSG_EQ(columns[3], record.workload, "Wrong workload in row " << row);
+    NS_TEST_ASSERT_MSG_EQ(columns[4], record.application, "Wrong application in row " << row);
+    NS_TEST_ASSERT_MSG_EQ(columns[5], record.message, "Wrong message in row " << row);
+  }
+}
+
+/**
+ * \brief Tests of the sequence shards.
+ */
+class NttSequenceShardTestSuite : public TestSuite
+{
+public:
+  NttSequenceShardTestSuite();
+};
+
+NttSequenceShardTestSuite::NttSequenceShardTestSuite()
+    : TestSuite("ntt-sequence-shard", UNIT)
+{
+  AddTestCase(new SequenceShardTestCase, TestCase::QUICK);
+}
+
+static NttSequenceShardTestSuite g_nttSequenceShardTestSuite;
@@ -0,0 +1,242 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Round trips of the trace record formats and of the binary and csv
+// trace files.
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+/**
+ * \brief Every record format can be looked up by its name, its columns
+ *        describe its record and its csv form has its fields.
+ */
+class TraceFormatTestCase : public TestCase
+{
+public:
+  TraceFormatTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+TraceFormatTestCase::TraceFormatTestCase()
+    : TestCase("Check the record formats and the trace file header")
+{
+}
+
+void TraceFormatTestCase::DoRun(void)
+{
+  const char *names[] = {"packet", "queue", "drop", "drop-sequence", "sender",
+                         "joined", "drop-packet", "message", "flow-window"};
+  for (const char *name : names)
+  {
+    Ptr<TraceFormat> format = CreateTraceFormat(name);
+    NS_TEST_ASSERT_MSG_EQ(bool(format), true, "Unknown format " << name);
+    NS_TEST_ASSERT_MSG_EQ(format->GetName(), name, "Format name does not round trip");
+
+    // The columns cover the record without overlapping.
+    uint32_t covered = 0;
+    for (const TraceColumn &column : format->GetColumns())
+    {
+      NS_TEST_ASSERT_MSG_EQ(column.offset, covered, "Column " << column.name << " of "
+                                                               << name << " misplaced");
+      covered += column.size;
+    }
+    NS_TEST_ASSERT_MSG_EQ(covered, format->GetRecordSize(), "Columns of " << name
+                                                                 << " do not cover the record");
+
+    std::vector<uint8_t> record(format->GetRecordSize(), 0);
+    std::string line = PrintLine(*format, record.data());
+    NS_TEST_ASSERT_MSG_EQ(SplitCsv(line).size(), format->GetFields().size(),
+                          "Csv of " << name << " does not match its fields");
+  }
+  NS_TEST_ASSERT_MSG_EQ(bool(CreateTraceFormat("unknown")), false, "Unknown format created");
+
+  NS_TEST_ASSERT_MSG_EQ(CreateTraceFormat("packet")->GetRecordSize(), sizeof(PacketRecord),
+                        "Wrong packet record size");
+  NS_TEST_ASSERT_MSG_EQ(CreateTraceFormat("flow-window")->GetRecordSize(),
+                        sizeof(FlowWindowRecord), "Wrong flow window record size");
+
+  TraceFileHeader header;
+  MakeTraceFileHeader(PacketRecordFormat(), header);
+  std::stringstream file;
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  TraceFileHeader read;
+  NS_TEST_ASSERT_MSG_EQ(ReadTraceFileHeader(file, read), true, "Header not accepted");
+  NS_TEST_ASSERT_MSG_EQ(std::string(read.magic, 4), "NTTR", "Wrong magic");
+  NS_TEST_ASSERT_MSG_EQ(read.version, TRACE_FILE_VERSION, "Wrong version");
+  NS_TEST_ASSERT_MSG_EQ(read.recordSize, sizeof(PacketRecord), "Wrong record size");
+  NS_TEST_ASSERT_MSG_EQ(std::string(read.format), "packet", "Wrong format name");
+
+  std::memcpy(header.magic, "XXXX", 4);
+  std::stringstream bad;
+  bad.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  NS_TEST_ASSERT_MSG_EQ(ReadTraceFileHeader(bad, read), false, "Bad magic accepted");
+}
+
+/**
+ * \brief Binary trace files hold the header and the records as written,
+ *        csv files the schema block and one line per record.
+ */
+class FileTraceOutputTestCase : public TestCase
+{
+public:
+  FileTraceOutputTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+FileTraceOutputTestCase::FileTraceOutputTestCase()
+    : TestCase("Check the round trip of binary and csv trace files")
+{
+}
+
+void FileTraceOutputTestCase::DoRun(void)
+{
+  Ptr<const TraceFormat> format = Create<PacketRecordFormat>();
+  std::vector<PacketRecord> records;
+  for (uint32_t i = 0; i < TEST_RECORDS; ++i)
+  {
+    records.push_back(MakeTestRecord(i));
+  }
+
+  std::string binary = CreateTempDirFilename("packets.bin");
+  std::string csv = CreateTempDirFilename("packets.csv");
+  Ptr<TraceOutput> binaryOutput = Create<FileTraceOutput>(binary, format);
+  Ptr<TraceOutput> csvOutput = Create<FileTraceOutput>(csv, format, FileTraceOutput::CSV);
+  for (const PacketRecord &record : records)
+  {
+    binaryOutput->Write(&record);
+    csvOutput->Write(&record);
+  }
+  binaryOutput->Close();
+  csvOutput->Close();
+  binaryOutput->Close();
+
+  std::ifstream is(binary.c_str(), std::ios::binary);
+  TraceFileHeader header;
+  NS_TEST_ASSERT_MSG_EQ(ReadTraceFileHeader(is, header), true, "Header not accepted");
+  NS_TEST_ASSERT_MSG_EQ(std::string(header.format), "packet", "Wrong format name");
+  std::vector<PacketRecord> read(TEST_RECORDS + 1);
+  is.read(reinterpret_cast<char *>(read.data()), read.size() * sizeof(PacketRecord));
+  NS_TEST_ASSERT_MSG_EQ(static_cast<size_t>(is.gcount()), TEST_RECORDS * sizeof(PacketRecord),
+                        "Wrong number of records");
+  NS_TEST_ASSERT_MSG_EQ(
+      std::memcmp(read.data(), records.data(), TEST_RECORDS * sizeof(PacketRecord)), 0,
+      "Records do not round trip");
+
+  std::ifstream text(csv.c_str());
+  std::string line;
+  std::vector<std::string> lines;
+  while (std::getline(text, line))
+  {
+    lines.push_back(line);
+  }
+  std::ostringstream schema;
+  format->PrintCsvSchema(schema);
+  uint32_t schemaLines = 0;
+  for (char c : schema.str())
+  {
+    schemaLines += c == '\n';
+  }
+  NS_TEST_ASSERT_MSG_EQ(lines.size(), schemaLines + TEST_RECORDS, "Wrong number of csv lines");
+  NS_TEST_ASSERT_MSG_EQ(lines[0].find("# ntt-trace-schema"), 0, "Schema block missing");
+  NS_TEST_ASSERT_MSG_EQ(lines[schemaLines + 42], PrintLine(*format, &records[42]),
+                        "Wrong csv line");
+}
+
+/**
+ * \brief The csv form of packet records has null ports and TCP columns
+ *        exactly for the packets without them.
+ */
+class PacketCsvTestCase : public TestCase
+{
+public:
+  PacketCsvTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+PacketCsvTestCase::PacketCsvTestCase()
+    : TestCase("Check the null columns of the packet csv")
+{
+}
+
+void PacketCsvTestCase::DoRun(void)
+{
+  PacketRecordFormat format;
+  uint32_t sourcePort = FindField(format, "sourcePort");
+  uint32_t sequence = FindField(format, "sequence");
+  uint32_t message = FindField(format, "message");
+
+  PacketRecord tcp = MakeTestRecord(1);
+  std::vector<std::string> columns = SplitCsv(PrintLine(format, &tcp));
+  NS_TEST_ASSERT_MSG_EQ(columns.size(), format.GetFields().size(), "Wrong number of columns");
+  NS_TEST_ASSERT_MSG_EQ(columns[sourcePort], "1001", "Wrong TCP source port");
+  NS_TEST_ASSERT_MSG_EQ(columns[sequence], "1001", "Wrong TCP sequence number");
+  NS_TEST_ASSERT_MSG_EQ(columns[message], "0", "Wrong message id");
+
+  PacketRecord udp = MakeTestRecord(5);
+  columns = SplitCsv(PrintLine(format, &udp));
+  NS_TEST_ASSERT_MSG_EQ(columns[sourcePort], "1002", "Wrong UDP source port");
+  NS_TEST_ASSERT_MSG_EQ(columns[sequence], "", "Sequence number of a datagram not null");
+
+  // Non-first fragments have no transport header and zero ports.
+  PacketRecord fragment = udp;
+  fragment.sourcePort = 0;
+  fragment.destinationPort = 0;
+  columns = SplitCsv(PrintLine(format, &fragment));
+  NS_TEST_ASSERT_MSG_EQ(columns.size(), format.GetFields().size(), "Wrong number of columns");
+  NS_TEST_ASSERT_MSG_EQ(columns[sourcePort], "", "Port of a fragment not null");
+  NS_TEST_ASSERT_MSG_EQ(columns[sourcePort + 1], "", "Port of a fragment not null");
+
+  fragment.protocol = 6;
+  columns = SplitCsv(PrintLine(format, &fragment));
+  NS_TEST_ASSERT_MSG_EQ(columns[sequence], "", "TCP columns of a fragment not null");
+}
+
+/**
+ * \brief Tests of the trace formats and file outputs.
+ */
+class NttTraceOutputTestSuite : public TestSuite
+{
+public:
+  NttTraceOutputTestSuite();
+};
+
+NttTraceOutputTestSuite::NttTraceOutputTestSuite()
+    : TestSuite("ntt-trace-output", UNIT)
+{
+  AddTestCase(new TraceFormatTestCase, TestCase::QUICK);
+  AddTestCase(new FileTraceOutputTestCase, TestCase::QUICK);
+  AddTestCase(new PacketCsvTestCase, TestCase::QUICK);
+}
+
+static NttTraceOutputTestSuite g_nttTraceOutputTestSuite;
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Tests of the packet selection of the trace sampler.
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/experiment-tags.h"
+#include "ns3/trace-sampler.h"
+
+#include "trace-test-helpers.h"
+
+using namespace ns3;
+
+// A packet of the flow of application, with the IdTag only.
+static Ptr<Packet> MakeFlowPacket(uint32_t application)
+{
+  Ptr<Packet> p = Create<Packet>(100);
+  IdTag idTag;
+  idTag.SetWorkload(1);
+  idTag.SetApplication(application);
+  p->AddPacketTag(idTag);
+  return p;
+}
+
+// A packet sent delay ago.
+static Ptr<Packet> MakeDelayedPacket(Time delay)
+{
+  Ptr<Packet> p = Create<Packet>(100);
+  TimestampTag timestampTag;
+  timestampTag.SetTime(Simulator::Now() - delay);
+  p->AddPacketTag(timestampTag);
+  return p;
+}
+
+static void SelectNow(Ptr<TraceSampler> sampler, std::vector<bool> *selected)
+{
+  selected->push_back(sampler->Select(Create<Packet>(100)));
+}
+
+// Fill the delays up to the first update of the threshold with delays of
+// 1 to DELAY_UPDATE microseconds, then select a short and a long one.
+static void SelectDelays(Ptr<TraceSampler> sampler, std::vector<bool> *selected)
+{
+  for (uint32_t i = 1; i <= TraceSampler::DELAY_UPDATE; ++i)
+  {
+    sampler->Select(MakeDelayedPacket(MicroSeconds(i)));
+  }
+  selected->push_back(sampler->Select(MakeDelayedPacket(MicroSeconds(100))));
+  selected->push_back(sampler->Select(MakeDelayedPacket(MicroSeconds(1000))));
+}
+
+/**
+ * \brief Every rule selects the packets of its description, and the
+ *        rules combine.
+ */
+class TraceSamplerTestCase : public TestCase
+{
+public:
+  TraceSamplerTestCase();
+
+private:
+  virtual void DoRun(void);
+};
+
+TraceSamplerTestCase::TraceSamplerTestCase()
+    : TestCase("Check the rules of the trace sampler")
+{
+}
+
+void TraceSamplerTestCase::DoRun(void)
+{
+  Ptr<TraceSampler> all = Create<TraceSampler>("");
+  for (uint32_t i = 0; i < 10; ++i)
+  {
+    NS_TEST_ASSERT_MSG_EQ(all->Select(Create<Packet>(100)), true, "Empty policy rejected");
+  }
+  NS_TEST_ASSERT_MSG_EQ(all->GetSelected(), 10, "Wrong selected count");
+  NS_TEST_ASSERT_MSG_EQ(all->GetRejected(), 0, "Wrong rejected count");
+
+  Ptr<TraceSampler> every = Create<TraceSampler>("every=3");
+  for (uint32_t i = 0; i < 9; ++i)
+  {
+    NS_TEST_ASSERT_MSG_EQ(every->Select(Create<Packet>(100)), i % 3 == 0,
+                          "Wrong selection of packet " << i);
+  }
+  NS_TEST_ASSERT_MSG_EQ(every->GetSelected(), 3, "Wrong selected count");
+  NS_TEST_ASSERT_MSG_EQ(every->GetRejected(), 6, "Wrong rejected count");
+
+  // Every flow is selected by exactly one residue, the same way by every
+  // sampler, and the residues share the flows about evenly.
+  std::vector<Ptr<TraceSampler>> residues;
+  for (uint32_t residue = 0; residue < 4; ++residue)
+  {
+    std::ostringstream policy;
+    policy << "flows=4:" << residue;
+    residues.push_back(Create<TraceSampler>(policy.str()));
+  }
+  Ptr<TraceSampler> again = Create<TraceSampler>("flows=4:1");
+  for (uint32_t application = 0; application < 256; ++application)
+  {
+    std::vector<bool> selecting;
+    for (Ptr<TraceSampler> sampler : residues)
+    {
+      selecting.push_back(sampler->Select(MakeFlowPacket(application)));
+    }
+    NS_TEST_ASSERT_MSG_EQ(std::count(selecting.begin(), selecting.end(), true), 1,
+                          "Flow " << application << " not in one residue");
+    NS_TEST_ASSERT_MSG_EQ(again->Select(MakeFlowPacket(application)), selecting[1],
+                          "Samplers disagree on flow " << application);
+  }
+  for (Ptr<TraceSampler> sampler : residues)
+  {
+    NS_TEST_ASSERT_MSG_EQ(sampler->GetSelected() > 32 && sampler->GetSelected() < 100, true,
+                          "Flows unevenly spread: " << sampler->GetSelected());
+  }
+  NS_TEST_ASSERT_MSG_EQ(again->Select(Create<Packet>(100)), false,
+                        "Packet without IdTag selected by its flow");
+
+  // Of the selected flows, every second packet.
+  Ptr<TraceSampler> combined = Create<TraceSampler>("flows=4:1,every=2");
+  for (uint32_t application = 0; application < 256; ++application)
+  {
+    combined->Select(MakeFlowPacket(application));
+  }
+  NS_TEST_ASSERT_MSG_EQ(combined->GetSelected(), (again->GetSelected() + 1) / 2,
+                        "Rules do not combine");
+
+  Ptr<TraceSampler> window = Create<TraceSampler>("time=1ms-2ms");
+  std::vector<bool> selected;
+  Simulator::Schedule(MicroSeconds(500), &SelectNow, window, &selected);
+  Simulator::Schedule(MicroSeconds(1500), &SelectNow, window, &selected);
+  Simulator::Schedule(MicroSeconds(2500), &SelectNow, window, &selected);
+  Simulator::Run();
+  Simulator::Destroy();
+  NS_TEST_ASSERT_MSG_EQ(selected.size(), 3, "Wrong number of packets");
+  NS_TEST_ASSERT_MSG_EQ(selected[0], false, "Packet before the window selected");
+  NS_TEST_ASSERT_MSG_EQ(selected[1], true, "Packet in the window rejected");
+  NS_TEST_ASSERT_MSG_EQ(selected[2], false, "Packet after the window selected");
+
+  Ptr<TraceSampler> delay = Create<TraceSampler>("delay=p50");
+  selected.clear();
+  Simulator::Schedule(Seconds(1), &SelectDelays, delay, &selected);
+  Simulator::Run();
+  Simulator::Destroy();
+  NS_TEST_ASSERT_MSG_EQ(delay->GetSelected(), TraceSampler::DELAY_UPDATE + 1,
+                        "Delays before the first update not all selected");
+  NS_TEST_ASSERT_MSG_EQ(selected[0], false, "Short delay selected");
+  NS_TEST_ASSERT_MSG_EQ(selected[1], true, "Long delay rejected");
+}
+
+/**
+ * \brief Tests of the trace sampler.
+ */
+class NttTraceSamplerTestSuite : public TestSuite
+{
+public:
+  NttTraceSamplerTestSuite();
+};
+
+NttTraceSamplerTestSuite::NttTraceSamplerTestSuite()
+    : TestSuite("ntt-trace-sampler", UNIT)
+{
+  AddTestCase(new TraceSamplerTestCase, TestCase::QUICK);
+}
+
+static NttTraceSamplerTestSuite g_nttTraceSamplerTestSuite;
@@ -0,0 +1,232 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/experiment-tags.h"
+#include "ns3/node.h"
+#include "ns3/drop-tail-queue.h"
+
+#include "trace-test-helpers.h"
+
+namespace ns3
+{
+
+PacketRecord MakeTestRecord(uint32_t i)
+{
+  PacketRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.timestamp = 1000 * static_cast<uint64_t>(i);
+  record.uid = i;
+  record.delay = 5000 + (i % 7) * 100 - (i % 11 == 0 ? 9000 : 0);
+  record.size = 100 + (i % 3) * 500;
+  record.flowId = i % 4;
+  record.source = 0x0a000001 + i % 3;
+  record.destination = 0x0a000063;
+  record.sequence = 1 + 1000 * i;
+  record.workload = 1;
+  record.application = i % 3;
+  record.message = i / 10;
+  record.ackNumber = 1 + 20 * i;
+  record.sourcePort = 1000 + i % 3;
+  record.destinationPort = 80;
+  record.ipId = i;
+  record.payloadSize = record.size - 34;
+  record.window = 65535;
+  record.protocol = i % 5 == 0 ? 17 : 6;
+  record.ttl = 64;
+  record.tcpFlags = 0x10;
+  return record;
+}
+
+// Add the IPv4 and Ethernet headers and the tags of the senders.
+static void AddFrameHeaders(Ptr<Packet> p, uint32_t application, uint32_t message,
+                            uint8_t protocol, uint16_t identification, uint16_t offset,
+                            Ipv4Address source)
+{
+  Ipv4Header ip;
+  ip.SetSource(source);
+  ip.SetDestination(Ipv4Address("10.0.0.2"));
+  ip.SetProtocol(protocol);
+  ip.SetPayloadSize(p->GetSize());
+  ip.SetTtl(64);
+  ip.SetIdentification(identification);
+  ip.SetFragmentOffset(offset);
+  p->AddHeader(ip);
+  EthernetHeader ethernet(false);
+  ethernet.SetLengthType(0x0800);
+  p->AddHeader(ethernet);
+
+  IdTag idTag;
+  idTag.SetWorkload(1);
+  idTag.SetApplication(application);
+  p->AddPacketTag(idTag);
+  MessageTag messageTag;
+  messageTag.SetSimpleValue(message);
+  p->AddPacketTag(messageTag);
+  TimestampTag timestampTag;
+  timestampTag.SetTime(Seconds(0));
+  p->AddPacketTag(timestampTag);
+}
+
+Ptr<Packet> MakeFrame(uint32_t application, uint32_t message, uint8_t protocol,
+                      uint32_t sequence, uint32_t bytes, Ipv4Address source)
+{
+  Ptr<Packet> p = Create<Packet>(bytes);
+  if (protocol == 6)
+  {
+    TcpHeader tcp;
+    tcp.SetSourcePort(1000 + application);
+    tcp.SetDestinationPort(80);
+    tcp.SetSequenceNumber(SequenceNumber32(sequence));
+    tcp.SetAckNumber(SequenceNumber32(1));
+    tcp.SetFlags(TcpHeader::ACK);
+    tcp.SetWindowSize(4000);
+    p->AddHeader(tcp);
+  }
+  else
+  {
+    UdpHeader udp;
+    udp.SetSourcePort(1000 + application);
+    udp.SetDestinationPort(80);
+    p->AddHeader(udp);
+  }
+  AddFrameHeaders(p, application, message, protocol, sequence, 0, source);
+  return p;
+}
+
+Ptr<Packet> MakeFragment(uint32_t application, uint32_t message, uint16_t identification,
+                         uint16_t offset, uint32_t bytes)
+{
+  Ptr<Packet> p = Create<Packet>(bytes);
+  AddFrameHeaders(p, application, message, 17, identification, offset,
+                  Ipv4Address("10.0.0.1"));
+  return p;
+}
+
+std::vector<std::string> SplitCsv(const std::string &line)
+{
+  std::vector<std::string> columns;
+  std::istringstream is(line);
+  std::string column;
+  while (std::getline(is, column, ','))
+  {
+    columns.push_back(column);
+  }
+  if (!line.empty() && line.back() == ',')
+  {
+    columns.push_back("");
+  }
+  return columns;
+}
+
+std::string PrintLine(const TraceFormat &format, const void *record)
+{
+  std::ostringstream os;
+  format.PrintCsv(os, static_cast<const uint8_t *>(record));
+  std::string line = os.str();
+  if (!line.empty() && line.back() == '\n')
+  {
+    line.pop_back();
+  }
+  return line;
+}
+
+uint32_t FindField(const TraceFormat &format, std::string name)
+{
+  std::vector<TraceField> fields = format.GetFields();
+  for (uint32_t i = 0; i < fields.size(); ++i)
+  {
+    if (fields[i].name == name)
+    {
+      return i;
+    }
+  }
+  return fields.size();
+}
+
+std::vector<uint8_t> ReadFile(std::string filename)
+{
+  std::ifstream is(filename.c_str(), std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(is),
+                              std::istreambuf_iterator<char>());
+}
+
+uint64_t ReadLittleEndian(const uint8_t *data, uint32_t width)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < width; ++i)
+  {
+    value |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+NS_OBJECT_ENSURE_REGISTERED(TapNetDevice);
+
+TypeId TapNetDevice::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::TapNetDevice")
+                          .SetParent<SimpleNetDevice>()
+                          .SetGroupName("Network")
+                          .AddConstructor<TapNetDevice>()
+                          .AddTraceSource("MacTx", "A packet sent by the test.",
+                                          MakeTraceSourceAccessor(&TapNetDevice::m_macTxTrace),
+                                          "ns3::Packet::TracedCallback")
+                          .AddTraceSource("MacRx", "A packet received by the test.",
+                                          MakeTraceSourceAccessor(&TapNetDevice::m_macRxTrace),
+                                          "ns3::Packet::TracedCallback")
+                          .AddTraceSource("MacTxDrop", "A packet dropped by the test.",
+                                          MakeTraceSourceAccessor(
+                                              &TapNetDevice::m_macTxDropTrace),
+                                          "ns3::Packet::TracedCallback");
+  return tid;
+}
+
+void TapNetDevice::FireMacTx(Ptr<const Packet> p)
+{
+  m_macTxTrace(p);
+}
+
+void TapNetDevice::FireMacRx(Ptr<const Packet> p)
+{
+  m_macRxTrace(p);
+}
+
+void TapNetDevice::FireMacTxDrop(Ptr<const Packet> p)
+{
+  m_macTxDropTrace(p);
+}
+
+Ptr<TapNetDevice> MakeTapNode(void)
+{
+  Ptr<Node> node = CreateObject<Node>();
+  Ptr<TapNetDevice> device = CreateObject<TapNetDevice>();
+  device->SetQueue(CreateObject<DropTailQueue<Packet>>());
+  node->AddDevice(device);
+  return device;
+}
+
+} // namespace ns3
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_TEST_HELPERS_H
+#define TRACE_TEST_HELPERS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/traced-callback.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+namespace ns3
+{
+
+/// Number of records written by the round trip tests.
+const uint32_t TEST_RECORDS = 1000;
+
+/**
+ * \param i the index of the record
+ * \return a packet record whose fields all depend on i, with a UDP
+ *         datagram every fifth record
+ */
+PacketRecord MakeTestRecord(uint32_t i);
+
+/**
+ * \brief Make a frame as traced at a CsmaNetDevice to 10.0.0.2, with the
+ *        tags of the senders: the IdTag of workload 1, the MessageTag and
+ *        a TimestampTag of time 0.
+ * \param application the application of the IdTag; the source port is
+ *        1000 plus it, the destination port 80
+ * \param message the id of the MessageTag
+ * \param protocol 6 for TCP, 17 for UDP
+ * \param sequence the TCP sequence number, also the IPv4 identification
+ * \param bytes the data bytes
+ * \param source the source address
+ * \return the frame
+ */
+Ptr<Packet> MakeFrame(uint32_t application, uint32_t message, uint8_t protocol,
+                      uint32_t sequence, uint32_t bytes,
+                      Ipv4Address source = Ipv4Address("10.0.0.1"));
+
+/**
+ * \brief Make a non-first IPv4 fragment of a UDP datagram from 10.0.0.1,
+ *        like MakeFrame but without the UDP header.
+ * \param application the application of the IdTag
+ * \param message the id of the MessageTag
+ * \param identification the IPv4 identification of the datagram
+ * \param offset the fragment offset in bytes
+ * \param bytes the data bytes
+ * \return the frame
+ */
+Ptr<Packet> MakeFragment(uint32_t application, uint32_t message, uint16_t identification,
+                         uint16_t offset, uint32_t bytes);
+
+/**
+ * \param line a csv line without the newline
+ * \return its columns, also the empty ones
+ */
+std::vector<std::string> SplitCsv(const std::string &line);
+
+/**
+ * \param format the format of the record
+ * \param record the record
+ * \return the csv form of the record, without the newline
+ */
+std::string PrintLine(const TraceFormat &format, const void *record);
+
+/**
+ * \param format the format of the record
+ * \param name the name of a field
+ * \return the column of the field in the csv form, the number of fields
+ *         if there is none
+ */
+uint32_t FindField(const TraceFormat &format, std::string name);
+
+/**
+ * \param filename the file
+ * \return the bytes of the file, none if it cannot be read
+ */
+std::vector<uint8_t> ReadFile(std::string filename);
+
+/**
+ * \param data the bytes
+ * \param width the number of bytes, at most 8
+ * \return the little endian number of the bytes
+ */
+uint64_t ReadLittleEndian(const uint8_t *data, uint32_t width);
+
+/**
+ * \brief Trace output keeping the records in memory.
+ */
+template <typename Record>
+class RecordingTraceOutput : public TraceOutput
+{
+public:
+  RecordingTraceOutput(void)
+      : m_closed(0),
+        m_blocked(false)
+  {
+  }
+
+  virtual void Write(const void *record)
+  {
+    while (m_blocked.load())
+    {
+      std::this_thread::yield();
+    }
+    Record copy;
+    std::memcpy(&copy, record, sizeof(copy));
+    m_records.push_back(copy);
+  }
+
+  virtual void Close(void)
+  {
+    ++m_closed;
+  }
+
+  std::vector<Record> m_records; //!< The records written
+  uint32_t m_closed;             //!< Number of Close() calls
+  std::atomic<bool> m_blocked;   //!< Write() waits while set
+};
+
+/**
+ * \brief SimpleNetDevice with the MAC traces of the CsmaNetDevice, fired
+ *        by the test instead of by sent packets.
+ */
+class TapNetDevice : public SimpleNetDevice
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId(void);
+
+  /// \param p the packet to trace as sent
+  void FireMacTx(Ptr<const Packet> p);
+  /// \param p the packet to trace as received
+  void FireMacRx(Ptr<const Packet> p);
+  /// \param p the packet to trace as dropped
+  void FireMacTxDrop(Ptr<const Packet> p);
+
+private:
+  TracedCallback<Ptr<const Packet>> m_macTxTrace;     //!< The MacTx trace
+  TracedCallback<Ptr<const Packet>> m_macRxTrace;     //!< The MacRx trace
+  TracedCallback<Ptr<const Packet>> m_macTxDropTrace; //!< The MacTxDrop trace
+};
+
+/**
+ * \return the TapNetDevice, with a DropTailQueue, of a new node
+ */
+Ptr<TapNetDevice> MakeTapNode(void);
+
+} // namespace ns3
+
+#endif /* TRACE_TEST_HELPERS_H */
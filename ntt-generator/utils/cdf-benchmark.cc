@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compare the message size draws of CdfTable with EmpiricalRandomVariable,
+// which CdfApplication used before, e.g.
+//
+//   ./waf --run "ntt-cdf-benchmark --input=distributions/Google_AllRPC.txt,distributions/Fabricated_Heavy_Middle.txt"
+//
+// For every file, both draw the same number of sizes from random variables
+// on the same stream, so the interpolated sizes must be equal one by one
+// before they are rounded down to bytes; the mismatches and the mean size
+// are printed with the time per draw of EmpiricalRandomVariable, the
+// binary search of CdfTable::SampleSearch and the guide table of
+// CdfTable::Sample. Only the last should not grow with the number of
+// points.
+
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/cdf-table.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CdfBenchmark");
+
+// Split a comma separated list.
+static std::vector<std::string> Split(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// Draw `draws` sizes into `sizes` and return the nanoseconds per draw.
+template <typename Draw>
+static double Time(uint32_t draws, std::vector<double> &sizes, Draw draw)
+{
+  sizes.resize(draws);
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < draws; ++i)
+  {
+    sizes[i] = draw();
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / draws;
+}
+
+int main(int argc, char *argv[])
+{
+  std::string input = "distributions/Google_AllRPC.txt,distributions/Fabricated_Heavy_Middle.txt";
+  uint32_t draws = 10000000;
+  int64_t stream = 1;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Comma separated CDF files.", input);
+  cmd.AddValue("draws", "Sizes drawn per file and method.", draws);
+  cmd.AddValue("stream", "Random variable stream of all methods.", stream);
+  cmd.Parse(argc, argv);
+
+  std::cout << "file,points,mismatches,mean,empiricalNs,searchNs,guideNs" << std::endl;
+  for (const std::string &file : Split(input))
+  {
+    Ptr<const CdfTable> table = CdfTable::Load(file);
+    NS_ABORT_MSG_UNLESS(table, "Could not parse " << file);
+
+    // The reference, loaded like CdfApplication did.
+    Ptr<EmpiricalRandomVariable> empirical = CreateObject<EmpiricalRandomVariable>();
+    empirical->SetStream(stream);
+    std::ifstream distFile(file.c_str());
+    double value, probability;
+    distFile >> value;
+    while (distFile >> value >> probability)
+    {
+      empirical->CDF(value, probability);
+    }
+    std::vector<double> reference;
+    double empiricalNs = Time(draws, reference, [&]() { return empirical->GetValue(); });
+
+    Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable>();
+    uniform->SetStream(stream);
+    std::vector<double> searched;
+    double searchNs =
+        Time(draws, searched, [&]() { return table->SampleSearch(uniform->GetValue()); });
+
+    uniform = CreateObject<UniformRandomVariable>();
+    uniform->SetStream(stream);
+    std::vector<double> guided;
+    double guideNs = Time(draws, guided, [&]() { return table->Sample(uniform->GetValue()); });
+
+    uint64_t mismatches = 0;
+    double sum = 0;
+    for (uint32_t i = 0; i < draws; ++i)
+    {
+      mismatches += reference[i] != guided[i] || searched[i] != guided[i];
+      sum += guided[i];
+    }
+    std::cout << file << ',' << table->GetNPoints() << ',' << mismatches << ','
+              << sum / draws << ',' << empiricalNs << ',' << searchNs << ',' << guideNs
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compile CDF text files into the binary form that CdfApplication maps
+// with its CompiledCdfFile attribute, e.g.
+//
+//   ./waf --run "ntt-cdf-compile --input=distributions/Google_AllRPC.txt,distributions/DCTCP_MsgSizeDist.txt"
+//
+// Every file is checked like CdfApplication does and written next to it
+// with the extension .cdfb, or into --output if given. Files that are not
+// valid CDF files are reported and skipped. The average size of the file
+// and the mean of the drawn sizes are printed, as they need not agree.
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/cdf-table.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CdfCompile");
+
+// Split a comma separated list.
+static std::vector<std::string> Split(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// The compiled file of `file`, see CdfTable::GetCompiledName, in
+// `directory` unless that is empty.
+static std::string CompiledName(const std::string &file, const std::string &directory)
+{
+  std::string name = CdfTable::GetCompiledName(file);
+  if (!directory.empty())
+  {
+    std::string::size_type slash = name.rfind('/');
+    std::string separator = directory[directory.size() - 1] == '/' ? "" : "/";
+    name = directory + separator + name.substr(slash == std::string::npos ? 0 : slash + 1);
+  }
+  return name;
+}
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Comma separated CDF files.", input);
+  cmd.AddValue("output", "Directory of the compiled files; next to the inputs if empty.", output);
+  cmd.Parse(argc, argv);
+  NS_ABORT_MSG_IF(input.empty(), "No --input given.");
+
+  uint32_t failed = 0;
+  std::cout << "file,points,averageSize,mean,output" << std::endl;
+  for (const std::string &file : Split(input))
+  {
+    Ptr<const CdfTable> table = CdfTable::Load(file);
+    if (!table)
+    {
+      std::cerr << "Skipped " << file << ", it is not a CDF file." << std::endl;
+      ++failed;
+      continue;
+    }
+    std::string compiled = CompiledName(file, output);
+    // Check the written file like CdfApplication will read it.
+    if (!table->Save(compiled) || !CdfTable::Map(compiled))
+    {
+      std::cerr << "Could not write " << compiled << std::endl;
+      ++failed;
+      continue;
+    }
+    std::cout << file << ',' << table->GetNPoints() << ',' << table->GetAverageSize() << ','
+              << table->GetMean() << ',' << compiled << std::endl;
+  }
+  return failed == 0 ? 0 : 1;
+}
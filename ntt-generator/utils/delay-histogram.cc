@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Merge delay histogram files written with --delayhistogram, e.g. of a
+// sweep over seeds, and print quantiles of the delays as csv:
+//
+//   ./waf --run "ntt-delay-histogram --input=seed1_delay.ntd,seed2_delay.ntd --output=all.ntd"
+//   ./waf --run "ntt-delay-histogram --input=all.ntd --by=workload --quantiles=0.5,0.9,0.99"
+//
+// The csv has the columns workload, application, receiver, count, mean,
+// min, max and one column per quantile, delays in seconds. Keys that are
+// not grouped by are printed as -1.
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/delay-histogram.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("DelayHistogramMerge");
+
+// Split a comma separated list.
+static std::vector<std::string> Split(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// Print a key element, -1 if it is not grouped by.
+static void PrintKey(std::ostream &os, uint32_t value, bool grouped)
+{
+  if (grouped)
+  {
+    os << value;
+  }
+  else
+  {
+    os << -1;
+  }
+  os << ',';
+}
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string by = "key";
+  std::string quantiles = "0.5,0.99";
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Comma separated histogram files to merge.", input);
+  cmd.AddValue("output", "Histogram file to write the merged histograms to, none if empty.", output);
+  cmd.AddValue("by", "Group by key (workload, application and receiver), workload, application, receiver or all.", by);
+  cmd.AddValue("quantiles", "Comma separated quantiles to print, none if empty.", quantiles);
+  cmd.Parse(argc, argv);
+
+  std::vector<std::string> inputs = Split(input);
+  NS_ABORT_MSG_IF(inputs.empty(), "No input file given.");
+  bool byWorkload = by == "key" || by == "workload";
+  bool byApplication = by == "key" || by == "application";
+  bool byReceiver = by == "key" || by == "receiver";
+  NS_ABORT_MSG_UNLESS(byWorkload || byApplication || byReceiver || by == "all",
+                      "Unknown grouping " << by);
+  std::vector<double> qs;
+  for (const std::string &q : Split(quantiles))
+  {
+    qs.push_back(std::stod(q));
+  }
+
+  DelayHistogramSet merged;
+  for (const std::string &file : inputs)
+  {
+    merged.Read(file);
+  }
+  if (!output.empty())
+  {
+    merged.Write(output);
+  }
+
+  DelayHistogramSet grouped;
+  for (const auto &histogram : merged.GetHistograms())
+  {
+    DelayHistogramSet::Key key(byWorkload ? std::get<0>(histogram.first) : 0,
+                               byApplication ? std::get<1>(histogram.first) : 0,
+                               byReceiver ? std::get<2>(histogram.first) : 0);
+    grouped.Merge(key, histogram.second);
+  }
+
+  std::cout << "workload,application,receiver,count,mean,min,max";
+  for (double q : qs)
+  {
+    std::cout << ",q" << q;
+  }
+  std::cout << "\n";
+  for (const auto &histogram : grouped.GetHistograms())
+  {
+    const DelayHistogram &h = histogram.second;
+    PrintKey(std::cout, std::get<0>(histogram.first), byWorkload);
+    PrintKey(std::cout, std::get<1>(histogram.first), byApplication);
+    PrintKey(std::cout, std::get<2>(histogram.first), byReceiver);
+    std::cout << h.GetCount() << ',' << h.GetMean() / 1e9 << ','
+              << NanoSeconds(h.GetMin()).GetSeconds() << ','
+              << NanoSeconds(h.GetMax()).GetSeconds();
+    for (double q : qs)
+    {
+      std::cout << ',' << NanoSeconds(h.GetQuantile(q)).GetSeconds();
+    }
+    std::cout << "\n";
+  }
+  std::cerr << "Merged " << merged.GetHistograms().size() << " histograms of "
+            << inputs.size() << " files." << std::endl;
+  return 0;
+}
@@ -0,0 +1,437 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Convert packet logs in the old "label, value" csv layout, e.g.
+//
+//   Tx sent at:, 1.2, Flow id is, 1, Packet uid is, 7, ... Message id is, 3,
+//
+// to packet records in a binary trace layout:
+//
+//   ./waf --run "ntt-legacy-convert --input=results/a.csv,results/b.csv --traceformat=columnar"
+//
+// writes results/a.ntc and results/b.ntc. Both the TCP-only layout and the
+// layout of trafficgen_large_tests with UDP ports or "Unknown transport
+// protocol" are read, fields are matched by their label. Anything after the
+// message id, e.g. a Packet::Print dump, is ignored.
+//
+// The files are memory-mapped and cut into line-aligned pieces which are
+// parsed on all cores; the records are written in file order. Times in the
+// old logs have six significant digits, which limits their precision.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LegacyConvert");
+
+// Bytes of the file parsed by one thread at a time.
+static const size_t PIECE_SIZE = 64 << 20;
+
+// Split a comma separated list.
+static std::vector<std::string> Split(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// One comma separated token of a line, without surrounding blanks.
+struct Token
+{
+  const char *begin;
+  const char *end;
+
+  bool Is(const char *label) const
+  {
+    size_t length = std::strlen(label);
+    return static_cast<size_t>(end - begin) == length && std::memcmp(begin, label, length) == 0;
+  }
+};
+
+// Read the next token of [pos, end) and move pos behind its comma.
+static bool NextToken(const char *&pos, const char *end, Token &token)
+{
+  while (pos < end && (*pos == ' ' || *pos == '\t'))
+  {
+    ++pos;
+  }
+  if (pos >= end)
+  {
+    return false;
+  }
+  const char *comma = static_cast<const char *>(std::memchr(pos, ',', end - pos));
+  const char *stop = comma ? comma : end;
+  token.begin = pos;
+  token.end = stop;
+  while (token.end > token.begin && (token.end[-1] == ' ' || token.end[-1] == '\r'))
+  {
+    --token.end;
+  }
+  pos = comma ? comma + 1 : end;
+  return true;
+}
+
+static bool ParseUnsigned(const Token &token, uint64_t &value)
+{
+  value = 0;
+  if (token.begin == token.end)
+  {
+    return false;
+  }
+  for (const char *c = token.begin; c < token.end; ++c)
+  {
+    if (*c < '0' || *c > '9')
+    {
+      return false;
+    }
+    value = value * 10 + (*c - '0');
+  }
+  return true;
+}
+
+// Parse seconds into nanoseconds.
+static bool ParseSeconds(const Token &token, uint64_t &nanoseconds)
+{
+  std::string text(token.begin, token.end);
+  char *stop;
+  double seconds = std::strtod(text.c_str(), &stop);
+  if (stop == text.c_str() || *stop != '\0' || seconds < 0)
+  {
+    return false;
+  }
+  nanoseconds = std::llround(seconds * 1e9);
+  return true;
+}
+
+// Parse a dotted quad into the value of Ipv4Address::Get.
+static bool ParseAddress(const Token &token, uint32_t &address)
+{
+  address = 0;
+  const char *c = token.begin;
+  for (int i = 0; i < 4; ++i)
+  {
+    uint32_t part = 0;
+    const char *start = c;
+    while (c < token.end && *c >= '0' && *c <= '9')
+    {
+      part = part * 10 + (*c++ - '0');
+    }
+    if (c == start || part > 255 || (i < 3 && (c >= token.end || *c++ != '.')))
+    {
+      return false;
+    }
+    address = (address << 8) | part;
+  }
+  return c == token.end;
+}
+
+// Parse one line of logPacketInfo. Returns false if it is not a complete
+// packet line.
+static bool ParseLine(const char *pos, const char *end, PacketRecord &record)
+{
+  std::memset(&record, 0, sizeof(record));
+  bool haveTimestamp = false;
+  bool haveDelay = false;
+  Token label;
+  Token value;
+  while (NextToken(pos, end, label))
+  {
+    if (label.Is("Unknown transport protocol"))
+    {
+      continue;
+    }
+    if (!NextToken(pos, end, value))
+    {
+      return false;
+    }
+    uint64_t number = 0;
+    bool ok;
+    if (label.Is("Tx sent at:"))
+    {
+      ok = haveTimestamp = ParseSeconds(value, record.timestamp);
+    }
+    else if (label.Is("Delay is"))
+    {
+      ok = haveDelay = ParseSeconds(value, number);
+      record.delay = number;
+    }
+    else if (label.Is("Source IP is"))
+    {
+      ok = ParseAddress(value, record.source);
+    }
+    else if (label.Is("Destination IP is"))
+    {
+      ok = ParseAddress(value, record.destination);
+    }
+    else
+    {
+      ok = ParseUnsigned(value, number);
+      if (label.Is("Flow id is"))
+      {
+        record.flowId = number;
+      }
+      else if (label.Is("Packet uid is"))
+      {
+        record.uid = number;
+      }
+      else if (label.Is("Packet size is"))
+      {
+        record.size = number;
+      }
+      else if (label.Is("IP ID is"))
+      {
+        record.ipId = number;
+      }
+      else if (label.Is("DSCP is"))
+      {
+        record.dscp = number;
+      }
+      else if (label.Is("ECN is"))
+      {
+        record.ecn = number;
+      }
+      else if (label.Is("TTL is"))
+      {
+        record.ttl = number;
+      }
+      else if (label.Is("Payload size is"))
+      {
+        record.payloadSize = number;
+      }
+      else if (label.Is("Protocol is"))
+      {
+        record.protocol = number;
+      }
+      else if (label.Is("TCP source port is") || label.Is("UDP source port is"))
+      {
+        record.sourcePort = number;
+      }
+      else if (label.Is("TCP destination port is") || label.Is("UDP destination port is"))
+      {
+        record.destinationPort = number;
+      }
+      else if (label.Is("TCP sequence num is"))
+      {
+        record.sequence = number;
+      }
+      else if (label.Is("TCP current window size is"))
+      {
+        record.window = number;
+      }
+      else if (label.Is("Workload id is"))
+      {
+        record.workload = number;
+      }
+      else if (label.Is("Application id is"))
+      {
+        record.application = number;
+      }
+      else if (label.Is("Message id is"))
+      {
+        record.message = number;
+        // The rest of the line is the optional header dump.
+        return ok && haveTimestamp && haveDelay;
+      }
+      else
+      {
+        return false;
+      }
+    }
+    if (!ok)
+    {
+      return false;
+    }
+  }
+  return false;
+}
+
+// The records of one piece of a file and the number of lines skipped.
+struct Piece
+{
+  const char *begin;
+  const char *end;
+  std::vector<PacketRecord> records;
+  uint64_t skipped;
+};
+
+static void ParsePiece(Piece &piece)
+{
+  piece.records.clear();
+  piece.skipped = 0;
+  const char *line = piece.begin;
+  while (line < piece.end)
+  {
+    const char *newline = static_cast<const char *>(std::memchr(line, '\n', piece.end - line));
+    const char *stop = newline ? newline : piece.end;
+    PacketRecord record;
+    if (ParseLine(line, stop, record))
+    {
+      piece.records.push_back(record);
+    }
+    else if (stop > line)
+    {
+      ++piece.skipped;
+    }
+    line = stop + 1;
+  }
+}
+
+// End of the piece starting at begin: about PIECE_SIZE bytes, extended to
+// the next line break.
+static const char *PieceEnd(const char *begin, const char *end)
+{
+  if (static_cast<size_t>(end - begin) <= PIECE_SIZE)
+  {
+    return end;
+  }
+  const char *newline = static_cast<const char *>(
+      std::memchr(begin + PIECE_SIZE, '\n', end - begin - PIECE_SIZE));
+  return newline ? newline + 1 : end;
+}
+
+// Convert one file, return the number of records written.
+static uint64_t Convert(const std::string &input, const std::string &basename,
+                        const std::string &traceformat, uint32_t threads)
+{
+  int fd = open(input.c_str(), O_RDONLY);
+  NS_ABORT_MSG_IF(fd < 0, "Unable to open " << input);
+  struct stat info;
+  NS_ABORT_MSG_IF(fstat(fd, &info) != 0, "Unable to stat " << input);
+  size_t length = info.st_size;
+  const char *data = 0;
+  if (length > 0)
+  {
+    void *map = mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    NS_ABORT_MSG_IF(map == MAP_FAILED, "Unable to map " << input);
+    madvise(map, length, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(map);
+  }
+  close(fd);
+
+  Ptr<TraceOutput> output =
+      CreateFileTraceOutput(basename, Create<PacketRecordFormat>(), traceformat);
+  std::vector<Piece> pieces(threads);
+  const char *pos = data;
+  const char *end = data + length;
+  uint64_t written = 0;
+  uint64_t skipped = 0;
+  while (pos < end)
+  {
+    // Parse up to one piece per thread, then write them in order.
+    uint32_t used = 0;
+    for (; used < threads && pos < end; ++used)
+    {
+      pieces[used].begin = pos;
+      pieces[used].end = pos = PieceEnd(pos, end);
+    }
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < used; ++i)
+    {
+      workers.emplace_back(&ParsePiece, std::ref(pieces[i]));
+    }
+    ParsePiece(pieces[0]);
+    for (std::thread &worker : workers)
+    {
+      worker.join();
+    }
+    for (uint32_t i = 0; i < used; ++i)
+    {
+      for (const PacketRecord &record : pieces[i].records)
+      {
+        output->Write(&record);
+      }
+      written += pieces[i].records.size();
+      skipped += pieces[i].skipped;
+    }
+  }
+  output->Close();
+  if (data)
+  {
+    munmap(const_cast<char *>(data), length);
+  }
+  if (skipped > 0)
+  {
+    std::cerr << "Skipped " << skipped << " lines of " << input
+              << " that are not packet lines." << std::endl;
+  }
+  return written;
+}
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string traceformat = "columnar";
+  uint32_t threads = 0;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Comma separated legacy csv packet logs.", input);
+  cmd.AddValue("output", "Basename of the output for a single input, the input without .csv if empty.", output);
+  cmd.AddValue("traceformat", "Layout to write (binary, compressed, columnar or csv).", traceformat);
+  cmd.AddValue("threads", "Parser threads, all cores if zero.", threads);
+  cmd.Parse(argc, argv);
+
+  std::vector<std::string> inputs = Split(input);
+  NS_ABORT_MSG_IF(inputs.empty(), "No input file given.");
+  NS_ABORT_MSG_IF(!output.empty() && inputs.size() > 1,
+                  "--output needs a single input.");
+  if (threads == 0)
+  {
+    threads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+  }
+
+  for (const std::string &file : inputs)
+  {
+    std::string basename = output;
+    if (basename.empty())
+    {
+      basename = file;
+      if (basename.size() > 4 && basename.compare(basename.size() - 4, 4, ".csv") == 0)
+      {
+        basename.resize(basename.size() - 4);
+      }
+    }
+    NS_ABORT_MSG_IF(traceformat == "csv" && basename + ".csv" == file,
+                    "Not overwriting the input " << file);
+    uint64_t records = Convert(file, basename, traceformat, threads);
+    std::cerr << "Converted " << records << " packets of " << file << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Split a multiplexed trace file written by a TraceRegistry into one
+// trace per stream, named <output><stream name>, e.g.
+//
+//   ./waf --run "ntt-trace-demux --input=results/switch_taps.ntx --output=results/ --traceformat=csv"
+//
+// writes results/switch_A_port1.csv and so on. With --stream, only the
+// streams of this comma separated list are written.
+
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/mux-trace.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TraceDemux");
+
+// Split a comma separated list.
+static std::vector<std::string> Split(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// Create the outputs of the streams declared since the last call; a null
+// output skips the stream.
+static void OpenStreams(const MuxTraceReader &reader, const std::string &output,
+                        const std::string &traceformat, const std::set<std::string> &selected,
+                        std::vector<Ptr<TraceOutput>> &outputs)
+{
+  while (outputs.size() < reader.GetNStreams())
+  {
+    uint16_t stream = outputs.size();
+    std::string name = reader.GetName(stream);
+    Ptr<TraceOutput> out;
+    if (selected.empty() || selected.count(name))
+    {
+      out = CreateFileTraceOutput(output + name, reader.GetFormat(stream), traceformat);
+    }
+    outputs.push_back(out);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string traceformat = "binary";
+  std::string stream;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Multiplexed trace file.", input);
+  cmd.AddValue("output", "Prefix of the outputs, e.g. a directory with a trailing slash.", output);
+  cmd.AddValue("traceformat", "Layout to write (csv, binary, compressed, columnar or mapped).", traceformat);
+  cmd.AddValue("stream", "Comma separated streams to write, all if empty.", stream);
+  cmd.Parse(argc, argv);
+
+  NS_ABORT_MSG_IF(input.empty(), "No input file given.");
+  std::vector<std::string> names = Split(stream);
+  std::set<std::string> selected(names.begin(), names.end());
+
+  MuxTraceReader reader(input);
+  std::vector<Ptr<TraceOutput>> outputs;
+  std::vector<uint64_t> counts(MUX_DECLARATION, 0);
+  uint16_t id;
+  while (reader.Next(id))
+  {
+    OpenStreams(reader, output, traceformat, selected, outputs);
+    if (outputs[id])
+    {
+      outputs[id]->Write(reader.GetRecord());
+      ++counts[id];
+    }
+  }
+  // Streams without records still get an (empty) output.
+  OpenStreams(reader, output, traceformat, selected, outputs);
+  for (uint16_t i = 0; i < outputs.size(); ++i)
+  {
+    if (outputs[i])
+    {
+      outputs[i]->Close();
+      std::cerr << reader.GetName(i) << ": " << counts[i] << " records" << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Merge trace shards that are each ordered by time, e.g. the per-receiver
+// logs of trafficgen with --shardreceivers=true, into one trace ordered by
+// time:
+//
+//   ./waf --run "ntt-trace-merge --input=shift_receiver1.bin,shift_receiver2.bin,shift_receiver3.bin --output=shift --traceformat=compressed"
+//
+// The shards may be binary, compressed or mapped traces of the same record
+// format. Records with the same timestamp are written in the order of the
+// inputs. Only one record per shard is held in memory, or one block of a
+// compressed shard.
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/block-trace.h"
+#include "ns3/mapped-trace.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TraceMerge");
+
+// Split a comma separated list.
+static std::vector<std::string> Split(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// Sequential reader of one shard, in any layout with a reader.
+class ShardReader
+{
+public:
+  ShardReader(std::string filename)
+      : m_filename(filename),
+        m_next(0),
+        m_offset(0)
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    NS_ABORT_MSG_UNLESS(file.is_open(), "Unable to open " << filename);
+    char magic[4] = {0};
+    file.read(magic, sizeof(magic));
+    if (std::memcmp(magic, "NTTB", 4) == 0)
+    {
+      m_blocks.reset(new BlockTraceReader(filename));
+      m_format = m_blocks->GetFormat();
+    }
+    else if (std::memcmp(magic, "NTTM", 4) == 0)
+    {
+      m_mapped.reset(new MappedTraceReader(filename));
+      m_format = m_mapped->GetFormat();
+    }
+    else
+    {
+      file.seekg(0);
+      TraceFileHeader header;
+      NS_ABORT_MSG_UNLESS(ReadTraceFileHeader(file, header),
+                          filename << " is not a binary, compressed or mapped trace file.");
+      m_format = CreateTraceFormat(header.format);
+      NS_ABORT_MSG_UNLESS(m_format && m_format->GetRecordSize() == header.recordSize,
+                          "Unknown record format " << header.format << " in " << filename);
+      m_file.swap(file);
+    }
+    m_record.resize(m_format->GetRecordSize());
+  }
+
+  Ptr<TraceFormat> GetFormat(void) const
+  {
+    return m_format;
+  }
+
+  const std::string &GetFilename(void) const
+  {
+    return m_filename;
+  }
+
+  // Read the next record, false at the end of the shard.
+  bool Next(void)
+  {
+    uint32_t size = m_record.size();
+    if (m_mapped)
+    {
+      if (m_next == m_mapped->GetNRecords())
+      {
+        return false;
+      }
+      std::memcpy(m_record.data(), m_mapped->GetRecord(m_next++), size);
+      return true;
+    }
+    if (m_blocks)
+    {
+      while (m_offset == m_block.size())
+      {
+        if (m_next == m_blocks->GetNBlocks())
+        {
+          return false;
+        }
+        m_blocks->ReadBlock(m_next++, m_block);
+        m_offset = 0;
+      }
+      std::memcpy(m_record.data(), &m_block[m_offset], size);
+      m_offset += size;
+      return true;
+    }
+    return static_cast<bool>(m_file.read(reinterpret_cast<char *>(m_record.data()), size));
+  }
+
+  const uint8_t *GetRecord(void) const
+  {
+    return m_record.data();
+  }
+
+private:
+  std::string m_filename;                      // Name of the shard
+  Ptr<TraceFormat> m_format;                   // Format of the records
+  std::ifstream m_file;                        // Binary shard
+  std::unique_ptr<MappedTraceReader> m_mapped; // Mapped shard
+  std::unique_ptr<BlockTraceReader> m_blocks;  // Compressed shard
+  uint64_t m_next;                             // Next record or block
+  std::vector<uint8_t> m_block;                // Current block
+  size_t m_offset;                             // Next record in the block
+  std::vector<uint8_t> m_record;               // Current record
+};
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string traceformat = "binary";
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Comma separated shards, each ordered by time.", input);
+  cmd.AddValue("output", "Basename of the merged trace.", output);
+  cmd.AddValue("traceformat", "Layout to write (csv, binary, compressed, columnar or mapped).", traceformat);
+  cmd.Parse(argc, argv);
+
+  std::vector<std::string> inputs = Split(input);
+  NS_ABORT_MSG_IF(inputs.empty(), "No input file given.");
+  NS_ABORT_MSG_IF(output.empty(), "No output given.");
+
+  std::vector<std::unique_ptr<ShardReader>> shards;
+  for (const std::string &file : inputs)
+  {
+    shards.emplace_back(new ShardReader(file));
+    NS_ABORT_MSG_UNLESS(shards.back()->GetFormat()->GetName() ==
+                            shards.front()->GetFormat()->GetName(),
+                        file << " has another record format than " << inputs.front());
+  }
+  Ptr<TraceFormat> format = shards.front()->GetFormat();
+  Ptr<TraceOutput> out = CreateFileTraceOutput(output, format, traceformat);
+
+  // Min-heap of the current timestamp of every shard, ties in input order.
+  typedef std::pair<uint64_t, uint32_t> Head;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  for (uint32_t i = 0; i < shards.size(); ++i)
+  {
+    if (shards[i]->Next())
+    {
+      heads.push(Head(format->GetTimestamp(shards[i]->GetRecord()), i));
+    }
+  }
+  uint64_t count = 0;
+  while (!heads.empty())
+  {
+    Head head = heads.top();
+    heads.pop();
+    ShardReader &shard = *shards[head.second];
+    out->Write(shard.GetRecord());
+    ++count;
+    if (shard.Next())
+    {
+      uint64_t timestamp = format->GetTimestamp(shard.GetRecord());
+      NS_ABORT_MSG_IF(timestamp < head.first,
+                      shard.GetFilename() << " is not ordered by time.");
+      heads.push(Head(timestamp, head.second));
+    }
+  }
+  out->Close();
+  std::cerr << "Merged " << count << " records of " << shards.size() << " shards." << std::endl;
+  return 0;
+}
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Print the records of a compressed trace (--traceformat=compressed) as
+// csv, optionally only a time range and/or one flow. Only the blocks whose
+// index matches are decompressed, e.g.
+//
+//   ./waf --run "ntt-trace-query --input=shift.ntz --start=20 --end=40"
+//   ./waf --run "ntt-trace-query --input=shift.ntz --destinationport=4200"
+
+#include <stdint.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/block-trace.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TraceQuery");
+
+// Fields of the flow to select, zero matches any value.
+struct FlowFilter
+{
+  uint32_t source;
+  uint32_t destination;
+  uint16_t sourcePort;
+  uint16_t destinationPort;
+  uint8_t protocol;
+
+  bool IsSet(void) const
+  {
+    return source || destination || sourcePort || destinationPort || protocol;
+  }
+
+  bool Matches(const TraceFlow &flow) const
+  {
+    return (!source || flow.source == source) &&
+           (!destination || flow.destination == destination) &&
+           (!sourcePort || flow.sourcePort == sourcePort) &&
+           (!destinationPort || flow.destinationPort == destinationPort) &&
+           (!protocol || flow.protocol == protocol);
+  }
+};
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  double start = -1;
+  double end = -1;
+  std::string source;
+  std::string destination;
+  uint32_t sourcePort = 0;
+  uint32_t destinationPort = 0;
+  uint32_t protocol = 0;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Compressed trace file.", input);
+  cmd.AddValue("output", "Csv file to write, stdout if empty.", output);
+  cmd.AddValue("start", "First simulation time in seconds, -1 for the start.", start);
+  cmd.AddValue("end", "Last simulation time in seconds, -1 for the end.", end);
+  cmd.AddValue("source", "Only this source IP.", source);
+  cmd.AddValue("destination", "Only this destination IP.", destination);
+  cmd.AddValue("sourceport", "Only this source port.", sourcePort);
+  cmd.AddValue("destinationport", "Only this destination port.", destinationPort);
+  cmd.AddValue("protocol", "Only this IP protocol number.", protocol);
+  cmd.Parse(argc, argv);
+
+  NS_ABORT_MSG_IF(input.empty(), "No input file given.");
+  BlockTraceReader reader(input);
+  Ptr<TraceFormat> format = reader.GetFormat();
+
+  uint64_t first = start < 0 ? 0 : Seconds(start).GetNanoSeconds();
+  uint64_t last = end < 0 ? UINT64_MAX : Seconds(end).GetNanoSeconds();
+  FlowFilter filter;
+  filter.source = source.empty() ? 0 : Ipv4Address(source.c_str()).Get();
+  filter.destination = destination.empty() ? 0 : Ipv4Address(destination.c_str()).Get();
+  filter.sourcePort = sourcePort;
+  filter.destinationPort = destinationPort;
+  filter.protocol = protocol;
+
+  std::ofstream out;
+  if (!output.empty())
+  {
+    out.open(output.c_str());
+    NS_ABORT_MSG_UNLESS(out.is_open(), "Unable to open " << output);
+  }
+  std::ostream &os = output.empty() ? std::cout : out;
+
+  format->PrintCsvSchema(os);
+  uint32_t recordSize = format->GetRecordSize();
+  std::vector<uint8_t> records;
+  uint32_t blocks = 0;
+  uint64_t count = 0;
+  for (uint32_t i : reader.FindBlocks(first, last))
+  {
+    if (filter.IsSet())
+    {
+      bool found = false;
+      for (const TraceFlow &flow : reader.GetBlock(i).flows)
+      {
+        found = found || filter.Matches(flow);
+      }
+      if (!found)
+      {
+        continue;
+      }
+    }
+    reader.ReadBlock(i, records);
+    ++blocks;
+    for (size_t offset = 0; offset + recordSize <= records.size(); offset += recordSize)
+    {
+      const uint8_t *record = records.data() + offset;
+      uint64_t timestamp = format->GetTimestamp(record);
+      TraceFlow flow;
+      if (timestamp < first || timestamp > last ||
+          (filter.IsSet() && !(format->GetFlow(record, flow) && filter.Matches(flow))))
+      {
+        continue;
+      }
+      format->PrintCsv(os, record);
+      ++count;
+    }
+  }
+  std::cerr << "Read " << blocks << " of " << reader.GetNBlocks() << " blocks, "
+            << count << " records match." << std::endl;
+  return 0;
+}
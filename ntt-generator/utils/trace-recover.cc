@@ -0,0 +1,63 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Read a mapped trace file written with --traceformat=mapped, also of a
+// run that was killed, and write its committed records in another layout,
+// e.g.
+//
+//   ./waf --run "ntt-trace-recover --input=shift.ntm --output=shift --traceformat=columnar"
+
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+#include "ns3/mapped-trace.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TraceRecover");
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string traceformat = "binary";
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Mapped trace file.", input);
+  cmd.AddValue("output", "Basename of the output.", output);
+  cmd.AddValue("traceformat", "Layout to write (csv, binary, compressed or columnar).", traceformat);
+  cmd.Parse(argc, argv);
+
+  NS_ABORT_MSG_IF(input.empty(), "No input file given.");
+  NS_ABORT_MSG_IF(output.empty(), "No output given.");
+  NS_ABORT_MSG_IF(traceformat == "mapped", "Recovering into a mapped trace is not supported.");
+
+  MappedTraceReader reader(input);
+  Ptr<TraceOutput> out = CreateFileTraceOutput(output, reader.GetFormat(), traceformat);
+  for (uint64_t i = 0; i < reader.GetNRecords(); ++i)
+  {
+    out->Write(reader.GetRecord(i));
+  }
+  out->Close();
+  if (!reader.IsClosed())
+  {
+    std::cerr << input << " was not closed, the run ended early." << std::endl;
+  }
+  std::cerr << "Recovered " << reader.GetNRecords() << " records." << std::endl;
+  return 0;
+}
@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Convert a binary trace file written with --traceformat=binary back to
+// the csv written by the simulations, e.g.
+//
+//   ./waf --run "ntt-trace-to-csv --input=shift.bin --output=shift.csv"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/trace-record.h"
+#include "ns3/trace-output.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TraceToCsv");
+
+int main(int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Binary trace file.", input);
+  cmd.AddValue("output", "Csv file to write, stdout if empty.", output);
+  cmd.Parse(argc, argv);
+
+  NS_ABORT_MSG_IF(input.empty(), "No input file given.");
+  std::ifstream in(input.c_str(), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_UNLESS(in.is_open(), "Unable to open " << input);
+
+  TraceFileHeader header;
+  NS_ABORT_MSG_UNLESS(ReadTraceFileHeader(in, header),
+                      input << " is not a trace file of this version.");
+  Ptr<TraceFormat> format = CreateTraceFormat(header.format);
+  NS_ABORT_MSG_UNLESS(format, "Unknown record format " << header.format);
+  NS_ABORT_MSG_UNLESS(format->GetRecordSize() == header.recordSize,
+                      "Record size of " << input << " does not match format "
+                                        << header.format);
+
+  std::ofstream out;
+  if (!output.empty())
+  {
+    out.open(output.c_str());
+    NS_ABORT_MSG_UNLESS(out.is_open(), "Unable to open " << output);
+  }
+  std::ostream &os = output.empty() ? std::cout : out;
+
+  format->PrintCsvSchema(os);
+  std::vector<uint8_t> record(header.recordSize);
+  uint64_t count = 0;
+  while (in.read(reinterpret_cast<char *>(record.data()), record.size()))
+  {
+    format->PrintCsv(os, record.data());
+    ++count;
+  }
+  if (in.gcount() != 0)
+  {
+    std::cerr << "Ignoring truncated record at the end of " << input << std::endl;
+  }
+  std::cerr << "Converted " << count << " records." << std::endl;
+  return 0;
+}
@@ -0,0 +1,274 @@
+# Read the csv traces by their schema block, the columnar traces written
+# with --traceformat=columnar (.ntc), the
+# queue traces written with --queuechanges=true (.ntq) or --queuesample
+# (.npy), the delay histograms written with --delayhistogram=true (.ntd)
+# and the training sequences written with --sequencelength (.npy shards).
+#
+# Only the requested columns are decoded, the others are skipped, e.g.
+#
+#   frame = read_columnar("results/shift.ntc", ["timestamp", "size", "delay"])
+#
+# Times and delays are in nanoseconds, IP addresses are integers.
+
+import glob
+import struct
+
+import numpy as np
+import pandas as pd
+
+HEADER = struct.Struct("<4sHH24s")
+VERSION = 2
+# Delay histograms have their own version, see delay-histogram.h.
+HISTOGRAM_VERSION = 2
+
+PLAIN, DELTA, DICTIONARY = 0, 1, 2
+
+DTYPES = {
+    (1, False): np.uint8, (2, False): np.uint16,
+    (4, False): np.uint32, (8, False): np.uint64,
+    (1, True): np.int8, (2, True): np.int16,
+    (4, True): np.int32, (8, True): np.int64,
+}
+
+
+CSV_SCHEMA = "# ntt-trace-schema"
+CSV_SCHEMA_VERSION = 1
+
+CSV_DTYPES = {
+    "u1": "UInt8", "u2": "UInt16", "u4": "UInt32", "u8": "UInt64",
+    "i8": "Int64", "f8": "float64", "ip": str, "str": str,
+}
+
+
+def read_csv_schema(f):
+    """Read the schema block of a csv trace, as the format name and a list
+    of (name, type, unit)."""
+    line = f.readline()
+    if not line.startswith(CSV_SCHEMA + " "):
+        raise ValueError("csv trace without schema")
+    version, name = line[len(CSV_SCHEMA):].split()
+    version = int(version)
+    if version > CSV_SCHEMA_VERSION:
+        raise ValueError("csv schema version {} is newer than {}".format(version, CSV_SCHEMA_VERSION))
+    types = f.readline().rstrip("\n")[len("# types "):].split(",")
+    units = f.readline().rstrip("\n")[len("# units "):].split(",")
+    names = f.readline().rstrip("\n").split(",")
+    if not len(names) == len(types) == len(units):
+        raise ValueError("inconsistent csv schema")
+    return name, list(zip(names, types, units))
+
+
+def read_trace_csv(path, columns=None):
+    """Read a csv trace into a DataFrame with the columns named and typed by
+    its schema, all columns if None. Empty fields, e.g. the TCP fields of
+    UDP packets, are missing values."""
+    with open(path) as f:
+        _, schema = read_csv_schema(f)
+        return pd.read_csv(
+            f, header=None, names=[name for name, _, _ in schema],
+            usecols=columns, keep_default_na=False, na_values=[""],
+            dtype={name: CSV_DTYPES[kind] for name, kind, _ in schema})
+
+
+def merge_shards(paths, columns=None):
+    """Read trace shards that are each ordered by time, csv or columnar, and
+    merge them into one DataFrame ordered by timestamp. Rows with the same
+    timestamp keep the order of `paths`."""
+    if columns is not None and "timestamp" not in columns:
+        columns = ["timestamp"] + list(columns)
+    frames = [read_columnar(path, columns) if path.endswith(".ntc")
+              else read_trace_csv(path, columns) for path in paths]
+    merged = pd.concat(frames, ignore_index=True)
+    return merged.sort_values("timestamp", kind="mergesort", ignore_index=True)
+
+
+def read_schema(f):
+    """Read the file header and the columns, as a list of (name, dtype)."""
+    magic, version, _, fmt = HEADER.unpack(f.read(HEADER.size))
+    if magic != b"NTTC" or version != VERSION:
+        raise ValueError("not a columnar trace file of version {}".format(VERSION))
+    (ncols,) = struct.unpack("<H", f.read(2))
+    columns = []
+    for _ in range(ncols):
+        (length,) = struct.unpack("<B", f.read(1))
+        name = f.read(length).decode()
+        size, signed = struct.unpack("<BB", f.read(2))
+        columns.append((name, np.dtype(DTYPES[(size, bool(signed))]).newbyteorder("<")))
+    return fmt.rstrip(b"\0").decode(), columns
+
+
+def decode(data, encoding, rows, dtype):
+    """Decode one column of a chunk."""
+    if encoding == PLAIN:
+        return np.frombuffer(data, dtype, rows)
+    if encoding == DELTA:
+        first, width = struct.unpack_from("<qB", data)
+        zigzag = np.frombuffer(data, "<u{}".format(width), rows, 9).astype(np.uint64)
+        deltas = (zigzag >> np.uint64(1)).astype(np.int64) ^ -(zigzag & np.uint64(1)).astype(np.int64)
+        deltas[0] = first
+        return np.cumsum(deltas).astype(dtype)
+    if encoding == DICTIONARY:
+        (count,) = struct.unpack_from("<I", data)
+        values = np.frombuffer(data, dtype, count, 4)
+        offset = 4 + count * dtype.itemsize
+        width = data[offset]
+        return values[np.frombuffer(data, "<u{}".format(width), rows, offset + 1)]
+    raise ValueError("unknown column encoding {}".format(encoding))
+
+
+def read_columnar(path, columns=None):
+    """Read a columnar trace into a DataFrame, all columns if None."""
+    with open(path, "rb") as f:
+        _, schema = read_schema(f)
+        names = [name for name, _ in schema]
+        wanted = names if columns is None else list(columns)
+        for name in wanted:
+            if name not in names:
+                raise KeyError("no column {} in {}".format(name, path))
+        chunks = {name: [] for name in wanted}
+        while True:
+            head = f.read(4)
+            if len(head) < 4:
+                break
+            (rows,) = struct.unpack("<I", head)
+            directory = [struct.unpack("<BI", f.read(5)) for _ in schema]
+            for (name, dtype), (encoding, length) in zip(schema, directory):
+                if name in chunks:
+                    chunks[name].append(decode(f.read(length), encoding, rows, dtype))
+                else:
+                    f.seek(length, 1)
+    return pd.DataFrame({
+        name: np.concatenate(parts) if parts else np.array([], dtype=dtype)
+        for (name, dtype) in schema if name in chunks
+        for parts in [chunks[name]]
+    })[wanted]
+
+
+QUEUE_PATH = "/NodeList/{}/DeviceList/{}/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue"
+
+
+def read_varint(data, offset):
+    """Decode a LEB128 varint, return it and the offset after it."""
+    value = shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7f) << shift
+        if byte < 0x80:
+            return value, offset
+        shift += 7
+
+
+def read_queue_changes(path):
+    """Read a queue change trace (.ntq) into a DataFrame with the columns
+    of queue.csv: source (the trace path), time in seconds and size."""
+    with open(path, "rb") as f:
+        magic, version, _, _ = HEADER.unpack(f.read(HEADER.size))
+        if magic != b"NTTQ" or version != VERSION:
+            raise ValueError("not a queue change file of version {}".format(VERSION))
+        (window,) = struct.unpack("<Q", f.read(8))
+        data = f.read()
+    window = max(window, 1)
+    ports, values = [], []
+    sources, times, sizes = [], [], []
+    tick = 0
+    offset = 0
+    while offset < len(data):
+        kind, offset = read_varint(data, offset)
+        if kind == 0:
+            node, offset = read_varint(data, offset)
+            device, offset = read_varint(data, offset)
+            ports.append(QUEUE_PATH.format(node, device))
+            values.append(0)
+            continue
+        ticks, offset = read_varint(data, offset)
+        count, offset = read_varint(data, offset)
+        tick += ticks
+        for _ in range(count):
+            port, offset = read_varint(data, offset)
+            delta, offset = read_varint(data, offset)
+            values[port] += (delta >> 1) ^ -(delta & 1)
+            sources.append(ports[port])
+            times.append(tick)
+            sizes.append(values[port])
+    return pd.DataFrame({
+        "source": sources,
+        "time": np.array(times, dtype=np.float64) * window / 1e9,
+        "size": sizes,
+    })
+
+
+def read_queue_samples(path):
+    """Read the queue samples (.npy) written with --queuesample into a
+    DataFrame with the columns of queue.csv, one row per queue and sample.
+    numpy.load(path) returns the samples as one row per sample instead."""
+    samples = np.load(path)
+    queues = [name for name in samples.dtype.names if name != "time"]
+    return pd.DataFrame({
+        "source": np.repeat(queues, len(samples)),
+        "time": np.tile(samples["time"], len(queues)),
+        "size": np.concatenate([samples[name] for name in queues]) if queues else [],
+    })
+
+
+def bucket_start(bucket, bits):
+    """Smallest value counted by a histogram bucket."""
+    bucket = np.asarray(bucket, dtype=np.uint64)
+    sub = np.uint64(1 << bits)
+    shift = np.where(bucket < 2 * sub, np.uint64(0), bucket // sub - np.uint64(1))
+    return (bucket - shift * sub) << shift, np.uint64(1) << shift
+
+
+def read_delay_histograms(path):
+    """Read delay histograms (.ntd) into a DataFrame with one row per used
+    bucket: workload, application, receiver, delay (the middle of the
+    bucket, in nanoseconds) and count."""
+    with open(path, "rb") as f:
+        magic, version, _, _ = HEADER.unpack(f.read(HEADER.size))
+        if magic != b"NTTH" or version != HISTOGRAM_VERSION:
+            raise ValueError("not a delay histogram file of version {}".format(HISTOGRAM_VERSION))
+        bits = f.read(1)[0]
+        data = f.read()
+    rows = []
+    offset = 0
+    while offset < len(data):
+        key = []
+        for _ in range(3):
+            value, offset = read_varint(data, offset)
+            key.append(value)
+        fields = []
+        for _ in range(5):  # count, min, max, sum, used buckets
+            value, offset = read_varint(data, offset)
+            fields.append(value)
+        bucket = 0
+        for _ in range(fields[4]):
+            delta, offset = read_varint(data, offset)
+            count, offset = read_varint(data, offset)
+            bucket += delta
+            rows.append(key + [bucket, count])
+    frame = pd.DataFrame(rows, columns=["workload", "application", "receiver", "bucket", "count"])
+    start, width = bucket_start(frame["bucket"].to_numpy(), bits)
+    frame["delay"] = start + width // np.uint64(2)
+    return frame[["workload", "application", "receiver", "delay", "count"]]
+
+
+def histogram_quantiles(frame, quantiles=(0.5, 0.99)):
+    """Quantiles of the delays of histogram rows from read_delay_histograms,
+    e.g. of one group of them."""
+    merged = frame.groupby("delay")["count"].sum().sort_index()
+    ranks = np.cumsum(merged.to_numpy())
+    return pd.Series({
+        q: merged.index[np.searchsorted(ranks, max(1, np.ceil(q * ranks[-1])))]
+        for q in quantiles
+    })
+
+
+SEQUENCE_FEATURES = ["timestamp", "size", "delay", "workload", "application", "message"]
+
+
+def load_sequence_shards(basename, mmap_mode="r"):
+    """Memory-map the training sequence shards `basename`_<index>.npy in
+    order. Each is an array of shape (sequences, length, features), the
+    features are SEQUENCE_FEATURES with times in seconds."""
+    return [np.load(path, mmap_mode=mmap_mode)
+            for path in sorted(glob.glob(glob.escape(basename) + "_[0-9]*.npy"))]
@@ -47,6 +47,8 @@
 
 #include "ns3/cdf-application.h"
 #include "ns3/experiment-tags.h"
+#include "ns3/cdf-table.h"
+#include "ns3/trace-helpers.h"
 
 using namespace ns3;
 
@@ -60,7 +62,7 @@ void logSize(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
 {
     auto current_time = Simulator::Now();
     *stream->GetStream() << current_time.GetSeconds() << ','
-                         << p->GetSize() << std::endl;
+                         << p->GetSize() << "\n";
 }
 
 // Tag a packet with a timestamp.
@@ -79,76 +81,6 @@ void setIdTag(u_int32_t workload_id, u_int32_t app_id, Ptr<Packet const> p)
     p->AddPacketTag(tag);
 };
 
-// Log workload tag, timestamp tag, and packet size.
-void logPacketInfo(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
-{
-    TimestampTag timestampTag;
-    IdTag idTag;
-    FlowIdTag flowid;
-    MessageTag mTag;
-    p->PeekPacketTag(mTag);
-    
-    if (p->PeekPacketTag(timestampTag) && p->PeekPacketTag(idTag))
-    {
-        auto current_time = Simulator::Now();
-        auto diff_time = current_time - timestampTag.GetTime();
-        *stream->GetStream() << "Tx sent at:, "<< current_time.GetSeconds()<< ", ";
-        *stream->GetStream() << "Flow id is, "<< p->PeekPacketTag(flowid) << ", "
-                             << "Packet uid is, "<< p->GetUid() << ", "
-                             << "Packet size is, "<< p->GetSize() << ", ";
-                             
-        Ptr<Packet> copy = p->Copy();
-        // Headers must be removed in the order they're present.
-        EthernetHeader eHeader;
-        copy->RemoveHeader(eHeader);
-        Ipv4Header ipHeader;
-        copy->RemoveHeader(ipHeader);
-        *stream->GetStream() << "IP ID is, "<< ipHeader.GetIdentification() << ", "
-                                << "DSCP is, "<< ipHeader.GetDscp() << ", "
-                                << "ECN is, "<< ipHeader.GetEcn() << ", "
-                                << "TTL is, "<< 64 << ", "
-                                << "Payload size is, "<< ipHeader.GetPayloadSize() << ", "
-                                << "Protocol is, "<< 6 << ", "
-                                << "Source IP is, "<< ipHeader.GetSource() << ", "
-                                << "Destination IP is, "<< ipHeader.GetDestination() << ", ";
-        TcpHeader tcpHeader;
-        copy->RemoveHeader(tcpHeader);
-        *stream->GetStream() << "TCP source port is, "<< tcpHeader.GetSourcePort() << ", "
-                             << "TCP destination port is, "<< tcpHeader.GetDestinationPort() << ", "
-                             << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", "
-                             << "TCP current window size is, "<< tcpHeader.GetWindowSize() << ", "
-                             << "Delay is, "<< diff_time.GetSeconds() << ", "
-                             << "Workload id is, "<< idTag.GetWorkload() << ','
-                             << "Application id is, "<< idTag.GetApplication() << ','
-                             << "Message id is, "<< mTag.GetSimpleValue() << ',';
-
-        copy->Print(*stream->GetStream());
-        *stream->GetStream() << "\n";
-
-    }
-    else
-    {
-        //NS_LOG_DEBUG("Packet without timestamp, won't log.");
-    };
-};
-
-void logValue(Ptr<OutputStreamWrapper> stream, std::string context,
-              uint32_t oldval, uint32_t newval)
-{
-    auto current_time = Simulator::Now();
-    *stream->GetStream() << context << ',' << current_time.GetSeconds() << ','
-                         << newval << std::endl;
-}
-
-void logDrop(Ptr<OutputStreamWrapper> stream,
-             std::string context, Ptr<Packet const> p)
-{
-    auto current_time = Simulator::Now();
-    *stream->GetStream() << context << ',' << current_time.GetSeconds() << ','
-                         << p->GetSize() << std::endl;
-};
-
-
 // TODO: Add base stream? Or how to get different random streams?
 Ptr<RandomVariableStream> TimeStream(double min = 0.0, double max = 1.0)
 {
@@ -208,7 +140,29 @@ int main(int argc, char *argv[])
     std::string w1 = basedir + "Facebook_WebServerDist_IntraCluster.txt";
     std::string w2 = basedir + "DCTCP_MsgSizeDist.txt";
     std::string w3 = basedir + "Facebook_HadoopDist_All.txt";
+    bool compiledcdf = false;
     std::string prefix = "shift";
+    std::string traceformat = "csv";
+    bool asynctrace = false;
+    // Dump the headers of Packet::Print into the csv logs, which needs
+    // packet metadata.
+    bool printHeaders = false;
+    // Sampling policy of the packet and drop logs, see TraceSampler.
+    std::string tracesample = "";
+    bool queuechanges = false;
+    Time queuewindow("0ms");
+    Time queuesample("0ms");
+    std::string queuesamplepath = "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue";
+    bool messagetrace = false;
+    bool droppackets = false;
+    bool delayhistogram = false;
+    Time flowwindow("0ms");
+    Time flowstep("0ms");
+    uint32_t sequencelength = 0;
+    uint32_t sequencestride = 1;
+    uint32_t sequenceshard = 4096;
+    bool packettrace = true;
+    bool shardreceivers = false;
     double c_w1 = 1;
     double c_w2 = 1;
     double c_w3 = 1;
@@ -230,9 +184,43 @@ int main(int argc, char *argv[])
     cmd.AddValue("congestion2", "Congestion traffic rate.", congestion2);
     cmd.AddValue("congestion3", "Congestion traffic rate.", congestion3);
     cmd.AddValue("prefix", "Prefix for log files.", prefix);
+    cmd.AddValue("traceformat", "Format of the logs (csv, binary, compressed, columnar or mapped).", traceformat);
+    cmd.AddValue("asynctrace", "Write the logs on background threads, one per log.", asynctrace);
+    cmd.AddValue("queuechanges", "Log only the changes of the queue occupancy (.ntq).", queuechanges);
+    cmd.AddValue("queuewindow", "Coalesce the queue changes over this window.", queuewindow);
+    cmd.AddValue("queuesample", "Sample the queues at this interval (.npy) instead of logging every change, 0 to disable.", queuesample);
+    cmd.AddValue("queuesamplepath", "Config path of the sampled queues.", queuesamplepath);
+    cmd.AddValue("messagetrace", "Log one record per completed message with its completion time.", messagetrace);
+    cmd.AddValue("droppackets", "Also log the dropped packets with their tags and 5-tuple, keyed by port id (drops_packets, with the ports in drops_packets_ports.csv).", droppackets);
+    cmd.AddValue("compiledcdf", "Map the distributions compiled by ntt-cdf-compile (.cdfb instead of .txt) instead of parsing them.", compiledcdf);
+    cmd.AddValue("delayhistogram", "Write mergeable histograms of the delay per workload, application and receiver (.ntd).", delayhistogram);
+    cmd.AddValue("flowwindow", "Log per-flow packets, bytes, delays and messages over windows of this length, 0 to disable.", flowwindow);
+    cmd.AddValue("flowstep", "Start a flow window every flowstep, a divisor of flowwindow, 0 for back-to-back windows.", flowstep);
+    cmd.AddValue("sequencelength", "Export sliding sequences of this many packets for training (.npy shards), 0 to disable.", sequencelength);
+    cmd.AddValue("sequencestride", "Packets between the starts of two exported sequences.", sequencestride);
+    cmd.AddValue("sequenceshard", "Exported sequences per .npy shard.", sequenceshard);
+    cmd.AddValue("shardreceivers", "Log the packets of every receiver to its own file (_receiver<i>) instead of one shared log.", shardreceivers);
+    cmd.AddValue("packettrace", "Log every packet at the receivers, disable if only the messages are needed.", packettrace);
+    cmd.AddValue("printheaders", "Enable packet metadata and dump the headers in the csv logs.", printHeaders);
+    cmd.AddValue("tracesample", "Sample the packet and drop logs, e.g. \"time=20s-40s,flows=4,every=10\" or \"delay=p99\", see TraceSampler.", tracesample);
     cmd.AddValue("seed", "Set simulation seed", seed);
     cmd.Parse(argc, argv);
 
+    // Compiled distributions are set with their own attribute.
+    std::string cdfAttribute = "CdfFile";
+    if (compiledcdf)
+    {
+        cdfAttribute = "CompiledCdfFile";
+        w1 = CdfTable::GetCompiledName(w1);
+        w2 = CdfTable::GetCompiledName(w2);
+        w3 = CdfTable::GetCompiledName(w3);
+    }
+
+    if (printHeaders)
+    {
+        Packet::EnablePrinting();
+    }
+
     // Compute resulting workload datarates.
     auto rate_w1 = DataRate(static_cast<uint64_t>(c_w1 * baserate.GetBitRate()));
     auto rate_w2 = DataRate(static_cast<uint64_t>(c_w2 * baserate.GetBitRate()));
@@ -476,7 +464,7 @@ int main(int argc, char *argv[])
             auto _id = i_app;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(trafficStart1->GetValue())),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -488,7 +476,7 @@ int main(int argc, char *argv[])
             auto _id = i_app + n_apps;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(trafficStart1->GetValue())),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -500,7 +488,7 @@ int main(int argc, char *argv[])
             auto _id = i_app + (2 * n_apps);
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(trafficStart1->GetValue())),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -560,7 +548,7 @@ int main(int argc, char *argv[])
             auto _id = i_app;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(trafficStart2->GetValue())),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -572,7 +560,7 @@ int main(int argc, char *argv[])
             auto _id = i_app + n_apps;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(trafficStart2->GetValue())),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -584,7 +572,7 @@ int main(int argc, char *argv[])
             auto _id = i_app + (2 * n_apps);
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(trafficStart2->GetValue())),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -643,7 +631,7 @@ int main(int argc, char *argv[])
             auto _id = i_app;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(trafficStart3->GetValue())),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -655,7 +643,7 @@ int main(int argc, char *argv[])
             auto _id = i_app + n_apps;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(trafficStart3->GetValue())),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -667,7 +655,7 @@ int main(int argc, char *argv[])
             auto _id = i_app + (2 * n_apps);
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(trafficStart3->GetValue())),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -702,13 +690,14 @@ int main(int argc, char *argv[])
     }
 
     NS_LOG_INFO("Install Tracing");
-    AsciiTraceHelper asciiTraceHelper;
 
     // Log (one-way) delay from sender to receiver (excludes other sources).
-    std::stringstream trackfilename;
-    // trackfilename << prefix << "_delays.csv";
-    trackfilename << prefix << ".csv"; // only one file for now.
-    auto trackfile = asciiTraceHelper.CreateFileStream(trackfilename.str());
+    // Only one file for all receivers for now.
+    TraceLogHelper logs;
+    logs.SetFormat(traceformat);
+    logs.SetAsync(asynctrace);
+    logs.SetSample(tracesample);
+    logs.SetPrintHeaders(printHeaders);
 
     for (auto it = senders.Begin(); it != senders.End(); it++)
     {
@@ -719,25 +708,92 @@ int main(int argc, char *argv[])
     /*sender->GetDevice(0)->TraceConnectWithoutContext(
         "MacTx", MakeCallback(&setTimeTag));*/
 
-    receiver1->GetDevice(0)->TraceConnectWithoutContext(
-        "MacRx", MakeBoundCallback(&logPacketInfo, trackfile));
-    receiver2->GetDevice(0)->TraceConnectWithoutContext(
-        "MacRx", MakeBoundCallback(&logPacketInfo, trackfile));
-    receiver3->GetDevice(0)->TraceConnectWithoutContext(
-        "MacRx", MakeBoundCallback(&logPacketInfo, trackfile));
+    if (packettrace)
+    {
+        if (shardreceivers)
+        {
+            // One shard per receiver, each already ordered by time; merge
+            // them with ntt-trace-merge when one stream is needed.
+            NodeContainer receivers(receiver1, receiver2, receiver3);
+            for (uint32_t i = 0; i < receivers.GetN(); ++i)
+            {
+                std::stringstream shard;
+                shard << prefix << "_receiver" << i + 1;
+                receivers.Get(i)->GetDevice(0)->TraceConnectWithoutContext(
+                    "MacRx", logs.PacketLog(shard.str()));
+            }
+        }
+        else
+        {
+            auto trackcallback = logs.PacketLog(prefix);
+            receiver1->GetDevice(0)->TraceConnectWithoutContext(
+                "MacRx", trackcallback);
+            receiver2->GetDevice(0)->TraceConnectWithoutContext(
+                "MacRx", trackcallback);
+            receiver3->GetDevice(0)->TraceConnectWithoutContext(
+                "MacRx", trackcallback);
+        }
+    }
+
+    // Per-flow aggregates, written as the windows end.
+    if (!flowwindow.IsZero())
+    {
+        logs.ConnectFlowWindowLog(prefix + "_flows", flowwindow, flowstep,
+                                  NodeContainer(receiver1, receiver2, receiver3));
+    }
+
+    // Training sequences, sharded as they are cut.
+    if (sequencelength > 0)
+    {
+        logs.ConnectSequenceExport(prefix + "_sequences", sequencelength, sequencestride, sequenceshard,
+                                   NodeContainer(receiver1, receiver2, receiver3));
+    }
+
+    // Delay histograms, written at the end of the run.
+    Ptr<DelayHistogramSet> histograms;
+    if (delayhistogram)
+    {
+        histograms = Create<DelayHistogramSet>();
+        TraceLogHelper::ConnectDelayHistograms(
+            histograms, NodeContainer(receiver1, receiver2, receiver3));
+    }
+
+    // Message completion times, from the messages handed to the sockets
+    // and the bytes delivered at the receivers.
+    Ptr<MessageTracker> messages;
+    if (messagetrace)
+    {
+        messages = logs.StartMessageTracker(prefix + "_messages",
+                                            NodeContainer(receiver1, receiver2, receiver3));
+    }
 
     //csma.EnablePcapAll("csma-bridge", false);
 
     // Track queues
-    auto queuefile = asciiTraceHelper.CreateFileStream("results/queue.csv");
-    Config::Connect(
-        "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue",
-        MakeBoundCallback(&logValue, queuefile));
+    if (!queuesample.IsZero())
+    {
+        logs.StartQueueSampler("results/queue_samples", queuesample, queuesamplepath);
+    }
+    else if (queuechanges)
+    {
+        logs.ConnectQueueChangeLog("results/queue", queuewindow);
+    }
+    else
+    {
+        auto queuelog = logs.QueueLog("results/queue");
+        Config::Connect(
+            "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue",
+            queuelog);
+    }
 
-    auto dropfile = asciiTraceHelper.CreateFileStream("results/drops.csv");
+    auto droplog = logs.DropLog("results/drops");
     Config::Connect(
         "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/MacTxDrop",
-        MakeBoundCallback(&logDrop, dropfile));
+        droplog);
+    if (droppackets)
+    {
+        logs.ConnectDropPacketLog("results/drops_packets");
+    }
 
 
 
@@ -749,6 +805,18 @@ int main(int argc, char *argv[])
     NS_LOG_INFO("Run Simulation.");
     Simulator::Stop(stopTime);
     Simulator::Run();
+    ReportBacklogs(std::cout);
+    if (histograms)
+    {
+        histograms->Write(prefix + "_delay.ntd");
+    }
+    if (messages)
+    {
+        messages->Close();
+        std::cout << "Completed " << messages->GetCompleted() << " messages, "
+                  << messages->GetIncomplete() << " incomplete." << std::endl;
+    }
+    logs.Close(std::cout);
     Simulator::Destroy();
     NS_LOG_INFO("Done.");
 
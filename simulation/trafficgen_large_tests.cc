@@ -47,6 +47,12 @@
 
 #include "ns3/cdf-application.h"
 #include "ns3/experiment-tags.h"
+#include "ns3/cdf-table.h"
+#include "ns3/trace-record.h"
+#include "ns3/packet-header-view.h"
+#include "ns3/trace-helpers.h"
+#include "ns3/mux-trace.h"
+#include "ns3/trace-registry.h"
 
 using namespace ns3;
 
@@ -60,7 +66,7 @@ void logSize(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
 {
     auto current_time = Simulator::Now();
     *stream->GetStream() << current_time.GetSeconds() << ','
-                         << p->GetSize() << std::endl;
+                         << p->GetSize() << "\n";
 }
 
 // Tag a packet with a timestamp.
@@ -79,115 +85,30 @@ void setIdTag(u_int32_t workload_id, u_int32_t app_id, Ptr<Packet const> p)
     p->AddPacketTag(tag);
 };
 
-void logSenderPacket(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
+// Log a packet sent by `node` as one csv row of SenderRecordFormat.
+void logSenderPacket(Ptr<OutputStreamWrapper> stream, uint32_t node, Ptr<Packet const> p)
 {
     TimestampTag timestampTag;
-
-    if (p->PeekPacketTag(timestampTag)){
-
-        Ptr<Packet> copy = p->Copy();
-        EthernetHeader eHeader;
-        copy->RemoveHeader(eHeader);
-        Ipv4Header ipHeader;
-        copy->RemoveHeader(ipHeader);
-        TcpHeader tcpHeader;
-        copy->RemoveHeader(tcpHeader);
-
-        auto sender_time = timestampTag.GetTime();
-        *stream->GetStream() << "Tx sent at:, "<< sender_time.GetSeconds()<< ", ";
-        *stream->GetStream() << "Packet size is, "<< p->GetSize() << ", ";
-        *stream->GetStream() << "Packet uid is, "<< p->GetUid() << ", ";
-        // Add TCP sequence number to track the packet
-        *stream->GetStream() << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", ";
-        *stream->GetStream() << "\n";
-    }
-    else
+    if (!p->PeekPacketTag(timestampTag))
     {
         NS_LOG_DEBUG("Packet without timestamp, won't log.");
-    };
-
-}
-
-// Log workload tag, timestamp tag, and packet size.
-void logPacketInfo(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
-{
-    TimestampTag timestampTag;
-    IdTag idTag;
-    FlowIdTag flowid;
-    MessageTag mTag;
-    p->PeekPacketTag(mTag);
-    
-    if (p->PeekPacketTag(timestampTag) && p->PeekPacketTag(idTag))
-    {
-        auto current_time = Simulator::Now();
-        auto diff_time = current_time - timestampTag.GetTime();
-        *stream->GetStream() << "Tx sent at:, "<< current_time.GetSeconds()<< ", ";
-        *stream->GetStream() << "Flow id is, "<< p->PeekPacketTag(flowid) << ", "
-                             << "Packet uid is, "<< p->GetUid() << ", "
-                             << "Packet size is, "<< p->GetSize() << ", ";
-                             
-        Ptr<Packet> copy = p->Copy();
-        // Headers must be removed in the order they're present.
-        EthernetHeader eHeader;
-        copy->RemoveHeader(eHeader);
-        Ipv4Header ipHeader;
-        copy->RemoveHeader(ipHeader);
-        *stream->GetStream() << "IP ID is, "<< ipHeader.GetIdentification() << ", "
-                                << "DSCP is, "<< ipHeader.GetDscp() << ", "
-                                << "ECN is, "<< ipHeader.GetEcn() << ", "
-                                << "TTL is, "<< (uint16_t) ipHeader.GetTtl() << ", "
-                                << "Payload size is, "<< ipHeader.GetPayloadSize() << ", "
-                                << "Protocol is, "<< (uint16_t) ipHeader.GetProtocol() << ", "
-                                << "Source IP is, "<< ipHeader.GetSource() << ", "
-                                << "Destination IP is, "<< ipHeader.GetDestination() << ", ";           
-        TcpHeader tcpHeader;
-        UdpHeader udpHeader;
-
-        // Check if it's a TCP or UDP packet
-        if ((uint16_t) ipHeader.GetProtocol() == 6)
-        {   
-            copy->RemoveHeader(tcpHeader);
-            *stream->GetStream() << "TCP source port is, "<< tcpHeader.GetSourcePort() << ", "
-                                 << "TCP destination port is, "<< tcpHeader.GetDestinationPort() << ", "
-                                 << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", "
-                                 << "TCP current window size is, "<< tcpHeader.GetWindowSize() << ", ";
-        }
-        else if ((uint16_t) ipHeader.GetProtocol() == 17)
-        {   
-            copy->RemoveHeader(udpHeader);
-            *stream->GetStream() << "UDP source port is, "<< udpHeader.GetSourcePort() << ", "
-                                 << "UDP destination port is, "<< udpHeader.GetDestinationPort() << ", ";
-        }
-        else
-        {
-            *stream->GetStream() << "Unknown transport protocol, ";
-        }
-
-        // copy->RemoveHeader(tcpHeader);
-        *stream->GetStream() 
-                            //  << "TCP source port is, "<< tcpHeader.GetSourcePort() << ", "
-                            //  << "TCP destination port is, "<< tcpHeader.GetDestinationPort() << ", "
-                            //  << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", "
-                            //  << "TCP current window size is, "<< tcpHeader.GetWindowSize() << ", "
-                             << "Delay is, "<< diff_time.GetSeconds() << ", "
-                             << "Workload id is, "<< idTag.GetWorkload() << ','
-                             << "Application id is, "<< idTag.GetApplication() << ','
-                             << "Message id is, "<< mTag.GetSimpleValue() << ',';
-
-
-        copy->Print(*stream->GetStream());
-        *stream->GetStream() << "\n";
-
+        return;
     }
-    else
-    {
-        //NS_LOG_DEBUG("Packet without timestamp, won't log.");
-    };
-};
+    PacketHeaderView header(p);
+    SenderRecord record;
+    record.timestamp = timestampTag.GetTime().GetNanoSeconds();
+    record.uid = p->GetUid();
+    record.node = node;
+    record.size = p->GetSize();
+    record.sequence = header.GetSequenceNumber();
+    SenderRecordFormat().PrintCsv(*stream->GetStream(),
+                                  reinterpret_cast<const uint8_t *>(&record));
+}
 
 // Log TCP ack time, sequence number, and window size 
-// received at the sender
-void logAckInfo(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
+// received at the sender. With `printHeaders`, the header dump of
+// Packet::Print is appended.
+void logAckInfo(Ptr<OutputStreamWrapper> stream, bool printHeaders, Ptr<Packet const> p)
 {
     TimestampTag timestampTag;
     IdTag idTag;
@@ -195,52 +116,24 @@ void logAckInfo(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
     MessageTag mTag;
     p->PeekPacketTag(mTag);
 
-    Ptr<Packet> copy = p->Copy();
-    EthernetHeader eHeader;
-    copy->RemoveHeader(eHeader);
-    Ipv4Header ipHeader;
-    copy->RemoveHeader(ipHeader);
-    TcpHeader tcpHeader;
-    copy->RemoveHeader(tcpHeader);
+    PacketHeaderView header(p);
 
     auto current_time = Simulator::Now();
     *stream->GetStream() << "Ack received at "<< current_time.GetSeconds()<< ", ";
     *stream->GetStream() << "Packet size is, "<< p->GetSize() << ", ";
     *stream->GetStream() << "Packet uid is, "<< p->GetUid() << ", ";
     // Add TCP sequence number to track the packet
-    *stream->GetStream() << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", ";
+    *stream->GetStream() << "TCP sequence num is, "<< header.GetSequenceNumber() << ", ";
     // Add TCP ack number to track the packet
-    *stream->GetStream() << "TCP ack num is, "<< tcpHeader.GetAckNumber() << ", ";
+    *stream->GetStream() << "TCP ack num is, "<< header.GetAckNumber() << ", ";
 
-    p->Print(*stream->GetStream());
+    if (printHeaders)
+    {
+        p->Print(*stream->GetStream());
+    }
     *stream->GetStream() << "\n";
 };
 
-void logValue(Ptr<OutputStreamWrapper> stream, std::string context,
-              uint32_t oldval, uint32_t newval)
-{
-    auto current_time = Simulator::Now();
-    *stream->GetStream() << context << ',' << current_time.GetSeconds() << ','
-                         << newval << std::endl;
-}
-
-void logDrop(Ptr<OutputStreamWrapper> stream,
-             std::string context, Ptr<Packet const> p)
-{
-    auto current_time = Simulator::Now();
-
-    Ptr<Packet> copy = p->Copy();
-    EthernetHeader eHeader;
-    copy->RemoveHeader(eHeader);
-    Ipv4Header ipHeader;
-    copy->RemoveHeader(ipHeader);
-    TcpHeader tcpHeader;
-    copy->RemoveHeader(tcpHeader);
-
-    *stream->GetStream() << context << ',' << current_time.GetSeconds() << ','
-                         << p->GetSize() << "," << tcpHeader.GetSequenceNumber() << std::endl;
-};
-
 // TODO: Add base stream? Or how to get different random streams?
 Ptr<RandomVariableStream> TimeStream(double min = 0.0, double max = 1.0)
 {
@@ -308,7 +201,28 @@ int main(int argc, char *argv[])
     std::string w1 = basedir + "SingleTestDistribution.txt";
     std::string w2 = basedir + "SingleTestDistribution.txt";
     std::string w3 = basedir + "SingleTestDistribution.txt";
+    bool compiledcdf = false;
     std::string prefix = "shift";
+    std::string traceformat = "csv";
+    bool asynctrace = false;
+    // Sampling policy of the packet and drop logs, see TraceSampler.
+    std::string tracesample = "";
+    // Append the header dump of Packet::Print to the csv logs. This needs packet
+    // metadata, which is otherwise left disabled for the whole simulation.
+    bool printHeaders = false;
+    bool queuechanges = false;
+    Time queuewindow("0ms");
+    Time queuesample("0ms");
+    std::string queuesamplepath = "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue";
+    bool messagetrace = false;
+    bool droppackets = false;
+    bool delayhistogram = false;
+    Time flowwindow("0ms");
+    Time flowstep("0ms");
+    uint32_t sequencelength = 0;
+    uint32_t sequencestride = 1;
+    uint32_t sequenceshard = 4096;
+    std::string taps = "./taps/switches_large_tests.txt";
     double c_w1 = 1;
     double c_w2 = 1;
     double c_w3 = 1;
@@ -331,10 +245,43 @@ int main(int argc, char *argv[])
     cmd.AddValue("congestion2", "Congestion traffic rate.", congestion2);
     cmd.AddValue("congestion3", "Congestion traffic rate.", congestion3);
     cmd.AddValue("prefix", "Prefix for log files.", prefix);
+    cmd.AddValue("traceformat", "Format of the logs (csv, binary, compressed, columnar or mapped).", traceformat);
+    cmd.AddValue("asynctrace", "Write the logs on background threads, one per log.", asynctrace);
+    cmd.AddValue("queuechanges", "Log only the changes of the queue occupancy (.ntq).", queuechanges);
+    cmd.AddValue("queuewindow", "Coalesce the queue changes over this window.", queuewindow);
+    cmd.AddValue("queuesample", "Sample the queues at this interval (.npy) instead of logging every change, 0 to disable.", queuesample);
+    cmd.AddValue("queuesamplepath", "Config path of the sampled queues.", queuesamplepath);
+    cmd.AddValue("messagetrace", "Log one record per completed message with its completion time.", messagetrace);
+    cmd.AddValue("droppackets", "Also log the dropped packets with their tags and 5-tuple, keyed by port id (drops_packets, with the ports in drops_packets_ports.csv).", droppackets);
+    cmd.AddValue("compiledcdf", "Map the distributions compiled by ntt-cdf-compile (.cdfb instead of .txt) instead of parsing them.", compiledcdf);
+    cmd.AddValue("delayhistogram", "Write mergeable histograms of the delay per workload, application and receiver (.ntd).", delayhistogram);
+    cmd.AddValue("flowwindow", "Log per-flow packets, bytes, delays and messages over windows of this length, 0 to disable.", flowwindow);
+    cmd.AddValue("flowstep", "Start a flow window every flowstep, a divisor of flowwindow, 0 for back-to-back windows.", flowstep);
+    cmd.AddValue("sequencelength", "Export sliding sequences of this many packets for training (.npy shards), 0 to disable.", sequencelength);
+    cmd.AddValue("sequencestride", "Packets between the starts of two exported sequences.", sequencestride);
+    cmd.AddValue("sequenceshard", "Exported sequences per .npy shard.", sequenceshard);
+    cmd.AddValue("taps", "Config file of the switch trace taps, see TraceRegistry; none if empty.", taps);
+    cmd.AddValue("printheaders", "Enable packet metadata and dump the headers in the csv logs.", printHeaders);
+    cmd.AddValue("tracesample", "Sample the packet and drop logs, e.g. \"time=20s-40s,flows=4,every=10\" or \"delay=p99\", see TraceSampler.", tracesample);
     cmd.AddValue("seed", "Set simulation seed", seed);
     cmd.AddValue("cc", "TCP-CC algorithm.", cc_alg);
     cmd.Parse(argc, argv);
 
+    // Compiled distributions are set with their own attribute.
+    std::string cdfAttribute = "CdfFile";
+    if (compiledcdf)
+    {
+        cdfAttribute = "CompiledCdfFile";
+        w1 = CdfTable::GetCompiledName(w1);
+        w2 = CdfTable::GetCompiledName(w2);
+        w3 = CdfTable::GetCompiledName(w3);
+    }
+
+    if (printHeaders)
+    {
+        Packet::EnablePrinting();
+    }
+
     // Compute resulting workload datarates.
     auto rate_w1 = DataRate(static_cast<uint64_t>(c_w1 * baserate.GetBitRate()));
     auto rate_w2 = DataRate(static_cast<uint64_t>(c_w2 * baserate.GetBitRate()));
@@ -445,6 +392,14 @@ int main(int argc, char *argv[])
     auto switchE = switches.Get(4);
     auto switchF = switches.Get(5);
     auto switchG = switches.Get(6);
+    // Names for the config paths of the tap config, e.g. /Names/switchA.
+    Names::Add("switchA", switchA);
+    Names::Add("switchB", switchB);
+    Names::Add("switchC", switchC);
+    Names::Add("switchD", switchD);
+    Names::Add("switchE", switchE);
+    Names::Add("switchF", switchF);
+    Names::Add("switchG", switchG);
 
     NodeContainer senders;
     senders.Create(3 * n_apps);
@@ -620,7 +575,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -636,7 +591,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -652,7 +607,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -719,7 +674,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -735,7 +690,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -751,7 +706,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -817,7 +772,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -833,7 +788,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -849,7 +804,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -916,7 +871,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -932,7 +887,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -948,7 +903,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -1015,7 +970,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -1031,7 +986,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -1047,7 +1002,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -1113,7 +1068,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -1129,7 +1084,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -1145,7 +1100,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -1212,7 +1167,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -1228,7 +1183,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -1244,7 +1199,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -1311,7 +1266,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -1327,7 +1282,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -1343,7 +1298,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr2, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -1409,7 +1364,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -1425,7 +1380,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -1441,7 +1396,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr3, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -1519,91 +1474,99 @@ int main(int argc, char *argv[])
         "MacTx", MakeCallback(&setTimeTag));*/
 
     // Separate log for each receiver
+    TraceLogHelper logs;
+    logs.SetFormat(traceformat);
+    logs.SetAsync(asynctrace);
+    logs.SetSample(tracesample);
+    logs.SetPrintHeaders(printHeaders);
     std::stringstream receiver1filename;
-    receiver1filename << "results_test_large/" << "_receiver1.csv";
-    auto receiver1file = asciiTraceHelper.CreateFileStream(receiver1filename.str());
+    receiver1filename << "results_test_large/" << "_receiver1";
+    auto receiver1log = logs.PacketLog(receiver1filename.str());
     receiver1->GetDevice(0)->TraceConnectWithoutContext(
-        "MacRx", MakeBoundCallback(&logPacketInfo, receiver1file));
+        "MacRx", receiver1log);
     
     std::stringstream receiver2filename;
-    receiver2filename << "results_test_large/" << "_receiver2.csv";
-    auto receiver2file = asciiTraceHelper.CreateFileStream(receiver2filename.str());
+    receiver2filename << "results_test_large/" << "_receiver2";
+    auto receiver2log = logs.PacketLog(receiver2filename.str());
     receiver2->GetDevice(0)->TraceConnectWithoutContext(
-        "MacRx", MakeBoundCallback(&logPacketInfo, receiver2file));
+        "MacRx", receiver2log);
 
     std::stringstream receiver3filename;
-    receiver3filename << "results_test_large/" << "_receiver3.csv";
-    auto receiver3file = asciiTraceHelper.CreateFileStream(receiver3filename.str());
+    receiver3filename << "results_test_large/" << "_receiver3";
+    auto receiver3log = logs.PacketLog(receiver3filename.str());
     receiver3->GetDevice(0)->TraceConnectWithoutContext(
-        "MacRx", MakeBoundCallback(&logPacketInfo, receiver3file));
-
-    // Log packetInfo at the switches A, C and E
-    std::stringstream switchAfilename1;
-    switchAfilename1 << "results_test_large/" << "switch_A_port1.csv";
-    auto switchAfile1 = asciiTraceHelper.CreateFileStream(switchAfilename1.str());
-    switchA->GetDevice(0)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchAfile1));
-
-    std::stringstream switchAfilename2;
-    switchAfilename2 << "results_test_large/" << "switch_A_port2.csv";
-    auto switchAfile2 = asciiTraceHelper.CreateFileStream(switchAfilename2.str());
-    switchA->GetDevice(1)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchAfile2));
-
-    std::stringstream switchAfilename3;
-    switchAfilename3 << "results_test_large/" << "switch_A_port3.csv";
-    auto switchAfile3 = asciiTraceHelper.CreateFileStream(switchAfilename3.str());
-    switchA->GetDevice(2)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchAfile3));
-
-    std::stringstream switchCfilename1;
-    switchCfilename1 << "results_test_large/" << "switch_C_port1.csv";
-    auto switchCfile1 = asciiTraceHelper.CreateFileStream(switchCfilename1.str());
-    switchC->GetDevice(0)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchCfile1));
-
-    std::stringstream switchCfilename2;
-    switchCfilename2 << "results_test_large/" << "switch_C_port2.csv";
-    auto switchCfile2 = asciiTraceHelper.CreateFileStream(switchCfilename2.str());
-    switchC->GetDevice(1)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchCfile2));
-
-    std::stringstream switchCfilename3;
-    switchCfilename3 << "results_test_large/" << "switch_C_port3.csv";
-    auto switchCfile3 = asciiTraceHelper.CreateFileStream(switchCfilename3.str());
-    switchC->GetDevice(2)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchCfile3));
-
-    std::stringstream switchEfilename1;
-    switchEfilename1 << "results_test_large/" << "switch_E_port1.csv";
-    auto switchEfile1 = asciiTraceHelper.CreateFileStream(switchEfilename1.str());
-    switchE->GetDevice(0)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchEfile1));
-
-    std::stringstream switchEfilename2;
-    switchEfilename2 << "results_test_large/" << "switch_E_port2.csv";
-    auto switchEfile2 = asciiTraceHelper.CreateFileStream(switchEfilename2.str());
-    switchE->GetDevice(1)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchEfile2));
-
-    std::stringstream switchEfilename3;
-    switchEfilename3 << "results_test_large/" << "switch_E_port3.csv";
-    auto switchEfile3 = asciiTraceHelper.CreateFileStream(switchEfilename3.str());
-    switchE->GetDevice(2)->TraceConnectWithoutContext(
-        "MacTx", MakeBoundCallback(&logPacketInfo, switchEfile3));
+        "MacRx", receiver3log);
+
+    // Per-flow aggregates, written as the windows end.
+    if (!flowwindow.IsZero())
+    {
+        logs.ConnectFlowWindowLog("results_test_large/flows", flowwindow, flowstep,
+                                  NodeContainer(receiver1, receiver2, receiver3));
+    }
+
+    // Training sequences, sharded as they are cut.
+    if (sequencelength > 0)
+    {
+        logs.ConnectSequenceExport("results_test_large/sequences", sequencelength, sequencestride, sequenceshard,
+                                   NodeContainer(receiver1, receiver2, receiver3));
+    }
+
+    // Delay histograms, written at the end of the run.
+    Ptr<DelayHistogramSet> histograms;
+    if (delayhistogram)
+    {
+        histograms = Create<DelayHistogramSet>();
+        TraceLogHelper::ConnectDelayHistograms(
+            histograms, NodeContainer(receiver1, receiver2, receiver3));
+    }
+
+    // Message completion times, from the messages handed to the sockets
+    // and the bytes delivered at the receivers.
+    Ptr<MessageTracker> messages;
+    if (messagetrace)
+    {
+        messages = logs.StartMessageTracker("results_test_large/messages",
+                                            NodeContainer(receiver1, receiver2, receiver3));
+    }
+
+    // Log packetInfo at the switch ports listed in the tap config, all
+    // into one multiplexed file, see TraceRegistry and ntt-trace-demux.
+    Ptr<MuxTraceOutput> tapOutput;
+    if (!taps.empty())
+    {
+        tapOutput = Create<MuxTraceOutput>("results_test_large/switch_taps.ntx");
+        Ptr<TraceRegistry> registry = Create<TraceRegistry>(tapOutput, tracesample);
+        registry->Load(taps);
+        std::cout << "Connected " << registry->GetNTaps() << " trace taps." << std::endl;
+    }
     
     //csma.EnablePcapAll("csma-bridge", false);
 
     // Track queues
-    auto queuefile = asciiTraceHelper.CreateFileStream("results_test_large/queue.csv");
-    Config::Connect(
-        "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue",
-        MakeBoundCallback(&logValue, queuefile));
+    if (!queuesample.IsZero())
+    {
+        logs.StartQueueSampler("results_test_large/queue_samples", queuesample, queuesamplepath);
+    }
+    else if (queuechanges)
+    {
+        logs.ConnectQueueChangeLog("results_test_large/queue", queuewindow);
+    }
+    else
+    {
+        auto queuelog = logs.QueueLog("results_test_large/queue");
+        Config::Connect(
+            "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue",
+            queuelog);
+    }
 
-    auto dropfile = asciiTraceHelper.CreateFileStream("results_test_large/drops.csv");
+    auto droplog = logs.DropLog("results_test_large/drops", true);
     Config::Connect(
         "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/MacTxDrop",
-        MakeBoundCallback(&logDrop, dropfile));
+        droplog);
+    if (droppackets)
+    {
+        logs.ConnectDropPacketLog("results_test_large/drops_packets");
+    }
 
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
     
@@ -1613,6 +1576,22 @@ int main(int argc, char *argv[])
     NS_LOG_INFO("Run Simulation.");
     Simulator::Stop(stopTime);
     Simulator::Run();
+    ReportBacklogs(std::cout);
+    if (histograms)
+    {
+        histograms->Write("results_test_large/delay.ntd");
+    }
+    if (messages)
+    {
+        messages->Close();
+        std::cout << "Completed " << messages->GetCompleted() << " messages, "
+                  << messages->GetIncomplete() << " incomplete." << std::endl;
+    }
+    if (tapOutput)
+    {
+        tapOutput->Close();
+    }
+    logs.Close(std::cout);
     Simulator::Destroy();
     NS_LOG_INFO("Done.");
 
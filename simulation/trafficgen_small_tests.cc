@@ -47,6 +47,11 @@
 
 #include "ns3/cdf-application.h"
 #include "ns3/experiment-tags.h"
+#include "ns3/cdf-table.h"
+#include "ns3/trace-record.h"
+#include "ns3/packet-header-view.h"
+#include "ns3/trace-helpers.h"
+#include "ns3/packet-join.h"
 
 using namespace ns3;
 
@@ -60,7 +65,7 @@ void logSize(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
 {
     auto current_time = Simulator::Now();
     *stream->GetStream() << current_time.GetSeconds() << ','
-                         << p->GetSize() << std::endl;
+                         << p->GetSize() << "\n";
 }
 
 // Tag a packet with a timestamp.
@@ -79,115 +84,36 @@ void setIdTag(u_int32_t workload_id, u_int32_t app_id, Ptr<Packet const> p)
     p->AddPacketTag(tag);
 };
 
-void logSenderPacket(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
+// Log a packet sent by `node` as one csv row of SenderRecordFormat.
+void logSenderPacket(Ptr<OutputStreamWrapper> stream, uint32_t node, Ptr<Packet const> p)
 {
     TimestampTag timestampTag;
-
-    if (p->PeekPacketTag(timestampTag)){
-
-        Ptr<Packet> copy = p->Copy();
-        EthernetHeader eHeader;
-        copy->RemoveHeader(eHeader);
-        Ipv4Header ipHeader;
-        copy->RemoveHeader(ipHeader);
-        TcpHeader tcpHeader;
-        copy->RemoveHeader(tcpHeader);
-
-        auto sender_time = timestampTag.GetTime();
-        *stream->GetStream() << "Tx sent at:, "<< sender_time.GetSeconds()<< ", ";
-        *stream->GetStream() << "Packet size is, "<< p->GetSize() << ", ";
-        *stream->GetStream() << "Packet uid is, "<< p->GetUid() << ", ";
-        // Add TCP sequence number to track the packet
-        *stream->GetStream() << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", ";
-        *stream->GetStream() << "\n";
-    }
-    else
+    if (!p->PeekPacketTag(timestampTag))
     {
         NS_LOG_DEBUG("Packet without timestamp, won't log.");
-    };
-
+        return;
+    }
+    PacketHeaderView header(p);
+    SenderRecord record;
+    record.timestamp = timestampTag.GetTime().GetNanoSeconds();
+    record.uid = p->GetUid();
+    record.node = node;
+    record.size = p->GetSize();
+    record.sequence = header.GetSequenceNumber();
+    SenderRecordFormat().PrintCsv(*stream->GetStream(),
+                                  reinterpret_cast<const uint8_t *>(&record));
 }
 
-// Log workload tag, timestamp tag, and packet size.
-void logPacketInfo(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
+// Remember a packet sent by `node` for the join with the receiver.
+void joinSenderPacket(Ptr<PacketJoin> join, uint32_t node, Ptr<Packet const> p)
 {
-    TimestampTag timestampTag;
-    IdTag idTag;
-    FlowIdTag flowid;
-    MessageTag mTag;
-    p->PeekPacketTag(mTag);
-    
-    if (p->PeekPacketTag(timestampTag) && p->PeekPacketTag(idTag))
-    {
-        auto current_time = Simulator::Now();
-        auto diff_time = current_time - timestampTag.GetTime();
-        *stream->GetStream() << "Tx sent at:, "<< current_time.GetSeconds()<< ", ";
-        *stream->GetStream() << "Flow id is, "<< p->PeekPacketTag(flowid) << ", "
-                             << "Packet uid is, "<< p->GetUid() << ", "
-                             << "Packet size is, "<< p->GetSize() << ", ";
-                             
-        Ptr<Packet> copy = p->Copy();
-        // Headers must be removed in the order they're present.
-        EthernetHeader eHeader;
-        copy->RemoveHeader(eHeader);
-        Ipv4Header ipHeader;
-        copy->RemoveHeader(ipHeader);
-        *stream->GetStream() << "IP ID is, "<< ipHeader.GetIdentification() << ", "
-                                << "DSCP is, "<< ipHeader.GetDscp() << ", "
-                                << "ECN is, "<< ipHeader.GetEcn() << ", "
-                                << "TTL is, "<< (uint16_t) ipHeader.GetTtl() << ", "
-                                << "Payload size is, "<< ipHeader.GetPayloadSize() << ", "
-                                << "Protocol is, "<< (uint16_t) ipHeader.GetProtocol() << ", "
-                                << "Source IP is, "<< ipHeader.GetSource() << ", "
-                                << "Destination IP is, "<< ipHeader.GetDestination() << ", ";           
-        TcpHeader tcpHeader;
-        UdpHeader udpHeader;
-
-        // Check if it's a TCP or UDP packet
-        if ((uint16_t) ipHeader.GetProtocol() == 6)
-        {   
-            copy->RemoveHeader(tcpHeader);
-            *stream->GetStream() << "TCP source port is, "<< tcpHeader.GetSourcePort() << ", "
-                                 << "TCP destination port is, "<< tcpHeader.GetDestinationPort() << ", "
-                                 << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", "
-                                 << "TCP current window size is, "<< tcpHeader.GetWindowSize() << ", ";
-        }
-        else if ((uint16_t) ipHeader.GetProtocol() == 17)
-        {   
-            copy->RemoveHeader(udpHeader);
-            *stream->GetStream() << "UDP source port is, "<< udpHeader.GetSourcePort() << ", "
-                                 << "UDP destination port is, "<< udpHeader.GetDestinationPort() << ", ";
-        }
-        else
-        {
-            *stream->GetStream() << "Unknown transport protocol, ";
-        }
-
-        // copy->RemoveHeader(tcpHeader);
-        *stream->GetStream() 
-                            //  << "TCP source port is, "<< tcpHeader.GetSourcePort() << ", "
-                            //  << "TCP destination port is, "<< tcpHeader.GetDestinationPort() << ", "
-                            //  << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", "
-                            //  << "TCP current window size is, "<< tcpHeader.GetWindowSize() << ", "
-                             << "Delay is, "<< diff_time.GetSeconds() << ", "
-                             << "Workload id is, "<< idTag.GetWorkload() << ','
-                             << "Application id is, "<< idTag.GetApplication() << ','
-                             << "Message id is, "<< mTag.GetSimpleValue() << ',';
-
-
-        copy->Print(*stream->GetStream());
-        *stream->GetStream() << "\n";
-
-    }
-    else
-    {
-        //NS_LOG_DEBUG("Packet without timestamp, won't log.");
-    };
-};
+    join->Sent(node, p);
+}
 
 // Log TCP ack time, sequence number, and window size 
-// received at the sender
-void logAckInfo(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
+// received at the sender. With `printHeaders`, the header dump of
+// Packet::Print is appended.
+void logAckInfo(Ptr<OutputStreamWrapper> stream, bool printHeaders, Ptr<Packet const> p)
 {
     TimestampTag timestampTag;
     IdTag idTag;
@@ -195,35 +121,24 @@ void logAckInfo(Ptr<OutputStreamWrapper> stream, Ptr<Packet const> p)
     MessageTag mTag;
     p->PeekPacketTag(mTag);
 
-    Ptr<Packet> copy = p->Copy();
-    EthernetHeader eHeader;
-    copy->RemoveHeader(eHeader);
-    Ipv4Header ipHeader;
-    copy->RemoveHeader(ipHeader);
-    TcpHeader tcpHeader;
-    copy->RemoveHeader(tcpHeader);
+    PacketHeaderView header(p);
 
     auto current_time = Simulator::Now();
     *stream->GetStream() << "Ack received at "<< current_time.GetSeconds()<< ", ";
     *stream->GetStream() << "Packet size is, "<< p->GetSize() << ", ";
     *stream->GetStream() << "Packet uid is, "<< p->GetUid() << ", ";
     // Add TCP sequence number to track the packet
-    *stream->GetStream() << "TCP sequence num is, "<< tcpHeader.GetSequenceNumber() << ", ";
+    *stream->GetStream() << "TCP sequence num is, "<< header.GetSequenceNumber() << ", ";
     // Add TCP ack number to track the packet
-    *stream->GetStream() << "TCP ack num is, "<< tcpHeader.GetAckNumber() << ", ";
+    *stream->GetStream() << "TCP ack num is, "<< header.GetAckNumber() << ", ";
 
-    p->Print(*stream->GetStream());
+    if (printHeaders)
+    {
+        p->Print(*stream->GetStream());
+    }
     *stream->GetStream() << "\n";
 };
                              
-void logValue(Ptr<OutputStreamWrapper> stream, std::string context,
-              uint32_t oldval, uint32_t newval)
-{
-    auto current_time = Simulator::Now();
-    *stream->GetStream() << context << ',' << current_time.GetSeconds() << ','
-                         << newval << std::endl;
-}
-
 // void logQueue(Ptr<OutputStreamWrapper> stream, uint32_t oldval, uint32_t newval)
 // {
 //     auto current_time = Simulator::Now();
@@ -231,23 +146,6 @@ void logValue(Ptr<OutputStreamWrapper> stream, std::string context,
 //                          << newval << std::endl;
 // }
 
-void logDrop(Ptr<OutputStreamWrapper> stream,
-             std::string context, Ptr<Packet const> p)
-{
-    auto current_time = Simulator::Now();
-
-    Ptr<Packet> copy = p->Copy();
-    EthernetHeader eHeader;
-    copy->RemoveHeader(eHeader);
-    Ipv4Header ipHeader;
-    copy->RemoveHeader(ipHeader);
-    TcpHeader tcpHeader;
-    copy->RemoveHeader(tcpHeader);
-
-    *stream->GetStream() << context << ',' << current_time.GetSeconds() << ','
-                         << p->GetSize() << "," << tcpHeader.GetSequenceNumber() << std::endl;
-};
-
 // static Ptr<OutputStreamWrapper> cWndStream;
 // static void CwndTracer(uint32_t oldCwnd, uint32_t newCwnd)
 // {
@@ -332,7 +230,29 @@ int main(int argc, char *argv[])
     std::string w1 = basedir + "SingleTestDistribution.txt";
     std::string w2 = basedir + "SingleTestDistribution.txt";
     std::string w3 = basedir + "SingleTestDistribution.txt";
+    bool compiledcdf = false;
     std::string prefix = "shift";
+    std::string traceformat = "csv";
+    bool asynctrace = false;
+    // Sampling policy of the packet and drop logs, see TraceSampler.
+    std::string tracesample = "";
+    // Append the header dump of Packet::Print to the csv logs. This needs packet
+    // metadata, which is otherwise left disabled for the whole simulation.
+    bool printHeaders = false;
+    bool queuechanges = false;
+    Time queuewindow("0ms");
+    Time queuesample("0ms");
+    bool jointrace = false;
+    std::string queuesamplepath = "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue";
+    bool messagetrace = false;
+    bool droppackets = false;
+    bool delayhistogram = false;
+    Time flowwindow("0ms");
+    Time flowstep("0ms");
+    uint32_t sequencelength = 0;
+    uint32_t sequencestride = 1;
+    uint32_t sequenceshard = 4096;
+    bool packettrace = true;
     double c_w1 = 1;
     double c_w2 = 1;
     double c_w3 = 1;
@@ -356,6 +276,25 @@ int main(int argc, char *argv[])
     cmd.AddValue("w3", "Factor for W3 traffic (FB hadoop).", c_w3);
     cmd.AddValue("congestion1", "Congestion traffic rate.", congestion1);
     cmd.AddValue("prefix", "Prefix for log files.", prefix);
+    cmd.AddValue("traceformat", "Format of the logs (csv, binary, compressed, columnar or mapped).", traceformat);
+    cmd.AddValue("asynctrace", "Write the logs on background threads, one per log.", asynctrace);
+    cmd.AddValue("queuechanges", "Log only the changes of the queue occupancy (.ntq).", queuechanges);
+    cmd.AddValue("queuewindow", "Coalesce the queue changes over this window.", queuewindow);
+    cmd.AddValue("queuesample", "Sample the queues at this interval (.npy) instead of logging every change, 0 to disable.", queuesample);
+    cmd.AddValue("queuesamplepath", "Config path of the sampled queues.", queuesamplepath);
+    cmd.AddValue("jointrace", "Join sender and receiver packets in the simulation instead of logging every sender.", jointrace);
+    cmd.AddValue("messagetrace", "Log one record per completed message with its completion time.", messagetrace);
+    cmd.AddValue("droppackets", "Also log the dropped packets with their tags and 5-tuple, keyed by port id (drops_packets, with the ports in drops_packets_ports.csv).", droppackets);
+    cmd.AddValue("compiledcdf", "Map the distributions compiled by ntt-cdf-compile (.cdfb instead of .txt) instead of parsing them.", compiledcdf);
+    cmd.AddValue("delayhistogram", "Write mergeable histograms of the delay per workload, application and receiver (.ntd).", delayhistogram);
+    cmd.AddValue("flowwindow", "Log per-flow packets, bytes, delays and messages over windows of this length, 0 to disable.", flowwindow);
+    cmd.AddValue("flowstep", "Start a flow window every flowstep, a divisor of flowwindow, 0 for back-to-back windows.", flowstep);
+    cmd.AddValue("sequencelength", "Export sliding sequences of this many packets for training (.npy shards), 0 to disable.", sequencelength);
+    cmd.AddValue("sequencestride", "Packets between the starts of two exported sequences.", sequencestride);
+    cmd.AddValue("sequenceshard", "Exported sequences per .npy shard.", sequenceshard);
+    cmd.AddValue("packettrace", "Log every packet at the receivers, disable if only the messages are needed.", packettrace);
+    cmd.AddValue("printheaders", "Enable packet metadata and dump the headers in the csv logs.", printHeaders);
+    cmd.AddValue("tracesample", "Sample the packet and drop logs, e.g. \"time=20s-40s,flows=4,every=10\" or \"delay=p99\", see TraceSampler.", tracesample);
     cmd.AddValue("seed", "Set simulation seed", seed);
     cmd.AddValue("cc", "TCP-CC algorithm.", cc_alg);
     cmd.AddValue("useL4s", "Use L4S ECN marking.", useL4s);
@@ -363,6 +302,21 @@ int main(int argc, char *argv[])
     cmd.AddValue("useECT0", "Use ECT0 marking.", useECT0);
     cmd.Parse(argc, argv);
 
+    // Compiled distributions are set with their own attribute.
+    std::string cdfAttribute = "CdfFile";
+    if (compiledcdf)
+    {
+        cdfAttribute = "CompiledCdfFile";
+        w1 = CdfTable::GetCompiledName(w1);
+        w2 = CdfTable::GetCompiledName(w2);
+        w3 = CdfTable::GetCompiledName(w3);
+    }
+
+    if (printHeaders)
+    {
+        Packet::EnablePrinting();
+    }
+
     // Compute resulting workload datarates.
     auto rate_w1 = DataRate(static_cast<uint64_t>(c_w1 * baserate.GetBitRate()));
     auto rate_w2 = DataRate(static_cast<uint64_t>(c_w2 * baserate.GetBitRate()));
@@ -565,7 +519,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source1 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w1), "CdfFile", StringValue(w1),
+                "DataRate", DataRateValue(rate_w1), cdfAttribute, StringValue(w1),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source1->TraceConnectWithoutContext(
@@ -584,7 +538,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source2 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w2), "CdfFile", StringValue(w2),
+                "DataRate", DataRateValue(rate_w2), cdfAttribute, StringValue(w2),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source2->TraceConnectWithoutContext(
@@ -603,7 +557,7 @@ int main(int argc, char *argv[])
             std::cout<< "App " << _id << " starting at..." <<app_start_time << std::endl;
             Ptr<CdfApplication> source3 = CreateObjectWithAttributes<CdfApplication>(
                 "Remote", recvAddr1, "Protocol", TCP,
-                "DataRate", DataRateValue(rate_w3), "CdfFile", StringValue(w3),
+                "DataRate", DataRateValue(rate_w3), cdfAttribute, StringValue(w3),
                 "StartTime", TimeValue(Seconds(app_start_time)),
                 "StopTime", simStop);
             source3->TraceConnectWithoutContext(
@@ -645,44 +599,108 @@ int main(int argc, char *argv[])
 
 
     NS_LOG_INFO("Install Tracing");
-    AsciiTraceHelper asciiTraceHelper;
 
     // Log (one-way) delay from sender to receiver (excludes other sources).
-    std::stringstream trackfilename;
-    // trackfilename << prefix << "_delays.csv";
-    trackfilename << prefix << ".csv"; // only one file for now.
-    auto trackfile = asciiTraceHelper.CreateFileStream(trackfilename.str());
+    // Only one file for all receivers for now.
+    TraceLogHelper logs;
+    logs.SetFormat(traceformat);
+    logs.SetAsync(asynctrace);
+    logs.SetSample(tracesample);
+    logs.SetPrintHeaders(printHeaders);
+
+    // Instead of one log per sender, join the sent and received packets
+    // and write one record per delivered packet.
+    Ptr<PacketJoin> join;
+    if (jointrace)
+    {
+        join = Create<PacketJoin>(
+            logs.Open(prefix + "_joined", Create<JoinedPacketRecordFormat>()),
+            logs.Open(prefix + "_sent_drops", Create<SenderRecordFormat>()));
+    }
 
     for (auto it = senders.Begin(); it != senders.End(); it++)
     {
         Ptr<Node> sender = *it;
         sender->GetDevice(0)->TraceConnectWithoutContext(
             "MacTx", MakeCallback(&setTimeTag));
+
+        if (jointrace)
+        {
+            sender->GetDevice(0)->TraceConnectWithoutContext(
+                "MacTx", MakeBoundCallback(&joinSenderPacket, join, sender->GetId()));
+            continue;
+        }
         
         std::stringstream sender_trackfilename;
-        sender_trackfilename << prefix << "_sender_" << sender->GetId() << ".csv";
-        auto sender_trackfile = asciiTraceHelper.CreateFileStream(sender_trackfilename.str());
+        sender_trackfilename << prefix << "_sender_" << sender->GetId();
+        auto sender_trackfile = TraceLogHelper::OpenCsv(sender_trackfilename.str(), SenderRecordFormat());
 
         sender->GetDevice(0)->TraceConnectWithoutContext(
-            "MacTx", MakeBoundCallback(&logSenderPacket, sender_trackfile));
+            "MacTx", MakeBoundCallback(&logSenderPacket, sender_trackfile, sender->GetId()));
     }
     /*sender->GetDevice(0)->TraceConnectWithoutContext(
         "MacTx", MakeCallback(&setTimeTag));*/
 
-    receiver1->GetDevice(0)->TraceConnectWithoutContext(
-        "MacRx", MakeBoundCallback(&logPacketInfo, trackfile));
+    if (packettrace)
+    {
+        auto trackcallback = logs.PacketLog(prefix);
+        receiver1->GetDevice(0)->TraceConnectWithoutContext(
+            "MacRx", trackcallback);
+    }
+    if (jointrace)
+    {
+        receiver1->GetDevice(0)->TraceConnectWithoutContext(
+            "MacRx", MakeCallback(&PacketJoin::Received, join));
+        // Sent packets that are neither received nor dropped were still
+        // in flight at the end.
+        Config::ConnectWithoutContext(
+            "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/MacTxDrop",
+            MakeCallback(&PacketJoin::Dropped, join));
+        Config::ConnectWithoutContext(
+            "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/PhyTxDrop",
+            MakeCallback(&PacketJoin::Dropped, join));
+    }
+
+    // Per-flow aggregates, written as the windows end.
+    if (!flowwindow.IsZero())
+    {
+        logs.ConnectFlowWindowLog(prefix + "_flows", flowwindow, flowstep, NodeContainer(receiver1));
+    }
+
+    // Training sequences, sharded as they are cut.
+    if (sequencelength > 0)
+    {
+        logs.ConnectSequenceExport(prefix + "_sequences", sequencelength, sequencestride, sequenceshard,
+                                   NodeContainer(receiver1));
+    }
+
+    // Delay histograms, written at the end of the run.
+    Ptr<DelayHistogramSet> histograms;
+    if (delayhistogram)
+    {
+        histograms = Create<DelayHistogramSet>();
+        TraceLogHelper::ConnectDelayHistograms(
+            histograms, NodeContainer(receiver1));
+    }
+
+    // Message completion times, from the messages handed to the sockets
+    // and the bytes delivered at the receiver.
+    Ptr<MessageTracker> messages;
+    if (messagetrace)
+    {
+        messages = logs.StartMessageTracker(prefix + "_messages", NodeContainer(receiver1));
+    }
 
-    
     // Trace packets received at the sender too
     // for (auto it = senders.Begin(); it != senders.End(); it++)
     // {
     //     Ptr<Node> sender = *it;
     //     std::stringstream sender_recvd_trackfilename;
     //     sender_recvd_trackfilename << prefix << "_sender_" << sender->GetId() << "_recvd.csv";
-    //     auto sender_trackfile = asciiTraceHelper.CreateFileStream(sender_recvd_trackfilename.str());
+    //     auto sender_trackfile = AsciiTraceHelper().CreateFileStream(sender_recvd_trackfilename.str());
 
     //     sender->GetDevice(0)->TraceConnectWithoutContext(
-    //         "MacRx", MakeBoundCallback(&logAckInfo, sender_trackfile));
+    //         "MacRx", MakeBoundCallback(&logAckInfo, sender_trackfile, printHeaders));
     // }
 
     // Track congestion window
@@ -704,22 +722,37 @@ int main(int argc, char *argv[])
     std::stringstream queuefilename;
     std::stringstream dropfilename;
     // Track queues
-    queuefilename << prefix << "_queues.csv";
-    auto queuefile = asciiTraceHelper.CreateFileStream(queuefilename.str());
-    Config::Connect(
-        "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue",
-        MakeBoundCallback(&logValue, queuefile));
+    queuefilename << prefix << "_queues";
+    if (!queuesample.IsZero())
+    {
+        logs.StartQueueSampler(prefix + "_queue_samples", queuesample, queuesamplepath);
+    }
+    else if (queuechanges)
+    {
+        logs.ConnectQueueChangeLog(queuefilename.str(), queuewindow);
+    }
+    else
+    {
+        auto queuelog = logs.QueueLog(queuefilename.str());
+        Config::Connect(
+            "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/TxQueue/PacketsInQueue",
+            queuelog);
+    }
 
-    dropfilename << prefix << "_drops.csv";
-    auto dropfile = asciiTraceHelper.CreateFileStream(dropfilename.str());
+    dropfilename << prefix << "_drops";
+    auto droplog = logs.DropLog(dropfilename.str(), true);
     Config::Connect(
         "/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/MacTxDrop",
-        MakeBoundCallback(&logDrop, dropfile));
+        droplog);
+    if (droppackets)
+    {
+        logs.ConnectDropPacketLog(dropfilename.str() + "_packets");
+    }
 
     // std::stringstream rootqdiscfilename;
     // rootqdiscfilename << prefix << "_rootqdisc.csv";
 
-    // auto rootqdiscfile = asciiTraceHelper.CreateFileStream(rootqdiscfilename.str());
+    // auto rootqdiscfile = AsciiTraceHelper().CreateFileStream(rootqdiscfilename.str());
     // // Ptr<NetDevice> switch1 = devices.Get(0);
     // // Ptr<PointToPointNetDevice> ptpnd = DynamicCast<PointToPointNetDevice>(switch1);
     // // Ptr<Queue<Packet>> queue = ptpnd->GetQueue();
@@ -736,6 +769,26 @@ int main(int argc, char *argv[])
     NS_LOG_INFO("Run Simulation.");
     Simulator::Stop(stopTime);
     Simulator::Run();
+    ReportBacklogs(std::cout);
+    if (histograms)
+    {
+        histograms->Write(prefix + "_delay.ntd");
+    }
+    if (messages)
+    {
+        messages->Close();
+        std::cout << "Completed " << messages->GetCompleted() << " messages, "
+                  << messages->GetIncomplete() << " incomplete." << std::endl;
+    }
+    if (join)
+    {
+        join->Close();
+        std::cout << "Joined " << join->GetJoined() << " packets, "
+                  << join->GetDropped() << " dropped, "
+                  << join->GetInFlight() << " still in flight at the end."
+                  << std::endl;
+    }
+    logs.Close(std::cout);
     Simulator::Destroy();
     NS_LOG_INFO("Done.");
 
@@ -9,58 +9,37 @@ import matplotlib as mpl
 from matplotlib.ticker import FormatStrFormatter
 import argparse
 
+from ntt_trace import read_queue_samples, read_trace_csv
+
+# Legacy display names of the packet csv columns, see read_trace_csv.
+PACKET_COLUMNS = {
+    "timestamp": "Timestamp",
+    "flowId": "Flow ID",
+    "uid": "Packet ID",
+    "size": "Packet Size",
+    "ipId": "IP ID",
+    "dscp": "DSCP",
+    "ecn": "ECN",
+    "ttl": "TTL",
+    "payloadSize": "Payload Size",
+    "protocol": "Proto",
+    "source": "Source IP",
+    "destination": "Destination IP",
+    "sourcePort": "TCP Source Port",
+    "destinationPort": "TCP Destination Port",
+    "sequence": "TCP Sequence Number",
+    "window": "TCP Window Size",
+    "delay": "Delay",
+    "workload": "Workload ID",
+    "application": "Application ID",
+    "message": "Message ID",
+}
+
 def generate_senders_csv(path, n_senders, file_list):
     path = path
     num_senders = n_senders
     sender_num = 0
 
-    df_sent_cols = [
-        "Timestamp",
-        "Flow ID",
-        "Packet ID",
-        "Packet Size",
-        "IP ID",
-        "DSCP",
-        "ECN",
-        "TTL",
-        "Payload Size",
-        "Proto",
-        "Source IP",
-        "Destination IP",
-        "TCP Source Port",
-        "TCP Destination Port",
-        "TCP Sequence Number",
-        "TCP Window Size",
-        "Delay",
-        "Workload ID",
-        "Application ID",
-        "Message ID",
-    ]
-
-    df_sent_cols_to_drop = [
-        0,
-        2,
-        4,
-        6,
-        8,
-        10,
-        12,
-        14,
-        16,
-        18,
-        20,
-        22,
-        24,
-        26,
-        28,
-        30,
-        32,
-        34,
-        36,
-        38,
-        40,
-    ]
-
     temp_cols = [
         "Timestamp",
         "Flow ID",
@@ -91,23 +70,9 @@ def generate_senders_csv(path, n_senders, file_list):
 
     for file in files:
 
-        sender_tx_df = pd.read_csv(path + file)
-        sender_tx_df = pd.DataFrame(np.vstack([sender_tx_df.columns, sender_tx_df]))
-        sender_tx_df.drop(
-            sender_tx_df.columns[df_sent_cols_to_drop], axis=1, inplace=True
-        )
-
-        sender_tx_df.columns = df_sent_cols
-        sender_tx_df["Packet ID"].iloc[0] = 0
-        sender_tx_df["Flow ID"].iloc[0] = sender_tx_df["Flow ID"].iloc[1]
-        sender_tx_df["IP ID"].iloc[0] = 0
-        sender_tx_df["DSCP"].iloc[0] = 0
-        sender_tx_df["ECN"].iloc[0] = 0
-        sender_tx_df["TCP Sequence Number"].iloc[0] = 0
-        # sender_tx_df["TTL"] = sender_tx_df.apply(lambda row: extract_TTL(row['Extra']), axis = 1)
-        # sender_tx_df["Proto"] = sender_tx_df.apply(lambda row: extract_protocol(row['Extra']), axis = 1)
+        sender_tx_df = read_trace_csv(path + file, list(PACKET_COLUMNS))
+        sender_tx_df = sender_tx_df.rename(columns=PACKET_COLUMNS)
         sender_tx_df["Flow ID"] = [sender_num for i in range(sender_tx_df.shape[0])]
-        sender_tx_df["Message ID"].iloc[0] = sender_tx_df["Message ID"].iloc[1]
 
         df_sent_cols_new = [
             "Timestamp",
@@ -182,22 +147,13 @@ def plot_queue(path,queueframe,queuesize=100):
 
 def configure_sender_csv(path, sender_list):
 
-    df = pd.read_csv(path + sender_list[0])
-    # Drop columns 1 and 3
-
-    df.drop(df.columns[[0, 2, 4, 6]], axis=1, inplace=True)
-
-    # Rename columns
-    df.columns = [
-        "Timestamp",
-        "Packet Size",
-        "Packet ID",
-        "TCP Sequence Number",
-        "Blank",
-    ]
-
-    # Drop the blank column
-    df.drop(df.columns[[-1]], axis=1, inplace=True)
+    df = read_trace_csv(path + sender_list[0], ["timestamp", "size", "uid", "sequence"])
+    df = df.rename(columns={
+        "timestamp": "Timestamp",
+        "size": "Packet Size",
+        "uid": "Packet ID",
+        "sequence": "TCP Sequence Number",
+    })
 
     # Save as final csv
     df.to_csv(path + sender_list[0].split(".")[0] + "_final.csv", index=False)
@@ -396,18 +352,22 @@ def main():
 
     
 
-    # Rename queue file
-    if not os.path.isfile(path+"queue.csv"):
-        os.rename(path+f"small_test_no_disturbance_with_message_ids{args.seed}_queues.csv", path+"queue.csv")
-    # Plot queue
-    queueframe = pd.read_csv(path + "queue.csv", names=["source", "time", "size"])
+    samples_file = path + f"small_test_no_disturbance_with_message_ids{args.seed}_queue_samples.npy"
+    if os.path.isfile(samples_file):
+        # Queue samples at fixed intervals (--queuesample)
+        queueframe = read_queue_samples(samples_file)
+    else:
+        # Rename queue file
+        if not os.path.isfile(path+"queue.csv"):
+            os.rename(path+f"small_test_no_disturbance_with_message_ids{args.seed}_queues.csv", path+"queue.csv")
+        # Plot queue
+        queueframe = read_trace_csv(path + "queue.csv")
     # plot_queue(path, queueframe, queuesize=100)
 
     # Rename drop file
     if not os.path.isfile(path+"drops.csv"):
         os.rename(path+f"small_test_no_disturbance_with_message_ids{args.seed}_drops.csv", path+"drops.csv")
-    dropframe = pd.read_csv(path+"drops.csv",
-                             names=["source", "time", "packetsize"])
+    dropframe = read_trace_csv(path+"drops.csv")
 
 
     print("Drop fraction:", len(dropframe) / (len(dropframe) + len(df)))